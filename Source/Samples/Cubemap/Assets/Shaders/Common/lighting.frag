@@ -105,8 +105,7 @@ vec3 PBRDirectIllumination(vec3 posToLightVec, vec3 lightColor, vec3 albedo, vec
 // so we need to transform them to world space. 
 // the x is the tangent length, the y is the bitangent length, and the z is the normal length
 vec3 sampleNormalMap(sampler2D normalMap, vec2 texCoord, vec3 inNormal, vec3 inTangent, vec3 inBitangent) {
-    vec3 mapN = texture(normalMap, texCoord).rgb;
-    mapN = mapN * 2.0 - 1.0;
+    vec3 mapN = sampleTangentNormal(normalMap, texCoord);
     vec3 T = normalize(inTangent);
     vec3 B = normalize(inBitangent);
     return normalize(T * mapN.x + B * mapN.y + inNormal * mapN.z);
@@ -1,11 +1,11 @@
 #version 450
 
-layout(push_constant) uniform pickPushConstants {
-    uint objectID;
-} pc;
+#include "common.glsl"
+
+layout(location = VulkShaderLocation_ObjectID) flat in uint inObjectID;
 
 layout(location = 0) out uint outObjectID;
 
 void main() {
-    outObjectID = pc.objectID;
-}
\ No newline at end of file
+    outObjectID = inObjectID;
+}
@@ -3,7 +3,7 @@
 #include "common.glsl"
 
 XFORMS_UBO(xform);
-MODELXFORM_UBO(modelUBO);
+INSTANCES_SSBO(instanceBuf);
 
 VERTEX_IN(inPosition, inNormal, inTangent, inTexCoord);
 
@@ -15,7 +15,7 @@ layout(location = VulkShaderLocation_TexCoord) out vec2 outTexCoord;
 // layout(location = VulkShaderLocation_CubemapCoord) out vec3 outCubemapCoord;
 
 void main() {
-    mat4 worldXform = xform.view * xform.world * modelUBO.xform;
+    mat4 worldXform = xform.view * xform.world * instanceBuf.instances[gl_InstanceIndex].xform;
     vec4 worldPos = worldXform * vec4(inPosition, 1.0);
     // outCubemapCoord = normalize(worldPos.xyz);
     gl_Position = xform.proj *  worldPos;
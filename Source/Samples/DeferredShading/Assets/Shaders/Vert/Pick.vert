@@ -0,0 +1,16 @@
+#version 450
+
+#include "common.glsl"
+
+XFORMS_UBO(xform);
+INSTANCES_SSBO(instanceBuf);
+
+layout(location = VulkShaderLocation_Pos) in vec3 inPosition;
+
+layout(location = VulkShaderLocation_ObjectID) flat out uint outObjectID;
+
+void main() {
+    Instance instance = instanceBuf.instances[gl_InstanceIndex];
+    gl_Position = xform.proj * xform.view * xform.world * instance.xform * vec4(inPosition, 1.0);
+    outObjectID = instance.pickID;
+}
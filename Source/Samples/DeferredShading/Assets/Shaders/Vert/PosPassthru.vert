@@ -3,11 +3,11 @@
 #include "common.glsl"
 
 XFORMS_UBO(xform);
-MODELXFORM_UBO(modelUBO);
+INSTANCES_SSBO(instanceBuf);
 
 layout(location = VulkShaderLocation_Pos) in vec3 inPosition;
 
 void main() {
-    mat4 worldXform = xform.world * modelUBO.xform;
+    mat4 worldXform = xform.world * instanceBuf.instances[gl_InstanceIndex].xform;
     gl_Position = xform.proj * xform.view * worldXform * vec4(inPosition, 1.0);
 }
\ No newline at end of file
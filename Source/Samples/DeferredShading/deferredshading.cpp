@@ -11,10 +11,14 @@ class World final : public VulkRenderable {
 
     std::shared_ptr<const vulk::VulkDeferredRenderpass> deferredRenderpass;
     std::vector<std::shared_ptr<const VulkActor>> deferredActors;
+    std::vector<VulkActorBatch> deferredBatches;
+    VulkDrawList deferredDraws;  // rebuilt every frame as the depths change
     std::shared_ptr<const VulkFence> deferredFence;
 
     std::shared_ptr<const VulkDepthRenderpass> shadowMapRenderpass;
     std::vector<std::shared_ptr<const VulkActor>> shadowMapActors;
+    std::vector<VulkActorBatch> shadowMapBatches;
+    VulkDrawList shadowMapDraws;
     std::shared_ptr<const VulkPipeline> shadowMapPipeline;
     std::shared_ptr<const VulkFence> shadowMapFence;
 
@@ -26,21 +30,28 @@ class World final : public VulkRenderable {
 
     std::shared_ptr<VulkPickRenderpass> pickRenderpass;
     std::vector<std::shared_ptr<const VulkActor>> pickActors;
+    std::vector<VulkActorBatch> pickBatches;
+    VulkDrawList pickDraws;
     std::shared_ptr<const VulkPipeline> pickPipeline;
 
     std::shared_ptr<const VulkActor> axesActor;
     std::shared_ptr<const VulkPipeline> axesPipeline;
 
+    VulkDrawList::Stats drawStats;  // this frame's, over all the draw lists
+    VulkParallelRecorder recorder;
+    bool recordInParallel = false;  // debug.parallelRecording as of the start of this frame
+
     struct Debug {
-        bool renderNormals   = false;
-        bool renderTangents  = false;
-        bool renderWireframe = false;
+        bool renderNormals     = false;
+        bool renderTangents    = false;
+        bool renderWireframe   = false;
+        bool parallelRecording = false;
     } debug;
 
     std::shared_ptr<spdlog::logger> logger;
 
    public:
-    World(Vulk& vk, std::string projFile) : vk(vk) {
+    World(Vulk& vk, std::string projFile) : vk(vk), recorder(vk) {
         logger = VulkLogger::CreateLogger(std::filesystem::path(projFile).stem().string());
         vulk::cpp2::ProjectDef projDef;
         logger->info("loading project file: {}", projFile);
@@ -49,9 +60,18 @@ class World final : public VulkRenderable {
         std::shared_ptr<VulkResources> resources = VulkResources::loadFromProject(vk, projFile);
 
         shadowMapRenderpass = std::make_shared<VulkDepthRenderpass>(vk);
+        pickRenderpass      = std::make_shared<VulkPickRenderpass>(vk);
+
+        // get the scene and the pipelines loading in parallel before waiting on any of them
+        auto sceneFuture             = resources->loadSceneAsync(sceneName, shadowMapRenderpass->depthViews);
+        auto pickPipelineFuture      = resources->loadPipelineAsync(pickRenderpass->renderPass, vk.swapChainExtent, "Pick");
+        auto wireframePipelineFuture = resources->loadPipelineAsync(vk.renderPass, vk.swapChainExtent, "Wireframe");
+        auto axesPipelineFuture      = resources->loadPipelineAsync(vk.renderPass, vk.swapChainExtent, "DebugAxes");
+        auto shadowMapPipelineFuture =
+            resources->loadPipelineAsync(shadowMapRenderpass->renderPass, shadowMapRenderpass->extent, "ShadowMap");
 
         // set up the scene for deferred rendering
-        scene              = resources->loadScene(sceneName, shadowMapRenderpass->depthViews);
+        scene              = sceneFuture.get();
         deferredRenderpass = std::make_shared<vulk::VulkDeferredRenderpass>(vk, *resources, *scene);
         for (size_t i = 0; i < scene->def->actors.size(); ++i) {
             auto actorDef = scene->def->actors[i];
@@ -60,21 +80,34 @@ class World final : public VulkRenderable {
                                                                         scene.get(),
                                                                         deferredRenderpass.get()));
         }
+        deferredBatches = VulkActorBatch::batchActors(deferredActors);
 
         shadowMapFence    = std::make_shared<VulkFence>(vk);
-        shadowMapPipeline = resources->loadPipeline(shadowMapRenderpass->renderPass, shadowMapRenderpass->extent, "ShadowMap");
+        shadowMapPipeline = shadowMapPipelineFuture.get();
         auto shadowMapPipelineDef = resources->metadata->pipelines.at("ShadowMap");
         for (size_t i = 0; i < scene->def->actors.size(); ++i) {
             auto actorDef = scene->def->actors[i];
             shadowMapActors.push_back(resources->createActorFromPipeline(*actorDef, shadowMapPipeline, scene.get(), nullptr));
         }
+        shadowMapBatches = VulkActorBatch::batchActors(shadowMapActors);
+        for (auto& batch : shadowMapBatches) {
+            shadowMapDraws.add(batch);
+        }
 
-        pickRenderpass = std::make_shared<VulkPickRenderpass>(vk);
-        pickPipeline   = resources->loadPipeline(pickRenderpass->renderPass, vk.swapChainExtent, "Pick");
+        pickPipeline = pickPipelineFuture.get();
         for (size_t i = 0; i < scene->def->actors.size(); ++i) {
             auto actorDef = scene->def->actors[i];
             pickActors.push_back(resources->createActorFromPipeline(*actorDef, pickPipeline, scene.get(), nullptr));
         }
+        pickBatches = VulkActorBatch::batchActors(pickActors);
+        for (auto& batch : pickBatches) {
+            pickDraws.add(batch);
+        }
+        logger->info("{} actors in {} deferred, {} shadow map and {} pick draws",
+                     scene->def->actors.size(),
+                     deferredBatches.size(),
+                     shadowMapBatches.size(),
+                     pickBatches.size());
 
         // ========================================================================================================
         // Debug stuff
@@ -85,7 +118,7 @@ class World final : public VulkRenderable {
         pbrDebugUBO.diffuse          = 1;
         pbrDebugUBO.specular         = 1;
 
-        wireframePipeline = resources->loadPipeline(vk.renderPass, vk.swapChainExtent, "Wireframe");
+        wireframePipeline = wireframePipelineFuture.get();
         for (size_t i = 0; i < scene->def->actors.size(); ++i) {
             auto actorDef = scene->def->actors[i];
             debugWireframeActors.push_back(
@@ -96,7 +129,7 @@ class World final : public VulkRenderable {
         std::shared_ptr<VulkMesh> axesMesh = std::make_shared<VulkMesh>();
         makeAxes(1.0f, *axesMesh);
         // VulkSceneUBOs::XformsUBO& axesUBO = *scene->sceneUBOs.xforms;
-        axesPipeline = resources->loadPipeline(vk.renderPass, vk.swapChainExtent, "DebugAxes");
+        axesPipeline = axesPipelineFuture.get();
 
         std::vector<vulk::cpp2::VulkShaderLocation> const axesInputs = {
             vulk::cpp2::VulkShaderLocation::Pos,
@@ -163,6 +196,17 @@ class World final : public VulkRenderable {
 
         std::shared_ptr<VulkImageView> depthView = shadowMapRenderpass->depthViews[vk.currentFrame]->depthView;
 
+        // depth only orders draws that share all their state, nearest first so early z rejects more. a batch's depth
+        // is its first instance's
+        glm::mat4 viewWorld = ubo.view * ubo.world;
+        deferredDraws.clear();
+        for (auto& batch : deferredBatches) {
+            glm::vec4 pos = viewWorld * scene->instances->ptrs[vk.currentFrame][batch.firstInstance].xform[3];
+            deferredDraws.add(batch, 0, (-pos.z - nearClip) / (farClip - nearClip));
+        }
+
+        drawStats        = {};
+        recordInParallel = debug.parallelRecording;
         renderPickBuffer(commandBuffer);
         renderShadowMapImageForLight(commandBuffer);
         vk.transitionImageLayout(commandBuffer,
@@ -178,6 +222,24 @@ class World final : public VulkRenderable {
                                  VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
     }
 
+    VkSubpassContents drawListContents() const {
+        return recordInParallel ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE;
+    }
+
+    // inline, or split across the recorder's threads in which case the subpass has to be begun with drawListContents()
+    void recordDraws(VkCommandBuffer commandBuffer,
+                     VulkDrawList& draws,
+                     VkRenderPass renderPass,
+                     VkFramebuffer framebuffer,
+                     VkExtent2D extent) {
+        if (recordInParallel) {
+            drawStats += recorder.record(commandBuffer, draws, renderPass, 0, framebuffer, extent);
+        } else {
+            draws.record(commandBuffer, vk.currentFrame);
+            drawStats += draws.getStats();
+        }
+    }
+
     void renderPickBuffer(VkCommandBuffer commandBuffer) {
         VkRenderPassBeginInfo renderPassBeginInfo{};
         renderPassBeginInfo.sType             = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -193,24 +255,13 @@ class World final : public VulkRenderable {
         renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassBeginInfo.pClearValues    = clearValues.data();
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-        for (uint32_t i = 0; i < pickActors.size(); ++i) {
-            auto& actor   = pickActors[i];
-            auto& model   = actor->model;
-            uint32_t data = i + 1;
-            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pickPipeline->pipeline);
-            vkCmdPushConstants(commandBuffer, pickPipeline->pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(data), &data);
-            vkCmdBindDescriptorSets(commandBuffer,
-                                    VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                    pickPipeline->pipelineLayout,
-                                    0,
-                                    1,
-                                    &actor->dsInfo->descriptorSets[vk.currentFrame]->descriptorSet,
-                                    0,
-                                    nullptr);
-            model->bindInputBuffers(commandBuffer);
-            vkCmdDrawIndexed(commandBuffer, model->numIndices, 1, 0, 0, 0);
-        }
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, drawListContents());
+        // the pick ids come from the scene's instances, see VulkResources::loadSceneAsync
+        recordDraws(commandBuffer,
+                    pickDraws,
+                    pickRenderpass->renderPass,
+                    pickRenderpass->frameBuffers[vk.currentFrame],
+                    vk.swapChainExtent);
 
         vkCmdEndRenderPass(commandBuffer);
     }
@@ -233,41 +284,23 @@ class World final : public VulkRenderable {
         renderPassBeginInfo.clearValueCount       = 1;
         renderPassBeginInfo.pClearValues          = &clearValue;
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-        for (auto& actor : shadowMapActors) {
-            auto model = actor->model;
-            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, actor->pipeline->pipeline);
-            vkCmdBindDescriptorSets(commandBuffer,
-                                    VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                    actor->pipeline->pipelineLayout,
-                                    0,
-                                    1,
-                                    &actor->dsInfo->descriptorSets[vk.currentFrame]->descriptorSet,
-                                    0,
-                                    nullptr);
-            model->bindInputBuffers(commandBuffer);
-            vkCmdDrawIndexed(commandBuffer, model->numIndices, 1, 0, 0, 0);
-        }
+        vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, drawListContents());
+        recordDraws(commandBuffer,
+                    shadowMapDraws,
+                    shadowMapRenderpass->renderPass,
+                    shadowMapRenderpass->frameBuffers[vk.currentFrame],
+                    shadowMapRenderpass->extent);
         vkCmdEndRenderPass(commandBuffer);
     }
 
     void drawMainStuff(VkCommandBuffer commandBuffer) {
-        deferredRenderpass->beginRenderToGBufs(commandBuffer);
-
-        for (auto& actor : deferredActors) {
-            auto model = actor->model;
-            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, actor->pipeline->pipeline);
-            vkCmdBindDescriptorSets(commandBuffer,
-                                    VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                    actor->pipeline->pipelineLayout,
-                                    0,
-                                    1,
-                                    &actor->dsInfo->descriptorSets[vk.currentFrame]->descriptorSet,
-                                    0,
-                                    nullptr);
-            model->bindInputBuffers(commandBuffer);
-            vkCmdDrawIndexed(commandBuffer, model->numIndices, 1, 0, 0, 0);
-        }
+        deferredRenderpass->beginRenderToGBufs(commandBuffer, drawListContents());
+
+        recordDraws(commandBuffer,
+                    deferredDraws,
+                    deferredRenderpass->renderPass,
+                    deferredRenderpass->frameBuffers[vk.swapChainImageIndex],
+                    vk.swapChainExtent);
 
         deferredRenderpass->renderGBufsAndEnd(commandBuffer);
     }
@@ -293,16 +326,9 @@ class World final : public VulkRenderable {
             for (auto& actor : debugWireframeActors) {
                 auto model = actor->model;
                 vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, wireframePipeline->pipeline);
-                vkCmdBindDescriptorSets(commandBuffer,
-                                        VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                        wireframePipeline->pipelineLayout,
-                                        0,
-                                        1,
-                                        &actor->dsInfo->descriptorSets[vk.currentFrame]->descriptorSet,
-                                        0,
-                                        nullptr);
+                actor->dsInfo->bind(commandBuffer, wireframePipeline->pipelineLayout, vk.currentFrame);
                 model->bindInputBuffers(commandBuffer);
-                vkCmdDrawIndexed(commandBuffer, model->numIndices, 1, 0, 0, 0);
+                model->draw(commandBuffer);
             }
         }
 
@@ -312,14 +338,7 @@ class World final : public VulkRenderable {
             for (auto& actor : debugNormalsActors) {
                 auto model = actor->model;
                 vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, actor->pipeline->pipeline);
-                vkCmdBindDescriptorSets(commandBuffer,
-                                        VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                        actor->pipeline->pipelineLayout,
-                                        0,
-                                        1,
-                                        &actor->dsInfo->descriptorSets[vk.currentFrame]->descriptorSet,
-                                        0,
-                                        nullptr);
+                actor->dsInfo->bind(commandBuffer, actor->pipeline->pipelineLayout, vk.currentFrame);
 
                 model->bindInputBuffers(commandBuffer);
                 vkCmdDraw(commandBuffer, model->numVertices, 1, 0, 0);
@@ -332,14 +351,7 @@ class World final : public VulkRenderable {
             for (auto& actor : debugTangentsActors) {
                 auto model = actor->model;
                 vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, actor->pipeline->pipeline);
-                vkCmdBindDescriptorSets(commandBuffer,
-                                        VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                        actor->pipeline->pipelineLayout,
-                                        0,
-                                        1,
-                                        &actor->dsInfo->descriptorSets[vk.currentFrame]->descriptorSet,
-                                        0,
-                                        nullptr);
+                actor->dsInfo->bind(commandBuffer, actor->pipeline->pipelineLayout, vk.currentFrame);
 
                 model->bindInputBuffers(commandBuffer);
                 vkCmdDraw(commandBuffer, model->numVertices, 1, 0, 0);
@@ -348,17 +360,10 @@ class World final : public VulkRenderable {
 
         // draw the axes
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, axesPipeline->pipeline);
-        vkCmdBindDescriptorSets(commandBuffer,
-                                VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                axesPipeline->pipelineLayout,
-                                0,
-                                1,
-                                &axesActor->dsInfo->descriptorSets[vk.currentFrame]->descriptorSet,
-                                0,
-                                nullptr);
+        axesActor->dsInfo->bind(commandBuffer, axesPipeline->pipelineLayout, vk.currentFrame);
 
         axesActor->model->bindInputBuffers(commandBuffer);
-        vkCmdDrawIndexed(commandBuffer, axesActor->model->numIndices, 1, 0, 0, 0);
+        axesActor->model->draw(commandBuffer);
 
         vkCmdEndRenderPass(commandBuffer);
     }
@@ -462,6 +467,7 @@ class World final : public VulkRenderable {
             ImGui::Checkbox("Render Normals", &debug.renderNormals);
             ImGui::Checkbox("Render Tangents", &debug.renderTangents);
             ImGui::Checkbox("Render Wireframe", &debug.renderWireframe);
+            ImGui::Checkbox("Record Draws In Parallel", &debug.parallelRecording);
         }
 
         VulkPBRDebugUBO& pbrDebugUBO = *scene->pbrDebugUBO->mappedUBO;
@@ -476,6 +482,13 @@ class World final : public VulkRenderable {
         ImGui::Checkbox("Diffuse", (bool*)&pbrDebugUBO.diffuse);
         ImGui::Checkbox("Specular", (bool*)&pbrDebugUBO.specular);
 
+        ImGui::Text("Draws: %u, binds skipped: %u (pipelines %u, sets %u, vertex buffers %u)",
+                    drawStats.draws,
+                    drawStats.bindsSkipped(),
+                    drawStats.pipelineBindsSkipped,
+                    drawStats.descriptorSetBindsSkipped,
+                    drawStats.vertexBufferBindsSkipped);
+
         ImGui::Text("Camera");
         ImGui::InputFloat3("Eye", glm::value_ptr(scene->camera.eye));
         ImGui::InputFloat4("Rot", glm::value_ptr(scene->camera.orientation));
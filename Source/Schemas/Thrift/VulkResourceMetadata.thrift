@@ -15,6 +15,13 @@ enum VulkCullModeFlags {
     FRONT_AND_BACK = 3
 }
 
+// how VulkModel lays out its vertex buffers for a pipeline, see VulkVertexLayout.h
+enum VulkVertexLayoutType {
+    Separate = 0,    // a buffer per attribute, all 32 bit floats
+    Interleaved = 1, // one buffer, all 32 bit floats
+    Packed = 2,      // one buffer: float positions, snorm16 normals/tangents, half float uvs
+}
+
 struct PushConstantDef {
     1: i32 stageFlags; // or-ed together
     2: i32 size;
@@ -59,6 +66,7 @@ struct SrcPipelineDef {
     11: string cullMode; // VulkShaderEnums.VulkCullModeFlag/VkCullModeFlags
     12: list<PipelineBlendingDef> colorBlends;  
     13: i32 subpass;
+    14: string vertexLayout; // VulkVertexLayoutType
 }
 
 struct PipelineDef {
@@ -78,6 +86,7 @@ struct PipelineDef {
     14: VulkCullModeFlags cullMode = VulkCullModeFlags.BACK; // VkCullModeFlags
     15: list<PipelineBlendingDef> colorBlends;  
     16: i32 subpass;
+    17: VulkVertexLayoutType vertexLayout = VulkVertexLayoutType.Separate;
 }
 
 struct Vec3 {
@@ -206,4 +215,67 @@ struct ProjectDef {
     3: map<string, PipelineDef> pipelines;
     4: map<string, ModelDef> models;
     5: string startingScene;
-}
\ No newline at end of file
+}
+
+// BuildTool's record of how each shader was last compiled, see ShaderBuildCache.h
+struct ShaderBuildCacheEntry {
+    1: string hash; // of the source, everything it #includes and the compile options
+    2: list<string> includes; // resolved paths of every file it #includes, transitively
+}
+
+struct ShaderBuildCacheDef {
+    1: i32 version;
+    2: map<string, ShaderBuildCacheEntry> shaders; // keyed on the built shader's path
+}
+
+// BuildTool's record of each step of the last project build, see BuildGraph.h
+struct BuildGraphNodeDef {
+    1: string hash; // of all the inputs
+    2: map<string, string> inputs; // what the node was built from: files, values or other nodes -> their hash
+    3: list<string> outputs; // files the node wrote
+}
+
+struct BuildGraphDef {
+    1: i32 version;
+    2: map<string, BuildGraphNodeDef> nodes;
+}
+
+struct ShaderInfoBindingDef {
+    1: i32 binding; // or location
+    2: string name;
+}
+
+struct ShaderInfoInputAttachmentDef {
+    1: VulkShaderEnums.GBufBinding binding;
+    2: VulkShaderEnums.GBufInputAtmtIdx atmtIdx;
+    3: string name;
+}
+
+// BuildTool's reflection of a built shader, see ShaderInfo in BuildPipeline.h.
+// lists rather than maps so the bindings stay in the order spirv-cross reported them.
+struct ShaderInfoDef {
+    1: string entryPoint;
+    2: list<ShaderInfoBindingDef> uboBindings;
+    3: list<ShaderInfoBindingDef> sboBindings;
+    4: list<ShaderInfoBindingDef> samplerBindings;
+    5: list<ShaderInfoInputAttachmentDef> inputAttachments;
+    6: list<ShaderInfoBindingDef> inputLocations;
+    7: list<ShaderInfoBindingDef> outputLocations;
+    8: list<i32> pushConstants;
+}
+
+struct ShaderInfoCacheDef {
+    1: i32 version;
+    2: map<string, ShaderInfoDef> shaders; // keyed on the hash of the SPIR-V
+}
+
+// table of contents of a packed asset archive, see VulkAssetPack.h
+struct AssetPackEntryDef {
+    1: string path; // relative to the packed directory, with '/' separators
+    2: i64 offset;  // from the start of the archive
+    3: i64 size;
+}
+
+struct AssetPackDef {
+    1: list<AssetPackEntryDef> entries; // sorted by path
+}
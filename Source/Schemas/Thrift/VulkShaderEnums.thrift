@@ -13,6 +13,7 @@ enum VulkShaderLocation {
     PosLightSpace = 7,
     Bitangent = 8
     CubemapCoord = 9
+    ObjectID = 10
 }
 
 enum VulkShaderBinding {
@@ -43,6 +44,7 @@ enum VulkShaderBinding {
     GBufAlbedo = 24,
     GBufMaterial = 25,
     InvViewProjUBO = 27,
+    InstancesSSBO = 28,
 }
 
 // ================================================
@@ -98,7 +100,7 @@ enum VulkShaderDebugUBO {
 }
 
 enum VulkShaderSSBOBinding {
-    MaxBindingID = 0
+    Instances = 28,
 }
 
 enum VulkShaderTextureBinding {
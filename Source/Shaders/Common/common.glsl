@@ -31,9 +31,15 @@ mat3 calcTBNMat(vec3 normWorld, vec3 tangentWorld) {
     return mat3(T, B, N);
 }
 
+// the tangent space normal from a normal map. only x and y are read and z is rebuilt from them,
+// so it works for two channel (BC5) cooked normal maps as well as RGBA ones
+vec3 sampleTangentNormal(sampler2D normSampler, vec2 texCoord) {
+    vec2 xy = texture(normSampler, texCoord).xy * 2.0 - 1.0; // Remap from [0, 1] to [-1, 1]
+    return vec3(xy, sqrt(max(0.0, 1.0 - dot(xy, xy))));
+}
+
 vec3 calcTBNNormal(sampler2D normSampler, vec2 inTexCoord, vec3 normWorld, vec3 tangentWorld) {
-    vec3 norm = texture(normSampler, inTexCoord).xyz;
-    norm = normalize(norm * 2.0 - 1.0); // Remap from [0, 1] to [-1, 1]
+    vec3 norm = sampleTangentNormal(normSampler, inTexCoord);
     mat3 TBN = calcTBNMat(normWorld, tangentWorld);
     norm = normalize(TBN * norm);
     return norm;
@@ -83,6 +89,18 @@ layout(binding = Binding_ModelXform) uniform ModelXformUBO { \
     mat4 xform; \
 } modelUBO
 
+// per instance data for instanced draws, see VulkInstance
+struct Instance {
+    mat4 xform;
+    uint pickID;
+};
+
+// index with gl_InstanceIndex, which includes the draw's firstInstance
+#define INSTANCES_SSBO(instanceBuf)  \
+layout(std430, binding = Binding_InstancesSSBO) readonly buffer InstanceBuf { \
+    Instance instances[]; \
+} instanceBuf
+
 #define EYEPOS_UBO(eyePosUBO)  \
 layout(binding = Binding_EyePos) uniform EyePos { \
     vec3 eyePos; \
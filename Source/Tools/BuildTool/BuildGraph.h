@@ -0,0 +1,187 @@
+#pragma once
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Vulk/VulkHash.h"
+#include "Vulk/VulkLogger.h"
+#include "Vulk/VulkResourceMetadata.h"
+
+// Persistent dependency graph for project builds. Each step of the build is a node, named
+// like "pipeline:Foo" or "scene:Bar", whose inputs are:
+// - files, hashed by content so touching a file doesn't rebuild anything
+// - values, e.g. the build options that affect the output
+// - other nodes, by the hash of their inputs this run
+// A node is rebuilt when any input changed since it was last built or one of its outputs is
+// missing; with explain on it logs which. e.g. the project depends on its scenes and models
+// and pipelines depend on their built shaders, which ShaderBuildCache in turn tracks
+// against the shader sources and everything they #include.
+//
+// Thread safe, pipelines are built in parallel.
+class BuildGraph {
+    static std::shared_ptr<spdlog::logger> logger() {
+        static std::shared_ptr<spdlog::logger> logger;
+        static std::once_flag flag;
+        std::call_once(flag, []() { logger = VulkLogger::CreateLogger("BuildGraph"); });
+        return logger;
+    }
+
+   public:
+    // bump this to rebuild everything, e.g. if what a node's hash covers changes
+    static constexpr int32_t VERSION = 1;
+
+    class Inputs {
+       public:
+        Inputs& file(std::filesystem::path const& path) {
+            hashes["file:" + path.generic_string()] = graph->fileHash(path);
+            return *this;
+        }
+        Inputs& value(std::string const& name, std::string_view value) {
+            hashes["value:" + name] = VulkHasher().add(value).toString();
+            return *this;
+        }
+        // the node has to have been checked this run, i.e. build the graph from the leaves up
+        Inputs& node(std::string const& name) {
+            hashes["node:" + name] = graph->nodeHash(name);
+            return *this;
+        }
+
+        std::string hash() const {
+            VulkHasher hasher;
+            for (auto& [name, inputHash] : hashes) {
+                hasher.add(name).add(inputHash);
+            }
+            return hasher.toString();
+        }
+
+        std::map<std::string, std::string> hashes;  // sorted so the combined hash is stable
+
+       private:
+        friend class BuildGraph;
+        Inputs(BuildGraph* graph) : graph(graph) {}
+        BuildGraph* graph;
+    };
+
+    BuildGraph(std::filesystem::path graphFile, bool explain) : graphFile(graphFile), explain(explain) {
+        if (std::filesystem::exists(graphFile)) {
+            try {
+                readDefFromFile(graphFile.string(), def);
+            } catch (std::exception& e) {
+                logger()->warn("Ignoring unreadable build graph {}: {}", graphFile.string(), e.what());
+                def = {};
+            }
+            if (def.get_version() != VERSION) {
+                logger()->info("Build graph {} is version {}, rebuilding everything", graphFile.string(), def.get_version());
+                def = {};
+            }
+        }
+        def.version_ref() = VERSION;
+    }
+
+    Inputs inputs() {
+        return Inputs(this);
+    }
+
+    // true if the node needs to be built. if it is, call built() once it has been.
+    bool isOutOfDate(std::string const& node, Inputs const& inputs, std::vector<std::filesystem::path> const& outputs) {
+        std::string hash = inputs.hash();
+        std::lock_guard<std::mutex> lock(mutex);
+        nodeHashes[node] = hash;
+
+        std::string why;
+        auto it = def.get_nodes().find(node);
+        if (it == def.get_nodes().end()) {
+            why = "not built before";
+        } else if (it->second.get_hash() != hash) {
+            why = describeChanges(it->second.get_inputs(), inputs.hashes);
+        } else {
+            for (auto& output : outputs) {
+                if (!std::filesystem::exists(output)) {
+                    why = "output " + output.generic_string() + " is missing";
+                    break;
+                }
+            }
+        }
+
+        if (why.empty()) {
+            logger()->trace("{}: up to date", node);
+            return false;
+        }
+        if (explain) {
+            logger()->info("{}: rebuilding, {}", node, why);
+        } else {
+            logger()->trace("{}: rebuilding, {}", node, why);
+        }
+        return true;
+    }
+
+    void built(std::string const& node, Inputs const& inputs, std::vector<std::filesystem::path> const& outputs) {
+        vulk::cpp2::BuildGraphNodeDef nodeDef;
+        nodeDef.hash_ref()   = inputs.hash();
+        nodeDef.inputs_ref() = inputs.hashes;
+        for (auto& output : outputs) {
+            nodeDef.outputs_ref()->push_back(output.generic_string());
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        def.nodes_ref()[node] = std::move(nodeDef);
+    }
+
+    void save() {
+        std::lock_guard<std::mutex> lock(mutex);
+        writeDefToFile(graphFile.string(), def);
+    }
+
+   private:
+    std::filesystem::path graphFile;
+    bool explain;
+    vulk::cpp2::BuildGraphDef def;
+    std::unordered_map<std::string, std::string> nodeHashes;  // checked this run
+    std::unordered_map<std::string, std::string> fileHashes;  // files are often inputs to several nodes
+    std::mutex mutex;
+
+    std::string fileHash(std::filesystem::path const& path) {
+        std::string key = path.generic_string();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = fileHashes.find(key);
+            if (it != fileHashes.end()) {
+                return it->second;
+            }
+        }
+        std::string hash = std::filesystem::exists(path) ? VulkHasher::toString(VulkHasher::hashFile(path)) : "missing";
+        std::lock_guard<std::mutex> lock(mutex);
+        return fileHashes[key] = hash;
+    }
+
+    std::string nodeHash(std::string const& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = nodeHashes.find(name);
+        VULK_ASSERT(it != nodeHashes.end(), "BuildGraph: {} depends on a node that hasn't been checked yet", name);
+        return it->second;
+    }
+
+    template <typename OldInputs>
+    static std::string describeChanges(OldInputs const& oldInputs, std::map<std::string, std::string> const& newInputs) {
+        std::string why;
+        auto add = [&why](std::string const& s) { why += (why.empty() ? "" : ", ") + s; };
+        for (auto& [name, hash] : newInputs) {
+            auto it = oldInputs.find(name);
+            if (it == oldInputs.end()) {
+                add(name + " added");
+            } else if (it->second != hash) {
+                add(name + " changed");
+            }
+        }
+        for (auto& [name, hash] : oldInputs) {
+            if (!newInputs.contains(name)) {
+                add(name + " removed");
+            }
+        }
+        return why.empty() ? "hash changed" : why;
+    }
+};
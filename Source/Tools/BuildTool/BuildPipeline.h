@@ -8,6 +8,7 @@
 #include <vector>
 #include "spirv_cross/spirv_glsl.hpp"
 
+#include "ShaderInfoCache.h"
 #include "Vulk/VulkResourceMetadata.h"
 
 struct ShaderInfo {
@@ -26,6 +27,10 @@ struct ShaderInfo {
     std::vector<uint32_t> pushConstants;  // bitfield of vulk::cpp2::VulkShaderStage
 };
 
+// SPIR-V that's already in memory, keyed on the built shader's path (lexically normalized).
+// e.g. shaders compiled in process this run, so reflection doesn't re-read them from disk.
+using BuiltSpirv = std::unordered_map<std::string, std::vector<uint32_t>>;
+
 class PipelineBuilder {
     static std::shared_ptr<spdlog::logger> logger() {
         static std::shared_ptr<spdlog::logger> logger;
@@ -40,14 +45,60 @@ class PipelineBuilder {
    public:
 #pragma warning(push)
 #pragma warning(disable : 6262)  // Function uses '18964' bytes of stack. - the SPIRV structs are big, not a problem.
-    static ShaderInfo getShaderInfo(std::filesystem::path shaderPath) {
-        auto spirvData = readSPIRVFile(shaderPath);
-        spirv_cross::CompilerGLSL glsl(std::move(spirvData));
-        const spirv_cross::ShaderResources resources = glsl.get_shader_resources();
+    static ShaderInfo getShaderInfo(std::filesystem::path shaderPath, ShaderInfoCache* shaderInfoCache = nullptr) {
+        return getShaderInfo(shaderPath.stem().string(), readSPIRVFile(shaderPath), shaderInfoCache);
+    }
+
+    // reflection is memoized by SPIR-V content in shaderInfoCache, if there is one
+    static ShaderInfo getShaderInfo(std::string name,
+                                    std::vector<uint32_t> const& spirvData,
+                                    ShaderInfoCache* shaderInfoCache = nullptr) {
+        vulk::cpp2::ShaderInfoDef def =
+            shaderInfoCache ? shaderInfoCache->get(spirvData, reflectShader) : reflectShader(spirvData);
 
         ShaderInfo parsedShader;
-        parsedShader.name       = shaderPath.stem().string();
-        parsedShader.entryPoint = glsl.get_entry_points_and_stages()[0].name;
+        parsedShader.name       = name;
+        parsedShader.entryPoint = def.get_entryPoint();
+        for (auto& b : def.get_uboBindings()) {
+            parsedShader.uboBindings[(vulk::cpp2::VulkShaderUBOBinding)b.get_binding()] = b.get_name();
+        }
+        for (auto& b : def.get_sboBindings()) {
+            parsedShader.sboBindings[(vulk::cpp2::VulkShaderSSBOBinding)b.get_binding()] = b.get_name();
+        }
+        for (auto& b : def.get_samplerBindings()) {
+            parsedShader.samplerBindings[(vulk::cpp2::VulkShaderTextureBinding)b.get_binding()] = b.get_name();
+        }
+        for (auto& ia : def.get_inputAttachments()) {
+            parsedShader.inputAttachments[ia.get_binding()].name    = ia.get_name();
+            parsedShader.inputAttachments[ia.get_binding()].atmtIdx = ia.get_atmtIdx();
+        }
+        for (auto& b : def.get_inputLocations()) {
+            parsedShader.inputLocations[(vulk::cpp2::VulkShaderLocation)b.get_binding()] = b.get_name();
+        }
+        for (auto& b : def.get_outputLocations()) {
+            parsedShader.outputLocations[(vulk::cpp2::VulkShaderLocation)b.get_binding()] = b.get_name();
+        }
+        for (int32_t size : def.get_pushConstants()) {
+            parsedShader.pushConstants.push_back((uint32_t)size);
+        }
+        return parsedShader;
+    }
+
+   private:
+    // the bindings are kept in the order spirv-cross reports them, and getShaderInfo inserts them in
+    // that order, so cached and freshly reflected shaders build identical pipelines.
+    static vulk::cpp2::ShaderInfoDef reflectShader(std::vector<uint32_t> const& spirvData) {
+        spirv_cross::CompilerGLSL glsl(spirvData);
+        const spirv_cross::ShaderResources resources = glsl.get_shader_resources();
+
+        vulk::cpp2::ShaderInfoDef parsedShader;
+        parsedShader.entryPoint_ref() = glsl.get_entry_points_and_stages()[0].name;
+        auto addBinding = [](std::vector<vulk::cpp2::ShaderInfoBindingDef>& bindings, uint32_t binding, std::string name) {
+            vulk::cpp2::ShaderInfoBindingDef def;
+            def.binding_ref() = (int32_t)binding;
+            def.name_ref()    = name;
+            bindings.push_back(def);
+        };
 
         // vulk::cpp2::VulkShaderStage shaderStage;
         // switch (glsl.get_execution_model()) {
@@ -85,23 +136,20 @@ class PipelineBuilder {
             vulk::cpp2::VulkShaderUBOBinding binding =
                 enumFromInt<vulk::cpp2::VulkShaderUBOBinding>(glsl.get_decoration(resource.id, spv::DecorationBinding));
 
-            parsedShader.uboBindings[binding] = resource.name;
+            addBinding(*parsedShader.uboBindings_ref(), (uint32_t)binding, resource.name);
         }
 
         // For SBOs
         for (const spirv_cross::Resource& resource : resources.storage_buffers) {
             // unsigned set = glsl.get_decoration(resource.id, spv::DecorationDescriptorSet);
-            vulk::cpp2::VulkShaderSSBOBinding binding =
-                (vulk::cpp2::VulkShaderSSBOBinding)glsl.get_decoration(resource.id, spv::DecorationBinding);
-            parsedShader.sboBindings[binding] = resource.name;
+            addBinding(*parsedShader.sboBindings_ref(), glsl.get_decoration(resource.id, spv::DecorationBinding), resource.name);
         }
 
         // For Samplers
         for (const spirv_cross::Resource& resource : resources.sampled_images) {
             // unsigned set = glsl.get_decoration(resource.id, spv::DecorationDescriptorSet);
-            vulk::cpp2::VulkShaderTextureBinding binding =
-                (vulk::cpp2::VulkShaderTextureBinding)glsl.get_decoration(resource.id, spv::DecorationBinding);
-            parsedShader.samplerBindings[binding] = resource.name;
+            addBinding(
+                *parsedShader.samplerBindings_ref(), glsl.get_decoration(resource.id, spv::DecorationBinding), resource.name);
         }
 
         // For input attachments
@@ -110,22 +158,23 @@ class PipelineBuilder {
             vulk::cpp2::GBufInputAtmtIdx atmtIdx =
                 (vulk::cpp2::GBufInputAtmtIdx)glsl.get_decoration(resource.id, spv::DecorationInputAttachmentIndex);
             vulk::cpp2::GBufBinding binding = (vulk::cpp2::GBufBinding)glsl.get_decoration(resource.id, spv::DecorationBinding);
-            parsedShader.inputAttachments[binding].name    = resource.name;
-            parsedShader.inputAttachments[binding].atmtIdx = atmtIdx;
+            vulk::cpp2::ShaderInfoInputAttachmentDef ia;
+            ia.binding_ref() = binding;
+            ia.atmtIdx_ref() = atmtIdx;
+            ia.name_ref()    = resource.name;
+            parsedShader.inputAttachments_ref()->push_back(ia);
         }
 
         // Inputs
         for (const spirv_cross::Resource& resource : resources.stage_inputs) {
-            vulk::cpp2::VulkShaderLocation location =
-                (vulk::cpp2::VulkShaderLocation)glsl.get_decoration(resource.id, spv::DecorationLocation);
-            parsedShader.inputLocations[location] = resource.name;
+            addBinding(
+                *parsedShader.inputLocations_ref(), glsl.get_decoration(resource.id, spv::DecorationLocation), resource.name);
         }
 
         // Outputs
         for (const spirv_cross::Resource& resource : resources.stage_outputs) {
-            vulk::cpp2::VulkShaderLocation location =
-                (vulk::cpp2::VulkShaderLocation)glsl.get_decoration(resource.id, spv::DecorationLocation);
-            parsedShader.outputLocations[location] = resource.name;
+            addBinding(
+                *parsedShader.outputLocations_ref(), glsl.get_decoration(resource.id, spv::DecorationLocation), resource.name);
         }
 
         // Push constants
@@ -141,14 +190,16 @@ class PipelineBuilder {
             logger()->trace("Push constant buffer: name={}, size={}, location={}", resource.name, size, location);
             VULK_ASSERT(location < 32,
                         "Push constant location is too large");  // no idea what the max may eventually be but this isn't crazy
-            if (parsedShader.pushConstants.size() <= location) {
-                parsedShader.pushConstants.resize(location + 1);
+            if (parsedShader.get_pushConstants().size() <= location) {
+                parsedShader.pushConstants_ref()->resize(location + 1);
             }
-            parsedShader.pushConstants[location] = size;
+            parsedShader.pushConstants_ref()[location] = (int32_t)size;
         }
 
         return parsedShader;
     }
+
+   public:
 #pragma warning(pop)
     static bool checkConnections(ShaderInfo& upstream, ShaderInfo& downstream, std::string& errMsg) {
         errMsg = "";
@@ -168,8 +219,19 @@ class PipelineBuilder {
         return errMsg.empty();
     }
 
-    static ShaderInfo infoFromShader(std::string name, std::string type, std::filesystem::path shadersDir) {
-        return getShaderInfo(shadersDir / type / (name + "." + type + "spv"));
+    static ShaderInfo infoFromShader(std::string name,
+                                     std::string type,
+                                     std::filesystem::path shadersDir,
+                                     BuiltSpirv const* builtSpirv     = nullptr,
+                                     ShaderInfoCache* shaderInfoCache = nullptr) {
+        std::filesystem::path shaderPath = shadersDir / type / (name + "." + type + "spv");
+        if (builtSpirv) {
+            auto it = builtSpirv->find(shaderPath.lexically_normal().string());
+            if (it != builtSpirv->end()) {
+                return getShaderInfo(shaderPath.stem().string(), it->second, shaderInfoCache);
+            }
+        }
+        return getShaderInfo(shaderPath, shaderInfoCache);
     }
 
     static VkShaderStageFlagBits getShaderStageFromStr(std::string s) {
@@ -224,7 +286,10 @@ class PipelineBuilder {
         }
     }
 
-    static vulk::cpp2::PipelineDef buildPipeline(vulk::cpp2::SrcPipelineDef pipelineIn, std::filesystem::path builtShadersDir) {
+    static vulk::cpp2::PipelineDef buildPipeline(vulk::cpp2::SrcPipelineDef pipelineIn,
+                                                 std::filesystem::path builtShadersDir,
+                                                 BuiltSpirv const* builtSpirv     = nullptr,
+                                                 ShaderInfoCache* shaderInfoCache = nullptr) {
         if (!std::filesystem::exists(builtShadersDir)) {
             std::cerr << "Shaders directory does not exist: " << builtShadersDir << std::endl;
             VULK_THROW("PipelineBuilder: Shaders directory does not exist");
@@ -276,21 +341,30 @@ class PipelineBuilder {
         if (pipelineIn.subpass().is_set()) {
             pipelineOut.subpass_ref() = pipelineIn.get_subpass();
         }
+        if (pipelineIn.vertexLayout().is_set()) {
+            VULK_ASSERT(
+                apache::thrift::util::tryParseEnum(pipelineIn.get_vertexLayout(), &pipelineOut.vertexLayout_ref().value()),
+                "Invalid vertexLayout value {}",
+                pipelineIn.get_vertexLayout());
+        }
         // assert(sizeof(pipelineIn) == 440);
-        static_assert(sizeof(pipelineIn) == 392);
+        static_assert(sizeof(pipelineIn) == 424);
 
         std::vector<ShaderInfo> shaderInfos;
-        ShaderInfo vertShaderInfo = infoFromShader(pipelineIn.get_vertShader(), "vert", builtShadersDir);
+        ShaderInfo vertShaderInfo =
+            infoFromShader(pipelineIn.get_vertShader(), "vert", builtShadersDir, builtSpirv, shaderInfoCache);
         shaderInfos.push_back(vertShaderInfo);
         updatePipelineDef(vertShaderInfo, "vert", pipelineOut);
 
         if (!pipelineIn.get_geomShader().empty()) {
-            ShaderInfo info = infoFromShader(pipelineIn.get_geomShader(), "geom", builtShadersDir);
+            ShaderInfo info =
+                infoFromShader(pipelineIn.get_geomShader(), "geom", builtShadersDir, builtSpirv, shaderInfoCache);
             shaderInfos.push_back(info);
             updatePipelineDef(info, "geom", pipelineOut);
         }
         if (!pipelineIn.get_fragShader().empty()) {
-            ShaderInfo info = infoFromShader(pipelineIn.get_fragShader(), "frag", builtShadersDir);
+            ShaderInfo info =
+                infoFromShader(pipelineIn.get_fragShader(), "frag", builtShadersDir, builtSpirv, shaderInfoCache);
             shaderInfos.push_back(info);
             updatePipelineDef(info, "frag", pipelineOut);
         }
@@ -316,7 +390,10 @@ class PipelineBuilder {
 
     static void buildPipelineFile(vulk::cpp2::SrcPipelineDef pipelineIn,
                                   std::filesystem::path builtShadersDir,
-                                  std::filesystem::path pipelineFileOut) {
+                                  std::filesystem::path pipelineFileOut,
+                                  BuiltSpirv const* builtSpirv     = nullptr,
+                                  ShaderInfoCache* shaderInfoCache = nullptr,
+                                  VulkDefFormat outputFormat       = VulkDefFormat::Json) {
         if (!std::filesystem::exists(builtShadersDir)) {
             std::cerr << "Shaders directory does not exist: " << builtShadersDir << std::endl;
             VULK_THROW("PipelineBuilder: Shaders directory does not exist");
@@ -325,8 +402,8 @@ class PipelineBuilder {
             VULK_ASSERT(fs::create_directories(pipelineFileOut.parent_path()));
         }
 
-        vulk::cpp2::PipelineDef pipelineOut = buildPipeline(pipelineIn, builtShadersDir);
-        writeDefToFile(pipelineFileOut.string(), pipelineOut);
+        vulk::cpp2::PipelineDef pipelineOut = buildPipeline(pipelineIn, builtShadersDir, builtSpirv, shaderInfoCache);
+        writeDefToFile(pipelineFileOut.string(), pipelineOut, outputFormat);
     }
 
     static void buildPipelineFromFile(std::filesystem::path builtShadersDir,
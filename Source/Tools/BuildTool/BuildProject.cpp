@@ -1,12 +1,27 @@
 #define _WIN32_WINNT 0x0A00  // for boost
 #include <boost/filesystem.hpp>
 #include <boost/process.hpp>
+#include <atomic>
 #include <filesystem>
+#include <functional>
 #include <iostream>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <string_view>
+#include <thread>
 
+#include "BuildGraph.h"
 #include "BuildPipeline.h"
+#include "BuildProject.h"
+#include "ShaderBuildCache.h"
+#include "Vulk/VulkAssetPack.h"
+#include "Vulk/VulkCookedTexture.h"
 #include "Vulk/VulkLogger.h"
+#include "Vulk/VulkMesh.h"
+#include "Vulk/VulkMeshOptimizer.h"
 #include "Vulk/VulkUtil.h"
 
 static std::shared_ptr<spdlog::logger> logger = VulkLogger::CreateLogger("BuildProject");
@@ -50,7 +65,9 @@ void glslShaderEnumsGenerator(fs::path outFile, bool verbose) {
     }
     // logger->set_level(spdlog::level::trace);
 
-    std::ofstream out(outFile);
+    // generated in memory and only written if it changed so the file's timestamp doesn't
+    // make anything that includes it look out of date
+    std::ostringstream out;
     out << R"(
 // Generated header file for enum values coming from our headers
 // e.g. UBO bindings, or layout locations
@@ -96,7 +113,17 @@ void glslShaderEnumsGenerator(fs::path outFile, bool verbose) {
 
     out << "\n";
 
-    out.close();
+    std::string contents = out.str();
+    if (fs::exists(outFile)) {
+        std::vector<char> existing = readFileIntoMem(outFile.string());
+        if (std::string_view(existing.data(), existing.size()) == contents) {
+            logger->trace("GLSLIncludesGenerator: {} is unchanged", outFile.string());
+            return;
+        }
+    }
+    std::ofstream ofs(outFile, std::ios::binary);
+    VULK_ASSERT(ofs.is_open(), "Could not open file for writing: {}", outFile.string());
+    ofs << contents;
 
     // // throw CLI::Success(); // not really necessary
 }
@@ -156,134 +183,366 @@ void findSrcMetadata(const fs::path path, SrcMetadata& metadata) {
     VULK_ASSERT(metadata.scenes.size() > 0, "No scenes found in {}", path.string());
 }
 
-static bool shouldCopyFile(fs::path src, fs::path dst) {
-    // Check if both files exist
-    VULK_ASSERT(fs::exists(src) && fs::is_regular_file(src), "src File {} does not exist", src.string());
-    if (!fs::exists(dst)) {
-        logger->trace("dst File {} does not exist", dst.string());
-        return true;
-    }
-    VULK_ASSERT(fs::is_regular_file(dst), "dst File {} is not a regular file", dst.string());
-    // Get the last modification time of the source and destination files
-    auto srcTime = fs::last_write_time(src);
-    auto dstTime = fs::last_write_time(dst);
-    // Return true if the source file is newer than the destination file
-    return srcTime > dstTime;
-}
-
-// copies a file if it should be copied
+// copies src to dst if src changed since the last build or dst is missing.
 // also creates the parent directory if it doesn't exist
-static void copyFileIfShould(fs::path src, fs::path dst) {
-    if (shouldCopyFile(src, dst)) {
-        logger->info("Copying file: {} to {}", src.string(), dst.string());
-        VULK_ASSERT(fs::exists(dst.parent_path()) || fs::create_directories(dst.parent_path()));
-        fs::copy_file(src, dst, fs::copy_options::overwrite_existing);
-    } else {
+static void copyFileIfChanged(BuildGraph& graph, std::string const& node, fs::path src, fs::path dst) {
+    VULK_ASSERT(fs::exists(src) && fs::is_regular_file(src), "src File {} does not exist", src.string());
+    BuildGraph::Inputs inputs = graph.inputs().file(src);
+    if (!graph.isOutOfDate(node, inputs, {dst})) {
         logger->trace("Skipping file copy: {} to {}", src.string(), dst.string());
+        return;
     }
+    logger->info("Copying file: {} to {}", src.string(), dst.string());
+    VULK_ASSERT(fs::exists(dst.parent_path()) || fs::create_directories(dst.parent_path()));
+    fs::copy_file(src, dst, fs::copy_options::overwrite_existing);
+    graph.built(node, inputs, {dst});
 }
 
-static void copyDirIfShould(fs::path src, fs::path dst) {
+// same as copyFileIfChanged but for every file in a leaf directory, as one node
+static void copyDirIfChanged(BuildGraph& graph, std::string const& node, fs::path src, fs::path dst) {
     // Check if source directory exists
     assert(fs::exists(src) && fs::is_directory(src));
 
-    // Create destination directory if it does not exist
-    if (!fs::exists(dst)) {
-        fs::create_directories(dst);
-    }
-    // Iterate through the source directory
+    BuildGraph::Inputs inputs = graph.inputs();
+    std::vector<fs::path> srcFiles, dstFiles;
     std::unordered_set<std::string> sourceFiles;
     for (const auto& entry : fs::directory_iterator(src)) {
         // Assert if a subdirectory is found, just handle files in leaf directories for now
         VULK_ASSERT(!fs::is_directory(entry.path()));
         std::string filename = entry.path().filename().string();
         sourceFiles.insert(filename);
-        fs::path dest_path = dst / filename;
-        copyFileIfShould(entry.path(), dest_path);
+        inputs.file(entry.path());
+        srcFiles.push_back(entry.path());
+        dstFiles.push_back(dst / filename);
+    }
+    if (graph.isOutOfDate(node, inputs, dstFiles)) {
+        logger->info("Copying dir: {} to {}", src.string(), dst.string());
+        // Create destination directory if it does not exist
+        if (!fs::exists(dst)) {
+            fs::create_directories(dst);
+        }
+        for (size_t i = 0; i < srcFiles.size(); ++i) {
+            fs::copy_file(srcFiles[i], dstFiles[i], fs::copy_options::overwrite_existing);
+        }
+        graph.built(node, inputs, dstFiles);
     }
     // Check for files in dst that are not in src
     for (const auto& entry : fs::directory_iterator(dst)) {
         VULK_ASSERT(!fs::is_directory(entry.path()));
+        if (entry.path().extension() == VulkCookedTexture::COOKED_EXT) {
+            continue;  // cooked textures go next to the images they were cooked from
+        }
         std::string filename = entry.path().filename().string();
         VULK_ASSERT(sourceFiles.contains(filename), "File in destination not in source: {}", filename);
     }
 }
 
-// builds the shader in the build directory so it can be loaded by the pipeline
-// TODO: compare timestamps and only rebuild if necessary
-static vk2::ShaderDef buildShaderDef(fs::path srcShaderPath, fs::path buildDir, fs::path generatedHeaderDir) {
+// imports src with Assimp, optimizes it for the vertex cache/overdraw/fetch and writes it out in
+// the format VulkMesh::loadCooked reads
+static void cookMeshIfChanged(BuildGraph& graph, std::string const& meshName, fs::path src, fs::path dst) {
+    std::string node          = "mesh:" + meshName;
+    BuildGraph::Inputs inputs = graph.inputs()
+                                    .file(src)
+                                    .value("cookVersion", std::to_string(VulkCookedMeshHeader::VERSION))
+                                    .value("optimizerVersion", std::to_string(VulkMeshOptimizer::VERSION));
+    if (!graph.isOutOfDate(node, inputs, {dst})) {
+        return;
+    }
+    logger->info("Cooking mesh {} to {}", src.string(), dst.string());
+    VulkMesh mesh               = VulkMesh::loadFromAssets(nullptr, src, meshName);
+    VulkVertexCacheStats before = VulkMeshOptimizer::analyzeVertexCache(mesh);
+    size_t numVerticesBefore    = mesh.vertices.size();
+    VulkMeshOptimizer::optimize(mesh);
+    VulkVertexCacheStats after = VulkMeshOptimizer::analyzeVertexCache(mesh);
+    logger->info("{}: {} -> {} vertices, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+                 meshName,
+                 numVerticesBefore,
+                 mesh.vertices.size(),
+                 before.acmr,
+                 after.acmr,
+                 before.atvr,
+                 after.atvr);
+    mesh.writeCooked(dst);
+    graph.built(node, inputs, {dst});
+}
+
+// decodes src, builds its mip chain and block compresses it in the format VulkCookedTexture::loadCooked reads
+static void cookTextureIfChanged(BuildGraph& graph, std::string const& node, fs::path src, fs::path dst, VulkTextureKind kind) {
+    BuildGraph::Inputs inputs = graph.inputs()
+                                    .file(src)
+                                    .value("cookVersion", std::to_string(VulkCookedTextureHeader::VERSION))
+                                    .value("kind", std::to_string((uint32_t)kind));
+    if (!graph.isOutOfDate(node, inputs, {dst})) {
+        return;
+    }
+    logger->info("Cooking texture {} to {}", src.string(), dst.string());
+    std::vector<char> encoded = readFileIntoMem(src.string());
+    VulkCookedTexture cooked  = VulkCookedTexture::cook(VulkTextureCache::decodeUncached(encoded, src.string()), kind);
+    logger->info("{}: {}x{}, {} mips, {} -> {} bytes",
+                 src.filename().string(),
+                 cooked.width,
+                 cooked.height,
+                 cooked.mipLevels,
+                 (size_t)cooked.width * cooked.height * 4,
+                 cooked.data.size());
+    cooked.writeCooked(dst);
+    graph.built(node, inputs, {dst});
+}
+
+// A unit of work for runBuildJobs. the name is only used for error reporting.
+struct BuildJob {
+    std::string name;
+    std::function<void()> fn;
+};
+
+// Runs the jobs across numThreads workers. Jobs are handed out in order and every job is run
+// even if some fail: errors are collected per job and thrown together (in job order) at the end
+// so one bad shader doesn't hide the rest.
+static void runBuildJobs(std::string const& what, std::vector<BuildJob> const& jobs, uint32_t numThreads) {
+    std::vector<std::string> errors(jobs.size());
+    std::atomic<size_t> nextJob = 0;
+
+    auto worker = [&]() {
+        for (size_t i = nextJob++; i < jobs.size(); i = nextJob++) {
+            try {
+                jobs[i].fn();
+            } catch (std::exception& e) {
+                errors[i] = e.what();
+            } catch (...) {
+                errors[i] = "unknown error";
+            }
+        }
+    };
+
+    numThreads = std::max(1u, std::min(numThreads, (uint32_t)jobs.size()));
+    logger->trace("Running {} {} jobs on {} threads", jobs.size(), what, numThreads);
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < numThreads; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::string errMsg;
+    size_t numErrors = 0;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (!errors[i].empty()) {
+            errMsg += "\n" + jobs[i].name + ": " + errors[i];
+            numErrors++;
+        }
+    }
+    if (numErrors > 0) {
+        logger->error("{} of {} {} jobs failed:{}", numErrors, jobs.size(), what, errMsg);
+        VULK_THROW("{} of {} {} jobs failed:{}", numErrors, jobs.size(), what, errMsg);
+    }
+}
+
+// the dirs the shader compiles read from and write to. these are made up front as
+// the compiles run in parallel and fs::create_directories isn't safe to race.
+static void makeShaderDirs(fs::path srcShaderPath, fs::path buildDir) {
+    makeDir(srcShaderPath.parent_path().parent_path() / "Common");
+    makeDir(buildDir / srcShaderPath.extension().string().substr(1));
+}
+
+// where buildShaderDef puts the SPIR-V for a shader, e.g. Shaders/vert/foo.vertspv
+static fs::path builtShaderPath(fs::path srcShaderPath, fs::path buildDir) {
+    return buildDir / srcShaderPath.extension().string().substr(1) / (srcShaderPath.filename().string() + "spv");
+}
+
+// SPIR-V compiled in process this run, so the pipeline reflection doesn't have to read it back from disk
+struct BuiltShaders {
+    std::mutex mutex;
+    BuiltSpirv spirv;
+    ShaderIncludeCache includes;  // only good for this build, see ShaderIncludeCache
+};
+
+// builds the shader in the build directory so it can be loaded by the pipeline.
+// skipped if the cache says the source, its includes and the flags are unchanged since the last build.
+static vk2::ShaderDef buildShaderDef(fs::path srcShaderPath,
+                                     fs::path buildDir,
+                                     fs::path generatedHeaderDir,
+                                     BuildProjectOptions const& options,
+                                     ShaderBuildCache& cache,
+                                     BuiltShaders& builtShaders) {
     VULK_ASSERT(fs::exists(srcShaderPath) && fs::is_regular_file(srcShaderPath));
 
     fs::path commonDir = srcShaderPath.parent_path().parent_path() / "Common";
-    makeDir(commonDir);
-
     VULK_ASSERT(fs::exists(commonDir) && fs::is_directory(commonDir));
 
-    std::string shaderDir = srcShaderPath.extension().string().substr(1);
-    if (!fs::exists(buildDir / shaderDir)) {
-        makeDir(buildDir / shaderDir);
-    }
-    fs::path dstShaderPath = buildDir / shaderDir / (srcShaderPath.filename().string() + "spv");
+    fs::path dstShaderPath = builtShaderPath(srcShaderPath, buildDir);
+    VULK_ASSERT(fs::is_directory(dstShaderPath.parent_path()));
 
-    if (shouldCopyFile(srcShaderPath, dstShaderPath)) {
-        logger->info("Building shader: {}", srcShaderPath.string());
-        std::string cmd = "glslc -g --target-env=vulkan1.3";
+    vk2::ShaderDef shaderOut;
+    shaderOut.name_ref() = srcShaderPath.stem().string();
+    shaderOut.path_ref() = dstShaderPath.lexically_relative(buildDir).string();
+
+    // the in process compiler is set up to match these flags, but hash which one built the
+    // shader anyway so switching backends always rebuilds.
+    std::string flags = "-g --target-env=vulkan1.3";
 #ifdef DEBUG
-        cmd += " -O0";
+    flags += " -O0";
 #endif
+    std::vector<fs::path> includeDirs = {generatedHeaderDir, commonDir};
+    ShaderCompilerBackend backend     = options.shaderCompiler;
+    std::string backendName           = backend == ShaderCompilerBackend::Shaderc ? "shaderc" : "glslc";
+    ShaderBuildCache::ShaderHash hash = ShaderBuildCache::hashShader(srcShaderPath, includeDirs, backendName + " " + flags);
+    std::string why;
+    if (cache.isUpToDate(shaderOut.get_path(), dstShaderPath, hash, &why)) {
+        logger->trace("Skipping shader already built: {}", srcShaderPath.string());
+        return shaderOut;
+    }
+    if (options.explain) {
+        logger->info("shader:{}: rebuilding, {}", shaderOut.get_path(), why);
+    }
+
+    logger->info("Building shader: {}", srcShaderPath.string());
+    if (backend == ShaderCompilerBackend::Shaderc) {
+        std::vector<uint32_t> spirv = compileShaderInProcess(srcShaderPath, includeDirs, builtShaders.includes);
+        std::ofstream ofs(dstShaderPath, std::ios::binary);
+        VULK_ASSERT(ofs.is_open(), "Could not open file for writing: {}", dstShaderPath.string());
+        ofs.write((char const*)spirv.data(), (std::streamsize)(spirv.size() * sizeof(uint32_t)));
+        ofs.close();
+        VULK_ASSERT(!ofs.fail(), "Failed to write shader: {}", dstShaderPath.string());
+
+        std::lock_guard<std::mutex> lock(builtShaders.mutex);
+        builtShaders.spirv[dstShaderPath.lexically_normal().string()] = std::move(spirv);
+    } else {
+        std::string cmd = "glslc " + flags;
         cmd += " -I" + generatedHeaderDir.string() + " -I" + commonDir.string();
         cmd += " -o " + dstShaderPath.string() + " " + srcShaderPath.string();
         std::string out;
         int result = runProcess(cmd, out);
         VULK_ASSERT(result == 0, "Failed to compile shader: {}, output:\n{}", cmd, out);
-    } else {
-        logger->trace("Skipping shader already built: {}", srcShaderPath.string());
     }
-
-    vk2::ShaderDef shaderOut;
-    shaderOut.name_ref() = srcShaderPath.stem().string();
-    shaderOut.path_ref() = dstShaderPath.lexically_relative(buildDir).string();
+    cache.update(shaderOut.get_path(), hash);
     return shaderOut;
 }
 
-void buildPipelineAndShaders(const SrcMetadata& metadata,
-                             vk2::SrcPipelineDef srcPipelineDef,
-                             fs::path shadersBuildDir,
-                             fs::path generatedHeaderDir) {
-    vk2::PipelineDef pipelineDef;
-    pipelineDef.name_ref() = srcPipelineDef.get_name();
-
-    // first build the shaders so we can reference them when we build the descriptor sets etc.
+// the source files for each of the shaders the pipeline uses
+static std::vector<fs::path> getPipelineShaderSrcs(const SrcMetadata& metadata, vk2::SrcPipelineDef const& srcPipelineDef) {
+    std::vector<fs::path> srcs;
     if (srcPipelineDef.get_vertShader() != "") {
         VULK_ASSERT(metadata.vertShaders.contains(srcPipelineDef.get_vertShader()),
                     "Vertex shader {} not found",
                     srcPipelineDef.get_vertShader());
-        fs::path path = metadata.vertShaders.at(srcPipelineDef.get_vertShader());
-        buildShaderDef(path, shadersBuildDir, generatedHeaderDir);
+        srcs.push_back(metadata.vertShaders.at(srcPipelineDef.get_vertShader()));
     }
     if (srcPipelineDef.get_geomShader() != "") {
         VULK_ASSERT(metadata.geometryShaders.contains(srcPipelineDef.get_geomShader()),
                     "Geometry shader {} not found",
                     srcPipelineDef.get_geomShader());
-        buildShaderDef(metadata.geometryShaders.at(srcPipelineDef.get_geomShader()), shadersBuildDir, generatedHeaderDir);
+        srcs.push_back(metadata.geometryShaders.at(srcPipelineDef.get_geomShader()));
     }
     if (srcPipelineDef.get_fragShader() != "") {
         VULK_ASSERT(metadata.fragmentShaders.contains(srcPipelineDef.get_fragShader()),
                     "Fragment shader {} not found",
                     srcPipelineDef.get_fragShader());
-        buildShaderDef(metadata.fragmentShaders.at(srcPipelineDef.get_fragShader()), shadersBuildDir, generatedHeaderDir);
+        srcs.push_back(metadata.fragmentShaders.at(srcPipelineDef.get_fragShader()));
     }
+    return srcs;
+}
 
-    // build the pipeline with the built shaders
-    PipelineBuilder::buildPipelineFile(srcPipelineDef,
-                                       shadersBuildDir,
-                                       shadersBuildDir.parent_path() / "Pipelines" / (srcPipelineDef.get_name() + ".pipeline"));
+// Builds the pipelines in two passes:
+// 1. every distinct shader referenced by any pipeline is compiled once (if out of date), in parallel
+// 2. each pipeline is reflected from its built shaders, also in parallel. each distinct shader is
+//    only reflected once, see ShaderInfoCache
+// both passes report all of their failures at once.
+static void buildPipelinesAndShaders(const SrcMetadata& metadata,
+                                     std::map<string, vk2::SrcPipelineDef> const& srcPipelineDefs,
+                                     fs::path shadersBuildDir,
+                                     fs::path generatedHeaderDir,
+                                     ShaderBuildCache& shaderCache,
+                                     BuildGraph& graph,
+                                     BuildProjectOptions const& options) {
+    // gather the shaders. std::set so the build order doesn't depend on hashing
+    std::set<fs::path> shaderSrcs;
+    std::string resolveErrors;
+    std::map<std::string, std::string> builtNames;  // built pipeline name -> the file it's from
+    for (auto& [pipelineName, srcPipelineDef] : srcPipelineDefs) {
+        // the built pipeline is named after the def, so two defs with the same name would write the same file at once
+        auto [it, added] = builtNames.try_emplace(srcPipelineDef.get_name(), pipelineName);
+        if (!added) {
+            resolveErrors += "\n" + pipelineName + ": named " + srcPipelineDef.get_name() + ", same as " + it->second;
+        }
+        try {
+            for (fs::path& src : getPipelineShaderSrcs(metadata, srcPipelineDef)) {
+                shaderSrcs.insert(src);
+            }
+        } catch (std::exception& e) {
+            resolveErrors += "\n" + pipelineName + ": " + e.what();
+        }
+    }
+    if (!resolveErrors.empty()) {
+        logger->error("Failed to resolve pipeline shaders:{}", resolveErrors);
+        VULK_THROW("Failed to resolve pipeline shaders:{}", resolveErrors);
+    }
+
+    BuiltShaders builtShaders;
+    std::vector<BuildJob> shaderJobs;
+    for (fs::path const& src : shaderSrcs) {
+        makeShaderDirs(src, shadersBuildDir);
+        shaderJobs.push_back({src.filename().string(), [=, &shaderCache, &builtShaders, &options]() {
+                                  buildShaderDef(src, shadersBuildDir, generatedHeaderDir, options, shaderCache, builtShaders);
+                              }});
+    }
+    // save whatever did build, even if some shaders failed
+    try {
+        runBuildJobs("shader", shaderJobs, options.numThreads);
+    } catch (...) {
+        shaderCache.save();
+        throw;
+    }
+    shaderCache.save();
+
+    // build the pipelines with the built shaders. unchanged shaders use their reflection from the last build
+    fs::path shaderInfoCacheFile = shadersBuildDir.parent_path().parent_path() / "ShaderInfoCache.json";
+    ShaderInfoCache shaderInfoCache;
+    shaderInfoCache.load(shaderInfoCacheFile);
+    fs::path pipelinesDir = shadersBuildDir.parent_path() / "Pipelines";
+    makeDir(pipelinesDir);
+    std::vector<BuildJob> pipelineJobs;
+    for (auto& [pipelineName, srcPipelineDef] : srcPipelineDefs) {
+        // a pipeline only depends on its source and the SPIR-V of its shaders
+        std::string node          = "pipeline:" + pipelineName;
+        fs::path pipelineFileOut  = pipelinesDir / (srcPipelineDef.get_name() + ".pipeline");
+        BuildGraph::Inputs inputs = graph.inputs()
+                                        .file(metadata.pipelines.at(pipelineName))
+                                        .value("format", std::to_string((int)options.outputFormat));
+        for (fs::path const& src : getPipelineShaderSrcs(metadata, srcPipelineDef)) {
+            inputs.file(builtShaderPath(src, shadersBuildDir));
+        }
+        if (!graph.isOutOfDate(node, inputs, {pipelineFileOut})) {
+            continue;
+        }
+
+        vk2::SrcPipelineDef const* def = &srcPipelineDef;
+        BuiltSpirv const* spirv        = &builtShaders.spirv;
+        VulkDefFormat format           = options.outputFormat;
+        pipelineJobs.push_back({pipelineName, [=, &graph, &shaderInfoCache]() {
+                                    PipelineBuilder::buildPipelineFile(
+                                        *def, shadersBuildDir, pipelineFileOut, spirv, &shaderInfoCache, format);
+                                    graph.built(node, inputs, {pipelineFileOut});
+                                }});
+    }
+    try {
+        runBuildJobs("pipeline", pipelineJobs, options.numThreads);
+    } catch (...) {
+        shaderInfoCache.save(shaderInfoCacheFile);
+        throw;
+    }
+    shaderInfoCache.save(shaderInfoCacheFile);
 }
 
 // This is the main entry point for building a project definition from a project file.
 // it searches the assets in the passed in directory and builds only those referenced
-// by the project itself.
-void buildProjectDef(const fs::path project_file_path, fs::path buildDir) {
+// by the project itself. Only the steps whose inputs changed since the last build are
+// redone, see BuildGraph.
+static void buildProject(const fs::path project_file_path,
+                         fs::path buildDir,
+                         BuildProjectOptions const& options,
+                         BuildGraph& graph) {
     fs::path projectDir = project_file_path.parent_path();
     logger->trace("Building project from {}", project_file_path.string());
     VULK_ASSERT(fs::exists(project_file_path), "Project file does not exist: {}", project_file_path.string());
@@ -313,18 +572,22 @@ void buildProjectDef(const fs::path project_file_path, fs::path buildDir) {
     glslShaderEnumsGenerator(commonShaderHeadersDir / "VulkShaderEnums_generated.glsl", false);
 
     for (auto& [shaderName, shaderPath] : metadata.shaderIncludes) {
-        fs::copy_file(shaderPath, commonShaderHeadersDir / shaderPath.filename(), fs::copy_options::overwrite_existing);
+        copyFileIfChanged(graph, "include:" + shaderName, shaderPath, commonShaderHeadersDir / shaderPath.filename());
     }
 
     // build the shaders, pipelines and models
     vk2::ProjectDef projectOut;
+    std::set<string> meshesToCook;
+    std::set<string> materialsToCook;
+    BuildGraph::Inputs projectInputs = graph.inputs().file(project_file_path);
     for (string sceneName : projectIn.get_sceneNames()) {
         if (!metadata.scenes.contains(sceneName)) {
             logger->error("Scene {} in {} doesn't exist. missing scene file?", sceneName, project_file_path.string());
             VULK_THROW("Scene {} in {} doesn't exist. missing scene file?", sceneName, project_file_path.string());
         }
         fs::path scenePath = metadata.scenes.at(sceneName);
-        copyFileIfShould(scenePath, assetsDir / "Scenes" / scenePath.filename());
+        copyFileIfChanged(graph, "scene:" + sceneName, scenePath, assetsDir / "Scenes" / scenePath.filename());
+        projectInputs.node("scene:" + sceneName);
         readDefFromFile(scenePath.string(), projectOut.scenes_ref()[sceneName]);
         auto& scene = projectOut.scenes_ref()[sceneName];
         for (auto& actorDef : scene.actors_ref().value()) {
@@ -332,10 +595,10 @@ void buildProjectDef(const fs::path project_file_path, fs::path buildDir) {
             vk2::ModelDef* modelDef = nullptr;
             if (modelName != "") {
                 if (!projectOut.get_models().contains(modelName)) {
-                    fs::path modelPath = (projectDir / (actorDef.get_modelName() + ".model"));
                     VULK_ASSERT(metadata.models.contains(modelName), "Model {} not found", modelName);
-                    copyFileIfShould(metadata.models.at(modelName),
-                                     assetsDir / "Models" / metadata.models.at(modelName).filename());
+                    fs::path modelPath = metadata.models.at(modelName);
+                    copyFileIfChanged(graph, "model:" + modelName, modelPath, assetsDir / "Models" / modelPath.filename());
+                    projectInputs.node("model:" + modelName);
                     modelDef = &projectOut.models_ref()[modelName];
                     readDefFromFile(modelPath.string(), *modelDef);
                 }
@@ -344,32 +607,153 @@ void buildProjectDef(const fs::path project_file_path, fs::path buildDir) {
                 modelDef = &actorDef.inlineModel_ref().value();
             }
             if (modelDef) {
+                if (modelDef->get_meshDefType() == vk2::MeshDefType::Model) {
+                    VULK_ASSERT(metadata.meshes.contains(modelDef->get_mesh()), "Mesh {} not found", modelDef->get_mesh());
+                    meshesToCook.insert(modelDef->get_mesh());
+                }
                 // copy materials
                 VULK_ASSERT(metadata.materials.contains(modelDef->get_material()),
                             "Material {} not found",
                             modelDef->get_material());
                 fs::path materialPath = metadata.materials.at(modelDef->get_material());
-                copyDirIfShould(materialPath.parent_path(), assetsDir / "Materials" / materialPath.parent_path().filename());
+                copyDirIfChanged(graph,
+                                 "material:" + modelDef->get_material(),
+                                 materialPath.parent_path(),
+                                 assetsDir / "Materials" / materialPath.parent_path().filename());
+                materialsToCook.insert(modelDef->get_material());
+            }
+        }
+    }
+
+    // cook the referenced meshes so the runtime doesn't have to run Assimp on them. the runtime
+    // picks up Meshes/<name>.vulkmesh in place of the .obj with the same name
+    std::vector<BuildJob> meshJobs;
+    if (!meshesToCook.empty()) {
+        makeDir(assetsDir / "Meshes");  // before the jobs so they don't race to create it
+    }
+    for (string const& meshName : meshesToCook) {
+        fs::path src = metadata.meshes.at(meshName);
+        fs::path dst = assetsDir / "Meshes" / (meshName + VulkMesh::COOKED_EXT);
+        meshJobs.push_back({meshName, [&graph, meshName, src, dst]() { cookMeshIfChanged(graph, meshName, src, dst); }});
+    }
+    runBuildJobs("mesh", meshJobs, options.numThreads);
+
+    // cook the textures the referenced materials use into block compressed mip chains. each one goes
+    // next to its copy of the image, as <image>.vulktex, which the runtime loads in its place. the
+    // format depends on what the material uses the image for
+    struct TextureToCook {
+        fs::path src;
+        VulkTextureKind kind;
+    };
+    std::map<fs::path, TextureToCook> texturesToCook;  // by dst
+    std::set<fs::path> ambiguousTextures;
+    for (string const& materialName : materialsToCook) {
+        fs::path materialPath  = metadata.materials.at(materialName);
+        fs::path srcDir        = materialPath.parent_path();
+        fs::path dstDir        = assetsDir / "Materials" / srcDir.filename();
+        MaterialDef materialIn = loadMaterialDef(materialPath, nullptr);
+
+        std::pair<std::string const*, VulkTextureKind> maps[] = {
+            {&materialIn.mapKd, VulkTextureKind::Color},
+            {&materialIn.mapNormal, VulkTextureKind::Normal},
+            {&materialIn.mapKa, VulkTextureKind::Single},  // ambient occlusion
+            {&materialIn.disp, VulkTextureKind::Single},
+            {&materialIn.mapPm, VulkTextureKind::Single},
+            {&materialIn.mapPr, VulkTextureKind::Single},
+        };
+        for (auto [path, kind] : maps) {
+            fs::path src = *path;
+            // only the images in the material's own directory are copied, so only they can be cooked
+            if (src.empty() || !fs::equivalent(src.parent_path(), srcDir)) {
+                continue;
+            }
+            fs::path dst = VulkCookedTexture::cookedPathFor(dstDir / src.filename());
+            auto it      = texturesToCook.find(dst);
+            if (it == texturesToCook.end()) {
+                texturesToCook[dst] = {src, kind};
+            } else if (it->second.kind != kind) {
+                ambiguousTextures.insert(dst);
             }
         }
     }
+    for (fs::path const& dst : ambiguousTextures) {
+        logger->warn("Not cooking {}, materials use it for different things", texturesToCook.at(dst).src.string());
+        texturesToCook.erase(dst);
+        if (fs::exists(dst)) {
+            fs::remove(dst);
+        }
+    }
+    std::vector<BuildJob> textureJobs;
+    for (auto const& [dst, texture] : texturesToCook) {
+        std::string node = "texture:" + dst.lexically_relative(assetsDir).generic_string();
+        textureJobs.push_back({dst.filename().string(), [&graph, node, dst, src = texture.src, kind = texture.kind]() {
+                                   cookTextureIfChanged(graph, node, src, dst, kind);
+                               }});
+    }
+    runBuildJobs("texture", textureJobs, options.numThreads);
 
     // build all the pipelines, some aren't referenced by the project so we need to build them all
+    std::map<string, vk2::SrcPipelineDef> srcPipelineDefs;
     for (auto [pipelineName, pipelinePath] : metadata.pipelines) {
         if (!projectOut.get_pipelines().contains(pipelineName)) {
-            vk2::SrcPipelineDef srcPipelineDef;
-            copyFileIfShould(pipelinePath, assetsDir / "Pipelines" / pipelinePath.filename());
-            readDefFromFile(pipelinePath.string(), srcPipelineDef);
-            buildPipelineAndShaders(metadata, srcPipelineDef, assetsDir / "Shaders", commonShaderHeadersDir);
+            readDefFromFile(pipelinePath.string(), srcPipelineDefs[pipelineName]);
         }
     }
+    ShaderBuildCache shaderCache(buildDir / "ShaderBuildCache.json");
+    buildPipelinesAndShaders(
+        metadata, srcPipelineDefs, assetsDir / "Shaders", commonShaderHeadersDir, shaderCache, graph, options);
 
     if (projectOut.get_scenes().size() == 0) {
         logger->error("No scenes found in {}", project_file_path.string());
         VULK_THROW("No scenes found in {}", project_file_path.string());
     }
 
-    projectOut.name_ref()          = projectIn.get_name();
-    projectOut.startingScene_ref() = projectIn.get_startingScene();
-    writeDefToFile((buildDir / project_file_path.filename()).string(), projectOut);
+    // the project is just its scenes and models
+    fs::path projectFileOut = buildDir / project_file_path.filename();
+    projectInputs.value("format", std::to_string((int)options.outputFormat));
+    if (graph.isOutOfDate("project:" + projectIn.get_name(), projectInputs, {projectFileOut})) {
+        projectOut.name_ref()          = projectIn.get_name();
+        projectOut.startingScene_ref() = projectIn.get_startingScene();
+        writeDefToFile(projectFileOut.string(), projectOut, options.outputFormat);
+        graph.built("project:" + projectIn.get_name(), projectInputs, {projectFileOut});
+    }
+
+    // the runtime loads from the pack when there is one, so don't leave a stale one around
+    fs::path packFile = VulkAssetPack::packFileFor(assetsDir);
+    if (options.pack) {
+        std::vector<fs::path> assetFiles;
+        for (auto const& entry : fs::recursive_directory_iterator(assetsDir)) {
+            if (entry.is_regular_file()) {
+                assetFiles.push_back(entry.path());
+            }
+        }
+        BuildGraph::Inputs packInputs = graph.inputs();
+        for (fs::path const& file : assetFiles) {
+            packInputs.file(file);
+        }
+        if (graph.isOutOfDate("pack", packInputs, {packFile})) {
+            VulkAssetPack::write(assetsDir, packFile);
+            graph.built("pack", packInputs, {packFile});
+        }
+    } else if (fs::exists(packFile)) {
+        logger->info("Removing stale asset pack {}", packFile.string());
+        fs::remove(packFile);
+    }
+}
+
+void buildProjectDef(const fs::path project_file_path, fs::path buildDir, BuildProjectOptions const& optionsIn) {
+    BuildProjectOptions options = optionsIn;
+    if (options.numThreads == 0) {
+        options.numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // save whatever did build, even if something failed
+    BuildGraph graph(buildDir / "BuildGraph.json", options.explain);
+    try {
+        buildProject(project_file_path, buildDir, options, graph);
+    } catch (...) {
+        graph.save();
+        throw;
+    }
+    graph.save();
 }
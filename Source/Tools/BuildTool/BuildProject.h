@@ -1,5 +1,19 @@
 #pragma once
+#include <cstdint>
 #include <filesystem>
 
+#include "ShaderCompiler.h"
+#include "Vulk/VulkResourceMetadata.h"
+
+struct BuildProjectOptions {
+    uint32_t numThreads                  = 0;  // how many shaders/pipelines to build at once, 0 is one per core
+    ShaderCompilerBackend shaderCompiler = ShaderCompilerBackend::Glslc;
+    VulkDefFormat outputFormat           = VulkDefFormat::Json;  // for the built .proj and .pipeline files
+    bool pack                            = false;  // also pack the built Assets dir into Assets.vulkpack
+    bool explain                         = false;  // log why each step is rebuilt
+};
+
 extern void glslShaderEnumsGenerator(std::filesystem::path outFile, bool verbose);
-extern void buildProjectDef(const std::filesystem::path project_file_path, std::filesystem::path buildDir);
+extern void buildProjectDef(const std::filesystem::path project_file_path,
+                            std::filesystem::path buildDir,
+                            BuildProjectOptions const& options = {});
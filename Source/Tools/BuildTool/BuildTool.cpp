@@ -1,5 +1,6 @@
 #include <filesystem>
 #include <iostream>
+#include <map>
 #include <memory>
 
 #include "CLI/CLI.hpp"
@@ -9,6 +10,7 @@
 #include "BuildPipeline.h"
 #include "BuildProject.h"
 #include "Vulk/VulkLogger.h"
+#include "Vulk/VulkMeshOptimizer.h"
 #include "Vulk/VulkUtil.h"
 
 namespace fs = std::filesystem;
@@ -54,6 +56,27 @@ void pipelineBuilder(fs::path builtShadersDir, fs::path pipelineFileOut, fs::pat
     logger->trace("PipelineBuilder: Done!");
 }
 
+// ACMR/ATVR before and after VulkMeshOptimizer::optimize, to check what cooking a mesh buys
+void meshStatsReport(std::vector<fs::path> const& meshFiles) {
+    std::cout << fmt::format("{:<32} {:>9} {:>9} {:>9} {:>15} {:>15}\n", "mesh", "tris", "verts", "verts opt", "ACMR", "ATVR");
+    for (fs::path const& meshFile : meshFiles) {
+        VulkMesh mesh               = VulkMesh::loadFromAssets(nullptr, meshFile, meshFile.stem().string());
+        VulkVertexCacheStats before = VulkMeshOptimizer::analyzeVertexCache(mesh);
+        size_t numVerticesBefore    = mesh.vertices.size();
+        VulkMeshOptimizer::optimize(mesh);
+        VulkVertexCacheStats after = VulkMeshOptimizer::analyzeVertexCache(mesh);
+        std::cout << fmt::format("{:<32} {:>9} {:>9} {:>9} {:>6.3f} -> {:<6.3f} {:>6.3f} -> {:<6.3f}\n",
+                                 mesh.name,
+                                 before.numTriangles,
+                                 numVerticesBefore,
+                                 mesh.vertices.size(),
+                                 before.acmr,
+                                 after.acmr,
+                                 before.atvr,
+                                 after.atvr);
+    }
+}
+
 int main(int argc, char** argv) {
     // SetUnhandledExceptionFilter(exceptionFilter);
     std::shared_ptr<spdlog::logger> logger = VulkLogger::CreateLogger("BuildTool");
@@ -101,7 +124,40 @@ int main(int argc, char** argv) {
     project->add_option("projectFileIn", projectFileIn, "Project file to build.");
     fs::path projectOutDir;
     project->add_option("projectOutDir", projectOutDir, "Directory where the projects are built to.");
-    project->callback([&projectFileIn, &projectOutDir]() { buildProjectDef(projectFileIn, projectOutDir); });
+    BuildProjectOptions projectOptions;
+    project->add_option(
+        "-j, --jobs", projectOptions.numThreads, "Number of shaders/pipelines to build in parallel (default: one per core).");
+    std::map<std::string, ShaderCompilerBackend> shaderCompilers = {
+        {"glslc", ShaderCompilerBackend::Glslc},
+        {"shaderc", ShaderCompilerBackend::Shaderc},
+    };
+    project
+        ->add_option("--shader-compiler",
+                     projectOptions.shaderCompiler,
+                     "glslc: run glslc for each shader (default), shaderc: compile in process")
+        ->transform(CLI::CheckedTransformer(shaderCompilers, CLI::ignore_case));
+    std::map<std::string, VulkDefFormat> outputFormats = {
+        {"json", VulkDefFormat::Json},
+        {"compact", VulkDefFormat::Compact},
+        {"binary", VulkDefFormat::Binary},
+    };
+    project
+        ->add_option("--output-format",
+                     projectOptions.outputFormat,
+                     "json: SimpleJSON (default), compact/binary: thrift protocols, smaller and faster to load")
+        ->transform(CLI::CheckedTransformer(outputFormats, CLI::ignore_case));
+    project->add_flag("--pack", projectOptions.pack, "Also pack the built assets into a single Assets.vulkpack archive.");
+    project->add_flag("--explain", projectOptions.explain, "Log why each shader, pipeline, etc. is rebuilt.");
+    project->callback([&projectFileIn, &projectOutDir, &projectOptions]() {
+        buildProjectDef(projectFileIn, projectOutDir, projectOptions);
+    });
+
+    CLI::App* meshStats = app.add_subcommand("meshstats", "report vertex cache stats for meshes before/after optimizing them");
+    std::vector<fs::path> meshFiles;
+    meshStats->add_option("meshFiles", meshFiles, "Meshes to report on: anything Assimp loads, or cooked .vulkmesh files.")
+        ->required()
+        ->check(CLI::ExistingFile);
+    meshStats->callback([&meshFiles]() { meshStatsReport(meshFiles); });
 
     // CLI::App *scene = app.add_subcommand("scene", "build the scene file");
     // fs::path sceneFileIn;
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <filesystem>
+#include <mutex>
+#include <regex>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ShaderCompiler.h"
+#include "Vulk/VulkHash.h"
+#include "Vulk/VulkLogger.h"
+#include "Vulk/VulkResourceMetadata.h"
+
+// Persistent record of what each built shader was compiled from, so BuildTool can skip
+// glslc when nothing that affects the output has changed. Shaders are keyed on a hash of:
+// - the shader source
+// - every file it #includes, transitively, found the same way glslc finds them
+// - the compile options (flags, target env)
+// This means touching a file without changing it doesn't rebuild anything, and editing a
+// shared include like common.glsl rebuilds exactly the shaders that use it.
+//
+// Thread safe, the shaders are compiled in parallel.
+class ShaderBuildCache {
+    static std::shared_ptr<spdlog::logger> logger() {
+        static std::shared_ptr<spdlog::logger> logger;
+        static std::once_flag flag;
+        std::call_once(flag, []() { logger = VulkLogger::CreateLogger("ShaderBuildCache"); });
+        return logger;
+    }
+
+   public:
+    // bump this to invalidate every existing cache, e.g. if the hashing changes
+    static constexpr int32_t VERSION = 1;
+
+    struct ShaderHash {
+        uint64_t hash;
+        std::vector<std::filesystem::path> includes;  // in the order they were first included
+    };
+
+    ShaderBuildCache(std::filesystem::path cacheFile) : cacheFile(cacheFile) {
+        if (std::filesystem::exists(cacheFile)) {
+            try {
+                readDefFromFile(cacheFile.string(), def);
+            } catch (std::exception& e) {
+                logger()->warn("Ignoring unreadable shader build cache {}: {}", cacheFile.string(), e.what());
+                def = {};
+            }
+            if (def.get_version() != VERSION) {
+                logger()->info("Shader build cache {} is version {}, rebuilding", cacheFile.string(), def.get_version());
+                def = {};
+            }
+        }
+        def.version_ref() = VERSION;
+    }
+
+    // includes are found with resolveShaderInclude. Missing includes still go into the hash (by name)
+    // so the shader rebuilds once the include shows up.
+    static ShaderHash hashShader(std::filesystem::path src,
+                                 std::vector<std::filesystem::path> const& includeDirs,
+                                 std::string const& options) {
+        VulkHasher hasher;
+        hasher.addValue(VERSION);
+        hasher.add(options);
+
+        ShaderHash out;
+        std::set<std::filesystem::path> visited = {src};
+        hashFileAndIncludes(src, includeDirs, hasher, visited, out.includes);
+        out.hash = hasher.get();
+        return out;
+    }
+
+    // key is whatever uniquely names the built shader, e.g. its path relative to the build dir.
+    // if it isn't up to date whyOut says why, for BuildTool's --explain
+    bool isUpToDate(std::string const& key, std::filesystem::path dst, ShaderHash const& hash, std::string* whyOut = nullptr) {
+        std::string why;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            auto it = def.get_shaders().find(key);
+            if (it == def.get_shaders().end()) {
+                why = "not in cache";
+            } else if (it->second.get_hash() != VulkHasher::toString(hash.hash)) {
+                why = fmt::format("hash changed {} -> {}", it->second.get_hash(), VulkHasher::toString(hash.hash));
+            } else if (!std::filesystem::exists(dst)) {
+                why = fmt::format("{} is missing", dst.string());
+            }
+        }
+        if (why.empty()) {
+            return true;
+        }
+        logger()->trace("{}: {}", key, why);
+        if (whyOut) {
+            *whyOut = why;
+        }
+        return false;
+    }
+
+    void update(std::string const& key, ShaderHash const& hash) {
+        vulk::cpp2::ShaderBuildCacheEntry entry;
+        entry.hash_ref() = VulkHasher::toString(hash.hash);
+        for (auto& include : hash.includes) {
+            entry.includes_ref()->push_back(include.generic_string());
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        def.shaders_ref()[key] = std::move(entry);
+    }
+
+    void save() {
+        std::lock_guard<std::mutex> lock(mutex);
+        writeDefToFile(cacheFile.string(), def);
+    }
+
+   private:
+    std::filesystem::path cacheFile;
+    vulk::cpp2::ShaderBuildCacheDef def;
+    std::mutex mutex;
+
+    static void hashFileAndIncludes(std::filesystem::path const& file,
+                                    std::vector<std::filesystem::path> const& includeDirs,
+                                    VulkHasher& hasher,
+                                    std::set<std::filesystem::path>& visited,
+                                    std::vector<std::filesystem::path>& includesOut) {
+        std::vector<char> contents = readFileIntoMem(file.string());
+        hasher.add(contents.data(), contents.size());
+
+        // this will also pick up includes in comments and #if'd out blocks. that's fine, at worst
+        // we rebuild a shader that didn't need it.
+        static const std::regex includeRegex(R"(^\s*#\s*include\s*([<"])([^>"]+)[>"])");
+        std::istringstream lines(std::string(contents.begin(), contents.end()));
+        std::string line;
+        while (std::getline(lines, line)) {
+            std::smatch match;
+            if (!std::regex_search(line, match, includeRegex)) {
+                continue;
+            }
+            std::string name               = match[2].str();
+            std::filesystem::path resolved = resolveShaderInclude(file, name, match[1].str() == "\"", includeDirs);
+            if (resolved.empty()) {
+                logger()->trace("{}: can't find include {}", file.string(), name);
+                hasher.add("missing:" + name);
+                continue;
+            }
+            resolved = std::filesystem::weakly_canonical(resolved);
+            hasher.add(resolved.generic_string());
+            if (visited.insert(resolved).second) {
+                includesOut.push_back(resolved);
+                hashFileAndIncludes(resolved, includeDirs, hasher, visited, includesOut);
+            }
+        }
+    }
+};
@@ -0,0 +1,120 @@
+#include "ShaderCompiler.h"
+
+#include <shaderc/shaderc.hpp>
+#include <unordered_map>
+
+#include "Vulk/VulkUtil.h"
+
+namespace fs = std::filesystem;
+
+fs::path resolveShaderInclude(fs::path const& includingFile,
+                              std::string const& name,
+                              bool quoted,
+                              std::vector<fs::path> const& includeDirs) {
+    if (quoted && fs::exists(includingFile.parent_path() / name)) {
+        return includingFile.parent_path() / name;
+    }
+    for (auto& dir : includeDirs) {
+        if (fs::exists(dir / name)) {
+            return dir / name;
+        }
+    }
+    return {};
+}
+
+std::shared_ptr<const std::string> ShaderIncludeCache::get(fs::path const& path) {
+    std::string key = path.string();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = files.find(key);
+        if (it != files.end()) {
+            return it->second;
+        }
+    }
+    std::vector<char> mem = readFileIntoMem(key);
+    auto contents         = std::make_shared<const std::string>(mem.begin(), mem.end());
+    std::lock_guard<std::mutex> lock(mutex);
+    return files.emplace(key, contents).first->second;
+}
+
+namespace {
+
+// shaderc hands this back to us in ReleaseInclude, it owns the memory the result points at
+struct IncludeResult : shaderc_include_result {
+    std::string sourceName;
+    std::shared_ptr<const std::string> contents;
+    std::string errorMsg;
+};
+
+class Includer : public shaderc::CompileOptions::IncluderInterface {
+   public:
+    Includer(std::vector<fs::path> includeDirs, ShaderIncludeCache& includeCache)
+        : includeDirs(includeDirs), includeCache(includeCache) {}
+
+    shaderc_include_result* GetInclude(const char* requestedSource,
+                                       shaderc_include_type type,
+                                       const char* requestingSource,
+                                       size_t /*includeDepth*/) override {
+        IncludeResult* result = new IncludeResult{};
+        fs::path resolved =
+            resolveShaderInclude(requestingSource, requestedSource, type == shaderc_include_type_relative, includeDirs);
+        if (resolved.empty()) {
+            // an empty source name tells shaderc the include failed, and the content is the error
+            result->errorMsg       = fmt::format("Can't find include {} from {}", requestedSource, requestingSource);
+            result->content        = result->errorMsg.c_str();
+            result->content_length = result->errorMsg.size();
+        } else {
+            result->sourceName     = resolved.string();
+            result->contents       = includeCache.get(resolved);
+            result->content        = result->contents->c_str();
+            result->content_length = result->contents->size();
+        }
+        result->source_name        = result->sourceName.c_str();
+        result->source_name_length = result->sourceName.size();
+        return result;
+    }
+
+    void ReleaseInclude(shaderc_include_result* data) override {
+        delete static_cast<IncludeResult*>(data);
+    }
+
+   private:
+    std::vector<fs::path> includeDirs;
+    ShaderIncludeCache& includeCache;
+};
+
+shaderc_shader_kind shaderKindFromPath(fs::path const& src) {
+    static const std::unordered_map<std::string, shaderc_shader_kind> kinds = {
+        {".vert", shaderc_vertex_shader},
+        {".geom", shaderc_geometry_shader},
+        {".frag", shaderc_fragment_shader},
+    };
+    auto it = kinds.find(src.extension().string());
+    VULK_ASSERT(it != kinds.end(), "Unknown shader type: {}", src.string());
+    return it->second;
+}
+
+}  // namespace
+
+std::vector<uint32_t> compileShaderInProcess(fs::path const& src,
+                                             std::vector<fs::path> const& includeDirs,
+                                             ShaderIncludeCache& includeCache) {
+    // creating a compiler initializes glslang, so only do it once per thread
+    thread_local shaderc::Compiler compiler;
+    VULK_ASSERT(compiler.IsValid(), "Failed to create shaderc compiler");
+
+    shaderc::CompileOptions options;
+    options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_3);
+    options.SetGenerateDebugInfo();
+    options.SetOptimizationLevel(shaderc_optimization_level_zero);
+    options.SetIncluder(std::make_unique<Includer>(includeDirs, includeCache));
+
+    std::vector<char> source = readFileIntoMem(src.string());
+    shaderc::SpvCompilationResult result =
+        compiler.CompileGlslToSpv(source.data(), source.size(), shaderKindFromPath(src), src.string().c_str(), options);
+    VULK_ASSERT(result.GetCompilationStatus() == shaderc_compilation_status_success,
+                "Failed to compile shader: {}, output:\n{}",
+                src.string(),
+                result.GetErrorMessage());
+    return {result.cbegin(), result.cend()};
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// how BuildTool turns glsl into SPIR-V
+enum class ShaderCompilerBackend {
+    Glslc,    // spawn a glslc process per shader
+    Shaderc,  // compile in process with libshaderc, one compiler per worker thread
+};
+
+// Finds an #include the same way glslc does: "quoted" names are looked for next to the
+// including file first, then in includeDirs in order. <angled> names only look in includeDirs.
+// Returns an empty path if it can't be found.
+extern std::filesystem::path resolveShaderInclude(std::filesystem::path const& includingFile,
+                                                  std::string const& name,
+                                                  bool quoted,
+                                                  std::vector<std::filesystem::path> const& includeDirs);
+
+// The contents of every file #included during one build. Shared by all the worker threads'
+// compilers so something like common.glsl is read from disk once instead of once per shader.
+// Make one per build: nothing is ever re-read, so a later build would see stale headers.
+class ShaderIncludeCache {
+   public:
+    std::shared_ptr<const std::string> get(std::filesystem::path const& path);
+
+   private:
+    std::mutex mutex;
+    std::unordered_map<std::string, std::shared_ptr<const std::string>> files;
+};
+
+// Compiles the glsl shader on the calling thread using the same settings as the glslc path
+// (debug info, vulkan 1.3, no optimization) and returns the SPIR-V. Throws with the compiler
+// output on failure. Safe to call from multiple threads at once.
+extern std::vector<uint32_t> compileShaderInProcess(std::filesystem::path const& src,
+                                                    std::vector<std::filesystem::path> const& includeDirs,
+                                                    ShaderIncludeCache& includeCache);
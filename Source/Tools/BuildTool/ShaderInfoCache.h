@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Vulk/VulkHash.h"
+#include "Vulk/VulkLogger.h"
+#include "Vulk/VulkResourceMetadata.h"
+
+// Memoizes shader reflection keyed on the hash of the SPIR-V, so a shader shared by many
+// pipelines (e.g. PosPassthru) is reflected once per build, and with load/save a shader that
+// hasn't changed since the last build isn't reflected at all. Make one per build: save only
+// keeps what that build looked up, so edited shaders don't pile up in the file.
+//
+// Thread safe: if several pipelines ask for the same new shader at once, one of them
+// reflects it and the rest wait for the result.
+class ShaderInfoCache {
+    static std::shared_ptr<spdlog::logger> logger() {
+        static std::shared_ptr<spdlog::logger> logger;
+        static std::once_flag flag;
+        std::call_once(flag, []() { logger = VulkLogger::CreateLogger("ShaderInfoCache"); });
+        return logger;
+    }
+
+   public:
+    // bump this whenever the reflection changes what it puts in a ShaderInfoDef
+    static constexpr int32_t VERSION = 1;
+
+    using ReflectFn = std::function<vulk::cpp2::ShaderInfoDef(std::vector<uint32_t> const&)>;
+
+    vulk::cpp2::ShaderInfoDef get(std::vector<uint32_t> const& spirv, ReflectFn const& reflect) {
+        uint64_t hash = VulkHasher().addValue(VERSION).add(spirv.data(), spirv.size() * sizeof(uint32_t)).get();
+
+        std::promise<vulk::cpp2::ShaderInfoDef> promise;
+        std::shared_future<vulk::cpp2::ShaderInfoDef> future;
+        bool reflectHere = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            used.insert(hash);
+            auto it = entries.find(hash);
+            if (it != entries.end()) {
+                hits++;
+                future = it->second;
+            } else {
+                misses++;
+                future = promise.get_future().share();
+                entries.emplace(hash, future);
+                reflectHere = true;
+            }
+        }
+
+        // we added the entry so it's on us to fill it in. failures are passed on to anyone waiting.
+        if (reflectHere) {
+            try {
+                promise.set_value(reflect(spirv));
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+            }
+        }
+        return future.get();
+    }
+
+    void load(std::filesystem::path cacheFile) {
+        if (!std::filesystem::exists(cacheFile)) {
+            return;
+        }
+        vulk::cpp2::ShaderInfoCacheDef def;
+        try {
+            readDefFromFile(cacheFile.string(), def);
+        } catch (std::exception& e) {
+            logger()->warn("Ignoring unreadable shader info cache {}: {}", cacheFile.string(), e.what());
+            return;
+        }
+        if (def.get_version() != VERSION) {
+            logger()->info("Shader info cache {} is version {}, ignoring", cacheFile.string(), def.get_version());
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& [hashStr, info] : def.get_shaders()) {
+            std::promise<vulk::cpp2::ShaderInfoDef> promise;
+            promise.set_value(info);
+            entries.emplace(std::stoull(hashStr, nullptr, 16), promise.get_future().share());
+        }
+    }
+
+    // only saves the shaders looked up since this was made that reflected successfully
+    void save(std::filesystem::path cacheFile) {
+        vulk::cpp2::ShaderInfoCacheDef def;
+        def.version_ref() = VERSION;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto& [hash, future] : entries) {
+                if (!used.contains(hash)) {
+                    continue;
+                }
+                try {
+                    def.shaders_ref()[VulkHasher::toString(hash)] = future.get();
+                } catch (...) {
+                }
+            }
+        }
+        writeDefToFile(cacheFile.string(), def);
+        logger()->info("Shader reflection: {} cached, {} reflected", hits.load(), misses.load());
+    }
+
+    // how many lookups weren't in the cache and had to reflect
+    uint32_t numReflected() const {
+        return misses;
+    }
+
+   private:
+    std::mutex mutex;
+    std::unordered_map<uint64_t, std::shared_future<vulk::cpp2::ShaderInfoDef>> entries;
+    std::unordered_set<uint64_t> used;  // looked up by get, the rest came from load and aren't saved
+    std::atomic<uint32_t> hits   = 0;
+    std::atomic<uint32_t> misses = 0;
+};
@@ -100,6 +100,33 @@ TEST_CASE("PipelineBuilder Tests") {  // Define your tests here
         CHECK(info.inputAttachments[GBufBinding::Material].atmtIdx == GBufAtmtIdx::Material);
         CHECK(TEnumTraits<GBufAtmtIdx>::max() == GBufAtmtIdx::Depth);  // to catch if we add more
     }
+    SECTION("Test reflection cache") {
+        fs::path lighting = builtShadersDir / "frag" / "DeferredRenderLighting.fragspv";
+        fs::path gooch    = builtShadersDir / "frag" / "GoochShading.fragspv";
+        ShaderInfoCache cache;
+        ShaderInfo first = PipelineBuilder::getShaderInfo(lighting, &cache);
+        CHECK(PipelineBuilder::getShaderInfo(lighting, &cache).inputAttachments.size() == first.inputAttachments.size());
+        PipelineBuilder::getShaderInfo(gooch, &cache);
+        CHECK(cache.numReflected() == 2);
+
+        // a fresh cache loaded from disk shouldn't need to reflect at all
+        fs::path cacheFile = fs::temp_directory_path() / "VulkShaderInfoCacheTest.json";
+        cache.save(cacheFile);
+        ShaderInfoCache loaded;
+        loaded.load(cacheFile);
+        CHECK(PipelineBuilder::getShaderInfo(lighting, &loaded).inputAttachments.size() == first.inputAttachments.size());
+        CHECK(loaded.numReflected() == 0);
+
+        // only what was looked up is saved, so gooch is dropped
+        loaded.save(cacheFile);
+        ShaderInfoCache pruned;
+        pruned.load(cacheFile);
+        PipelineBuilder::getShaderInfo(lighting, &pruned);
+        CHECK(pruned.numReflected() == 0);
+        PipelineBuilder::getShaderInfo(gooch, &pruned);
+        CHECK(pruned.numReflected() == 1);
+        fs::remove(cacheFile);
+    }
     SECTION("Test Pipeline Generation") {
         SrcPipelineDef def          = makeTestGeomShaderPipelineDeclDef();
         vulk::cpp2::PipelineDef res = PipelineBuilder::buildPipeline(def, builtShadersDir);
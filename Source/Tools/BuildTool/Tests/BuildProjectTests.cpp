@@ -3,6 +3,7 @@
 
 #include <thrift/lib/cpp/util/EnumUtils.h>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <memory>
 
@@ -77,3 +78,151 @@ Mode                 LastWriteTime         Length Name
     vulk::cpp2::DescriptorSetDef descriptorSetDef = pipelineDef.get_descriptorSetDef();
     REQUIRE(descriptorSetDef.get_uniformBuffers().size() == 2);
 }
+
+TEST_CASE("parallel project build matches a serial one") {
+    std::filesystem::path projectFile = std::filesystem::path(__FILE__).parent_path() / "TestProjDir" / "test.proj";
+    fs::path serialDir                = "./TestProjBuildDirSerial";
+    fs::path parallelDir              = "./TestProjBuildDirParallel";
+    std::filesystem::remove_all(serialDir);
+    std::filesystem::remove_all(parallelDir);
+    fs::create_directories(serialDir);
+    fs::create_directories(parallelDir);
+    buildProjectDef(projectFile, serialDir, {.numThreads = 1});
+    buildProjectDef(projectFile, parallelDir, {.numThreads = 8});
+
+    for (std::string pipeline : {"test.pipeline", "DebugNormals.pipeline"}) {
+        vulk::cpp2::PipelineDef serialDef, parallelDef;
+        readDefFromFile((serialDir / "Assets" / "Pipelines" / pipeline).string(), serialDef);
+        readDefFromFile((parallelDir / "Assets" / "Pipelines" / pipeline).string(), parallelDef);
+        CHECK(serialDef == parallelDef);
+    }
+}
+
+TEST_CASE("in process shader compiler matches glslc") {
+    std::filesystem::path projectFile = std::filesystem::path(__FILE__).parent_path() / "TestProjDir" / "test.proj";
+    fs::path glslcDir                 = "./TestProjBuildDirGlslc";
+    fs::path shadercDir               = "./TestProjBuildDirShaderc";
+    std::filesystem::remove_all(glslcDir);
+    std::filesystem::remove_all(shadercDir);
+    fs::create_directories(glslcDir);
+    fs::create_directories(shadercDir);
+    buildProjectDef(projectFile, glslcDir, {.shaderCompiler = ShaderCompilerBackend::Glslc});
+    buildProjectDef(projectFile, shadercDir, {.shaderCompiler = ShaderCompilerBackend::Shaderc});
+
+    REQUIRE(fs::exists(shadercDir / "Assets" / "Shaders" / "vert" / "test.vertspv"));
+    for (std::string pipeline : {"test.pipeline", "DebugNormals.pipeline"}) {
+        vulk::cpp2::PipelineDef glslcDef, shadercDef;
+        readDefFromFile((glslcDir / "Assets" / "Pipelines" / pipeline).string(), glslcDef);
+        readDefFromFile((shadercDir / "Assets" / "Pipelines" / pipeline).string(), shadercDef);
+        CHECK(glslcDef == shadercDef);
+    }
+}
+
+TEST_CASE("compact project build loads the same as json") {
+    std::filesystem::path projectFile = std::filesystem::path(__FILE__).parent_path() / "TestProjDir" / "test.proj";
+    fs::path jsonDir                  = "./TestProjBuildDirJson";
+    fs::path compactDir               = "./TestProjBuildDirCompact";
+    std::filesystem::remove_all(jsonDir);
+    std::filesystem::remove_all(compactDir);
+    fs::create_directories(jsonDir);
+    fs::create_directories(compactDir);
+    buildProjectDef(projectFile, jsonDir, {.outputFormat = VulkDefFormat::Json});
+    buildProjectDef(projectFile, compactDir, {.outputFormat = VulkDefFormat::Compact});
+
+    vulk::cpp2::ProjectDef jsonProj, compactProj;
+    readDefFromFile((jsonDir / "test.proj").string(), jsonProj);
+    readDefFromFile((compactDir / "test.proj").string(), compactProj);
+    CHECK(jsonProj == compactProj);
+    for (std::string pipeline : {"test.pipeline", "DebugNormals.pipeline"}) {
+        vulk::cpp2::PipelineDef jsonDef, compactDef;
+        readDefFromFile((jsonDir / "Assets" / "Pipelines" / pipeline).string(), jsonDef);
+        readDefFromFile((compactDir / "Assets" / "Pipelines" / pipeline).string(), compactDef);
+        CHECK(jsonDef == compactDef);
+    }
+}
+
+TEST_CASE("packed assets match the built files") {
+    std::filesystem::path projectFile = std::filesystem::path(__FILE__).parent_path() / "TestProjDir" / "test.proj";
+    fs::path buildDir                 = "./TestProjBuildDirPacked";
+    std::filesystem::remove_all(buildDir);
+    fs::create_directories(buildDir);
+    buildProjectDef(projectFile, buildDir, {.pack = true});
+
+    fs::path assetsDir = buildDir / "Assets";
+    REQUIRE(fs::exists(VulkAssetPack::packFileFor(assetsDir)));
+    auto pack = VulkAssetPack::open(VulkAssetPack::packFileFor(assetsDir), assetsDir);
+    CHECK(pack->contains(assetsDir / "Shaders" / "vert" / "test.vertspv"));
+    CHECK(pack->contains(assetsDir / "Pipelines" / "test.pipeline"));
+    CHECK(!pack->contains(assetsDir / "NotAFile.txt"));
+
+    size_t numFiles = 0;
+    for (auto const& entry : fs::recursive_directory_iterator(assetsDir)) {
+        if (!entry.is_regular_file()) {
+            continue;
+        }
+        numFiles++;
+        std::vector<char> onDisk   = readFileIntoMem(entry.path().string());
+        std::span<char const> blob = pack->find(entry.path());
+        CHECK(std::equal(onDisk.begin(), onDisk.end(), blob.begin(), blob.end()));
+        CHECK((uintptr_t)blob.data() % VulkAssetPack::ALIGNMENT == 0);
+    }
+    CHECK(pack->paths().size() == numFiles);
+
+    vulk::cpp2::PipelineDef fromPack, fromDisk;
+    readDefFromAssets(pack.get(), assetsDir / "Pipelines" / "test.pipeline", fromPack);
+    readDefFromFile((assetsDir / "Pipelines" / "test.pipeline").string(), fromDisk);
+    CHECK(fromPack == fromDisk);
+
+    // building without --pack shouldn't leave the old pack behind
+    pack.reset();
+    buildProjectDef(projectFile, buildDir);
+    CHECK(!fs::exists(VulkAssetPack::packFileFor(assetsDir)));
+}
+
+TEST_CASE("incremental project build only redoes what changed") {
+    // work on a copy of the project so the sources can be edited
+    fs::path srcDir   = "./TestProjIncrementalSrc";
+    fs::path buildDir = "./TestProjBuildDirIncremental";
+    std::filesystem::remove_all(srcDir);
+    std::filesystem::remove_all(buildDir);
+    fs::copy(fs::path(__FILE__).parent_path() / "TestProjDir", srcDir, fs::copy_options::recursive);
+    fs::create_directories(buildDir);
+    buildProjectDef(srcDir / "test.proj", buildDir, {.explain = true});
+
+    fs::path testPipeline  = buildDir / "Assets" / "Pipelines" / "test.pipeline";
+    fs::path debugPipeline = buildDir / "Assets" / "Pipelines" / "DebugNormals.pipeline";
+    fs::path builtProject  = buildDir / "test.proj";
+    fs::path enumsHeader   = buildDir / "Assets" / "common" / "VulkShaderEnums_generated.glsl";
+    auto testTime          = fs::last_write_time(testPipeline);
+    auto debugTime         = fs::last_write_time(debugPipeline);
+    auto projectTime       = fs::last_write_time(builtProject);
+    auto enumsTime         = fs::last_write_time(enumsHeader);
+
+    SECTION("nothing changed") {
+        buildProjectDef(srcDir / "test.proj", buildDir, {.explain = true});
+        CHECK(fs::last_write_time(testPipeline) == testTime);
+        CHECK(fs::last_write_time(debugPipeline) == debugTime);
+        CHECK(fs::last_write_time(builtProject) == projectTime);
+        CHECK(fs::last_write_time(enumsHeader) == enumsTime);
+    }
+    SECTION("touching a file without changing it") {
+        fs::path src = srcDir / "Assets" / "Pipelines" / "test.pipeline";
+        fs::last_write_time(src, fs::file_time_type::clock::now());
+        buildProjectDef(srcDir / "test.proj", buildDir, {.explain = true});
+        CHECK(fs::last_write_time(testPipeline) == testTime);
+    }
+    SECTION("changing one pipeline") {
+        fs::path src = srcDir / "Assets" / "Pipelines" / "test.pipeline";
+        std::ofstream(src, std::ios::app) << "\n";
+        buildProjectDef(srcDir / "test.proj", buildDir, {.explain = true});
+        CHECK(fs::last_write_time(testPipeline) != testTime);
+        CHECK(fs::last_write_time(debugPipeline) == debugTime);
+        CHECK(fs::last_write_time(builtProject) == projectTime);
+    }
+    SECTION("missing outputs are rebuilt") {
+        fs::remove(debugPipeline);
+        buildProjectDef(srcDir / "test.proj", buildDir, {.explain = true});
+        CHECK(fs::exists(debugPipeline));
+        CHECK(fs::last_write_time(testPipeline) == testTime);
+    }
+}
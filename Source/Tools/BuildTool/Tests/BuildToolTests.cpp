@@ -29,6 +29,25 @@ TEST_CASE("basic Pipeline serialization") {
     REQUIRE(def == def2);
 }
 
+TEST_CASE("binary def formats") {
+    vulk::cpp2::PipelineDef def;
+    def.version_ref()           = 1;
+    def.name_ref()              = "TestPipeline";
+    def.vertShader_ref()        = "test.vert.spv";
+    def.fragShader_ref()        = "test.frag.spv";
+    def.primitiveTopology_ref() = vulk::cpp2::VulkPrimitiveTopology::TriangleStrip;
+    def.vertInputs_ref()->push_back(vulk::cpp2::VulkShaderLocation::Pos);
+    writeDefToFile("test_json.pipeline", def);
+    for (VulkDefFormat format : {VulkDefFormat::Compact, VulkDefFormat::Binary}) {
+        writeDefToFile("test_binary.pipeline", def, format);
+        CHECK(fs::file_size("test_binary.pipeline") < fs::file_size("test_json.pipeline"));
+
+        vulk::cpp2::PipelineDef def2;
+        readDefFromFile("test_binary.pipeline", def2);
+        CHECK(def == def2);
+    }
+}
+
 TEST_CASE("basic Scene serialization") {
     vulk::cpp2::SceneDef def;
     def.name_ref() = "TestScene";
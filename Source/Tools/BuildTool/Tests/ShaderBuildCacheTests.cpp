@@ -0,0 +1,70 @@
+#include <catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+#include "../ShaderBuildCache.h"
+#include "../ShaderCompiler.h"
+
+namespace fs = std::filesystem;
+
+static void writeFile(fs::path path, std::string contents) {
+    std::ofstream out(path, std::ios::binary);
+    out << contents;
+}
+
+TEST_CASE("shader build cache hashes includes") {
+    fs::path dir        = "./ShaderBuildCacheTestDir";
+    fs::path includeDir = dir / "include";
+    fs::remove_all(dir);
+    fs::create_directories(includeDir);
+
+    writeFile(dir / "test.vert", "#version 450\n#include \"a.glsl\"\nvoid main() {}\n");
+    writeFile(includeDir / "a.glsl", "#include <b.glsl>\nconst int a = 1;\n");
+    writeFile(includeDir / "b.glsl", "const int b = 2;\n");
+    std::vector<fs::path> includeDirs = {includeDir};
+
+    ShaderBuildCache::ShaderHash hash = ShaderBuildCache::hashShader(dir / "test.vert", includeDirs, "-g");
+    REQUIRE(hash.includes.size() == 2);
+
+    SECTION("unchanged files hash the same") {
+        writeFile(dir / "test.vert", "#version 450\n#include \"a.glsl\"\nvoid main() {}\n");
+        CHECK(ShaderBuildCache::hashShader(dir / "test.vert", includeDirs, "-g").hash == hash.hash);
+    }
+    SECTION("changing a nested include changes the hash") {
+        writeFile(includeDir / "b.glsl", "const int b = 3;\n");
+        CHECK(ShaderBuildCache::hashShader(dir / "test.vert", includeDirs, "-g").hash != hash.hash);
+    }
+    SECTION("changing the options changes the hash") {
+        CHECK(ShaderBuildCache::hashShader(dir / "test.vert", includeDirs, "-g -O0").hash != hash.hash);
+    }
+    SECTION("entries persist") {
+        writeFile(dir / "test.vertspv", "spv");
+        {
+            ShaderBuildCache cache(dir / "cache.json");
+            CHECK(!cache.isUpToDate("vert/test.vertspv", dir / "test.vertspv", hash));
+            cache.update("vert/test.vertspv", hash);
+            cache.save();
+        }
+        ShaderBuildCache cache(dir / "cache.json");
+        CHECK(cache.isUpToDate("vert/test.vertspv", dir / "test.vertspv", hash));
+        fs::remove(dir / "test.vertspv");
+        CHECK(!cache.isUpToDate("vert/test.vertspv", dir / "test.vertspv", hash));
+    }
+}
+
+TEST_CASE("shader include cache is per build") {
+    fs::path dir = "./ShaderIncludeCacheTestDir";
+    fs::remove_all(dir);
+    fs::create_directories(dir);
+    writeFile(dir / "a.glsl", "const int a = 1;\n");
+
+    ShaderIncludeCache firstBuild;
+    CHECK(*firstBuild.get(dir / "a.glsl") == "const int a = 1;\n");
+
+    // an edit between builds is picked up by the next build's cache, while a cache keeps what it read
+    writeFile(dir / "a.glsl", "const int a = 2;\n");
+    CHECK(*firstBuild.get(dir / "a.glsl") == "const int a = 1;\n");
+    ShaderIncludeCache secondBuild;
+    CHECK(*secondBuild.get(dir / "a.glsl") == "const int a = 2;\n");
+}
@@ -1,7 +1,26 @@
 #define CATCH_CONFIG_MAIN  // This tells Catch to provide a main() - only do this in one cpp file
 #include <catch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <numeric>
+#include <random>
+#include <set>
+#include <thread>
 
 #include "Vulk/Vulk.h"
+#include "Vulk/VulkAsyncCache.h"
+#include "Vulk/VulkCookedTexture.h"
+#include "Vulk/VulkDescriptorAllocator.h"
+#include "Vulk/VulkDrawList.h"
+#include "Vulk/VulkGeo.h"
+#include "Vulk/VulkMemoryAllocator.h"
+#include "Vulk/VulkMesh.h"
+#include "Vulk/VulkMeshOptimizer.h"
+#include "Vulk/VulkPipelineCache.h"
+#include "Vulk/VulkTextureCache.h"
+#include "Vulk/VulkThreadPool.h"
+#include "Vulk/VulkVertexLayout.h"
 
 void testAssertPasses() {
     VULK_ASSERT(true);
@@ -37,3 +56,697 @@ TEST_CASE("VulkException tests") {
     REQUIRE_THROWS(testAssertFails());
     REQUIRE_THROWS(testAssertMsgFails());
 }
+
+TEST_CASE("cooked mesh round trip") {
+    VulkMesh mesh;
+    makeGeoSphere(1.0f, 2, mesh);
+    REQUIRE(mesh.vertices.size() > 0);
+    REQUIRE(mesh.getDrawRanges().size() == 1);
+    CHECK(mesh.getDrawRanges()[0].indexCount == mesh.indices.size());
+    uint32_t half  = (uint32_t)(mesh.indices.size() / 6 * 3);
+    mesh.submeshes = {{"top", 0, 0, half}, {"bottom", 0, half, (uint32_t)mesh.indices.size() - half}};
+
+    std::filesystem::path cookedFile = "TestSphere" + std::string(VulkMesh::COOKED_EXT);
+    mesh.writeCooked(cookedFile);
+    VulkMesh cooked = VulkMesh::loadFromAssets(nullptr, cookedFile, "TestSphere");
+    CHECK(cooked.name == "TestSphere");
+    CHECK(cooked.indices == mesh.indices);
+    REQUIRE(cooked.submeshes.size() == 2);
+    CHECK(cooked.submeshes[1].name == "bottom");
+    CHECK(cooked.submeshes[1].firstIndex == half);
+    CHECK(cooked.submeshes[1].indexCount == mesh.submeshes[1].indexCount);
+    CHECK(cooked.getDrawRanges().size() == 2);
+    REQUIRE(cooked.vertices.size() == mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        CHECK(cooked.vertices[i].pos == mesh.vertices[i].pos);
+        CHECK(cooked.vertices[i].normal == mesh.vertices[i].normal);
+        CHECK(cooked.vertices[i].tangent == mesh.vertices[i].tangent);
+        CHECK(cooked.vertices[i].uv == mesh.vertices[i].uv);
+    }
+
+    std::vector<char> data = readFileIntoMem(cookedFile.string());
+    data.pop_back();
+    REQUIRE_THROWS(VulkMesh::loadCooked(data, "truncated"));
+    std::filesystem::remove(cookedFile);
+}
+
+TEST_CASE("mesh optimizer") {
+    VulkMesh sphere;
+    makeGeoSphere(1.0f, 3, sphere);
+
+    // the worst case: a vertex per triangle corner, triangles in random order
+    std::vector<uint32_t> tris(sphere.indices.size() / 3);
+    std::iota(tris.begin(), tris.end(), 0);
+    std::shuffle(tris.begin(), tris.end(), std::mt19937(42));
+    VulkMesh mesh;
+    mesh.name = "shuffled";
+    for (uint32_t t : tris) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            mesh.indices.push_back((uint32_t)mesh.vertices.size());
+            mesh.vertices.push_back(sphere.vertices[sphere.indices[t * 3 + c]]);
+        }
+    }
+    VulkVertexCacheStats before = VulkMeshOptimizer::analyzeVertexCache(mesh);
+    CHECK(before.acmr == 3.0f);
+    CHECK(before.atvr == 1.0f);
+
+    auto sortedTriangles = [](VulkMesh const& m) {
+        std::vector<std::vector<float>> out;
+        for (size_t i = 0; i < m.indices.size(); i += 3) {
+            std::vector<std::vector<float>> corners;
+            for (size_t c = 0; c < 3; ++c) {
+                glm::vec3 p = m.vertices[m.indices[i + c]].pos;
+                corners.push_back({p.x, p.y, p.z});
+            }
+            // the winding has to survive, so rotate rather than sort the corners
+            std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+            std::vector<float> tri;
+            for (auto& corner : corners) {
+                tri.insert(tri.end(), corner.begin(), corner.end());
+            }
+            out.push_back(tri);
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    };
+    auto trianglesBefore = sortedTriangles(mesh);
+
+    VulkMeshOptimizer::optimize(mesh);
+    VulkVertexCacheStats after = VulkMeshOptimizer::analyzeVertexCache(mesh);
+    CHECK(mesh.vertices.size() <= sphere.vertices.size());
+    CHECK(after.numTriangles == before.numTriangles);
+    CHECK(after.acmr < 1.0f);
+    CHECK(after.atvr < 1.5f);
+    CHECK(sortedTriangles(mesh) == trianglesBefore);
+
+    // fetch order: vertices are first used in order
+    uint32_t nextVertex = 0;
+    for (uint32_t index : mesh.indices) {
+        REQUIRE(index <= nextVertex);
+        nextVertex = std::max(nextVertex, index + 1);
+    }
+    CHECK(nextVertex == mesh.vertices.size());
+}
+
+TEST_CASE("appended meshes are drawn as ranges") {
+    VulkMesh sphere;
+    makeGeoSphere(1.0f, 1, sphere);
+    VulkMesh mesh;
+    mesh.appendMesh(sphere);
+    mesh.appendMesh(sphere);
+    REQUIRE(mesh.getDrawRanges().size() == 2);
+    CHECK(mesh.submeshes[1].firstIndex == sphere.indices.size());
+    CHECK(mesh.submeshes[1].firstVertex == sphere.vertices.size());
+
+    // appending to a mesh without submeshes keeps what was there as a range of its own
+    VulkMesh three = sphere;
+    three.appendMesh(mesh);
+    REQUIRE(three.submeshes.size() == 3);
+    CHECK(three.submeshes[0].indexCount == sphere.indices.size());
+    CHECK(three.submeshes[2].firstIndex + three.submeshes[2].indexCount == three.indices.size());
+}
+
+TEST_CASE("multi-mesh import") {
+    // two objects, each becomes a node with a mesh
+    std::string obj = R"(
+o First
+v 0 0 0
+v 1 0 0
+v 0 1 0
+f 1 2 3
+o Second
+v 0 0 1
+v 1 0 1
+v 0 1 1
+v 1 1 1
+f 4 5 6
+f 5 7 6
+)";
+    VulkMesh mesh = VulkMesh::loadFromMemory(std::span<char const>(obj.data(), obj.size()), "obj", "TwoObjects");
+    REQUIRE(mesh.submeshes.size() == 2);
+    CHECK(mesh.indices.size() == 9);
+    CHECK(mesh.submeshes[0].firstIndex == 0);
+    CHECK(mesh.submeshes[0].indexCount == 3);
+    CHECK(mesh.submeshes[1].firstIndex == 3);
+    CHECK(mesh.submeshes[1].indexCount == 6);
+    CHECK(mesh.submeshes[1].firstVertex > 0);
+    for (VulkMeshRef const& submesh : mesh.submeshes) {
+        for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; ++i) {
+            REQUIRE(mesh.indices[i] >= submesh.firstVertex);
+            REQUIRE(mesh.indices[i] < mesh.vertices.size());
+        }
+    }
+    // everything from the second object is at z = 1
+    for (uint32_t i = mesh.submeshes[1].firstIndex; i < mesh.indices.size(); ++i) {
+        CHECK(mesh.vertices[mesh.indices[i]].pos.z == 1.0f);
+    }
+}
+
+TEST_CASE("vertex layouts") {
+    using Loc = vulk::cpp2::VulkShaderLocation;
+    std::vector<Loc> inputs = {Loc::TexCoord, Loc::Pos, Loc::Normal, Loc::Tangent};
+    Vertex v;
+    v.pos     = {1.0f, 2.0f, 3.0f};
+    v.normal  = glm::normalize(glm::vec3(1.0f, -1.0f, 0.5f));
+    v.tangent = {0.0f, 0.0f, -1.0f};
+    v.uv      = {0.25f, 3.5f};
+    std::vector<Vertex> vertices = {v, v};
+
+    SECTION("separate matches the old per attribute buffers") {
+        VulkVertexLayout layout(vulk::cpp2::VulkVertexLayoutType::Separate, inputs);
+        REQUIRE(layout.bindings.size() == 4);
+        for (auto& attribute : layout.attributes) {
+            CHECK(attribute.binding == (uint32_t)attribute.location);
+            CHECK(attribute.offset == 0);
+        }
+        std::vector<uint8_t> uvs = layout.buildVertexBuffer(layout.bindings.back(), vertices);  // TexCoord is the highest
+        REQUIRE(uvs.size() == 2 * sizeof(glm::vec2));
+        glm::vec2 uv;
+        memcpy(&uv, uvs.data() + sizeof(glm::vec2), sizeof(uv));
+        CHECK(uv == v.uv);
+    }
+
+    SECTION("interleaved") {
+        VulkVertexLayout layout(vulk::cpp2::VulkVertexLayoutType::Interleaved, inputs);
+        REQUIRE(layout.bindings.size() == 1);
+        CHECK(layout.bindings[0].stride == sizeof(Vertex));
+        std::vector<uint8_t> data = layout.buildVertexBuffer(layout.bindings[0], vertices);
+        REQUIRE(data.size() == 2 * sizeof(Vertex));
+        // location order happens to be Vertex's member order
+        CHECK(memcmp(data.data() + sizeof(Vertex), &v, sizeof(Vertex)) == 0);
+    }
+
+    SECTION("packed") {
+        VulkVertexLayout layout(vulk::cpp2::VulkVertexLayoutType::Packed, inputs);
+        REQUIRE(layout.bindings.size() == 1);
+        CHECK(layout.bindings[0].stride == 32);
+        std::vector<uint8_t> data = layout.buildVertexBuffer(layout.bindings[0], vertices);
+        uint8_t const* second     = data.data() + 32;
+        for (auto& attribute : layout.attributes) {
+            CHECK(attribute.offset % 4 == 0);
+            if (attribute.location == Loc::Normal) {
+                uint64_t packed;
+                memcpy(&packed, second + attribute.offset, sizeof(packed));
+                glm::vec4 normal = glm::unpackSnorm4x16(packed);
+                CHECK(glm::length(glm::vec3(normal) - v.normal) < 1e-4f);
+            } else if (attribute.location == Loc::TexCoord) {
+                uint32_t packed;
+                memcpy(&packed, second + attribute.offset, sizeof(packed));
+                CHECK(glm::unpackHalf2x16(packed) == v.uv);  // both exactly representable
+            }
+        }
+    }
+
+    REQUIRE_THROWS(VulkVertexLayout(vulk::cpp2::VulkVertexLayoutType::Interleaved, {Loc::Pos, Loc::Pos}));
+    REQUIRE_THROWS(VulkVertexLayout(vulk::cpp2::VulkVertexLayoutType::Interleaved, {Loc::Color}));
+}
+
+// stands in for the device: hands out fake VkDeviceMemory handles and checks they're freed/unmapped properly
+struct MockDeviceMemory {
+    std::set<VkDeviceMemory> live;
+    std::set<VkDeviceMemory> mapped;
+    std::vector<char> hostMem = std::vector<char>(1 << 20);
+    uintptr_t nextHandle      = 0x1000;
+    uint32_t numAllocs        = 0;
+    bool failAllocs           = false;
+
+    VulkMemoryAllocator::Backend backend() {
+        VulkMemoryAllocator::Backend b;
+        b.allocate = [this](uint32_t, VkDeviceSize, VkDeviceMemory* memoryOut) {
+            if (failAllocs) {
+                return VK_ERROR_OUT_OF_DEVICE_MEMORY;
+            }
+            *memoryOut = reinterpret_cast<VkDeviceMemory>(nextHandle += 0x1000);
+            live.insert(*memoryOut);
+            numAllocs++;
+            return VK_SUCCESS;
+        };
+        b.free = [this](VkDeviceMemory memory) {
+            CHECK(live.erase(memory) == 1);
+            CHECK(!mapped.contains(memory));
+        };
+        b.map = [this](VkDeviceMemory memory) {
+            CHECK(mapped.insert(memory).second);
+            return (void*)hostMem.data();
+        };
+        b.unmap = [this](VkDeviceMemory memory) { CHECK(mapped.erase(memory) == 1); };
+        return b;
+    }
+};
+
+TEST_CASE("memory allocator") {
+    constexpr VkDeviceSize blockSize = 1 << 20;
+    constexpr uint32_t deviceLocal   = 0;
+    constexpr uint32_t hostVisible   = 1;
+    MockDeviceMemory mock;
+    std::vector<VkMemoryPropertyFlags> memoryTypes = {
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+    };
+    auto reqs = [](VkDeviceSize size, VkDeviceSize alignment, uint32_t typeBits = 0x3) {
+        return VkMemoryRequirements{size, alignment, typeBits};
+    };
+
+    {
+        VulkMemoryAllocator allocator(mock.backend(), memoryTypes, blockSize);
+
+        SECTION("sub-allocates aligned ranges out of one block") {
+            VulkAllocation a = allocator.allocate(reqs(100, 1), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+            VulkAllocation b = allocator.allocate(reqs(1000, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+            CHECK(mock.numAllocs == 1);
+            CHECK(a.memory == b.memory);
+            CHECK(a.memoryType == deviceLocal);
+            CHECK(b.offset % 256 == 0);
+            CHECK(b.offset >= a.offset + a.size);
+            CHECK(a.mapped == nullptr);
+
+            VulkMemoryStats stats = allocator.getStats();
+            CHECK(stats.numBlocks == 1);
+            CHECK(stats.numAllocations == 2);
+            CHECK(stats.liveBytes == 1100);
+            CHECK(stats.freeBytes == blockSize - 1100);
+
+            allocator.free(a);
+            CHECK(!a);
+            allocator.free(b);
+            stats = allocator.getStats();
+            CHECK(stats.liveBytes == 0);
+            CHECK(stats.freeBytes == blockSize);  // the alignment padding coalesced back too
+            CHECK(stats.fragmentation() == 0.0f);
+        }
+
+        SECTION("buffers and images never share a block") {
+            VulkAllocation buf = allocator.allocate(reqs(64, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+            VulkAllocation img = allocator.allocate(reqs(64, 16), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+            CHECK(buf.memory != img.memory);
+            allocator.free(buf);
+            allocator.free(img);
+        }
+
+        SECTION("host visible memory is persistently mapped") {
+            VulkAllocation a = allocator.allocate(reqs(64, 64), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+            VulkAllocation b = allocator.allocate(reqs(64, 64), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true);
+            CHECK(a.memoryType == hostVisible);
+            CHECK(mock.mapped.size() == 1);  // once per block, not per allocation
+            CHECK(a.mapped == mock.hostMem.data() + a.offset);
+            CHECK(b.mapped == mock.hostMem.data() + b.offset);
+            allocator.free(a);
+            allocator.free(b);
+        }
+
+        SECTION("large requests get dedicated allocations") {
+            VulkAllocation big    = allocator.allocate(reqs(blockSize, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, false);
+            VulkAllocation forced = allocator.allocate(reqs(256, 256), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true, true);
+            CHECK(big.offset == 0);
+            CHECK(forced.mapped != nullptr);
+            VulkMemoryStats stats = allocator.getStats();
+            CHECK(stats.numBlocks == 0);
+            CHECK(stats.numDedicated == 2);
+            CHECK(stats.reservedBytes == blockSize + 256);
+            allocator.free(big);
+            allocator.free(forced);
+            CHECK(mock.live.empty());
+            CHECK(mock.mapped.empty());
+        }
+
+        SECTION("frees coalesce and refill the holes") {
+            std::vector<VulkAllocation> allocs;
+            for (int i = 0; i < 8; ++i) {
+                allocs.push_back(allocator.allocate(reqs(1024, 1024), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true));
+            }
+            for (int i = 0; i < 8; i += 2) {
+                allocator.free(allocs[i]);
+            }
+            VulkMemoryStats stats = allocator.getStats();
+            CHECK(stats.fragmentation() > 0.0f);
+            CHECK(stats.largestFree == blockSize - 8 * 1024);
+
+            // best fit puts these in the holes rather than the big range at the end
+            for (int i = 0; i < 8; i += 2) {
+                allocs[i] = allocator.allocate(reqs(1024, 1024), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true);
+                CHECK(allocs[i].offset < 8 * 1024);
+            }
+            CHECK(allocator.getStats().fragmentation() == 0.0f);
+            for (VulkAllocation& a : allocs) {
+                allocator.free(a);
+            }
+        }
+
+        SECTION("grows new blocks and keeps only one empty one") {
+            std::vector<VulkAllocation> allocs;
+            for (int i = 0; i < 6; ++i) {
+                allocs.push_back(allocator.allocate(reqs(blockSize / 2, 256), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true));
+            }
+            CHECK(allocator.getStats().numBlocks == 3);
+            for (VulkAllocation& a : allocs) {
+                allocator.free(a);
+            }
+            CHECK(allocator.getStats().numBlocks == 1);
+            CHECK(mock.live.size() == 1);
+        }
+
+        SECTION("randomized allocations never overlap") {
+            std::mt19937 rng(1234);
+            std::vector<VulkAllocation> allocs;
+            for (int i = 0; i < 5000; ++i) {
+                if (!allocs.empty() && rng() % 3 == 0) {
+                    size_t j = rng() % allocs.size();
+                    allocator.free(allocs[j]);
+                    allocs[j] = allocs.back();
+                    allocs.pop_back();
+                    continue;
+                }
+                VkDeviceSize alignment = 1ull << (rng() % 10);
+                VulkAllocation a       = allocator.allocate(reqs(1 + rng() % 10000, alignment), 0, rng() % 2 == 0);
+                REQUIRE(a.offset % alignment == 0);
+                REQUIRE(a.offset + a.size <= blockSize);
+                allocs.push_back(a);
+            }
+
+            std::vector<VulkAllocation> sorted = allocs;
+            std::sort(sorted.begin(), sorted.end(), [](VulkAllocation const& a, VulkAllocation const& b) {
+                return std::tie(a.memory, a.offset) < std::tie(b.memory, b.offset);
+            });
+            VkDeviceSize live = 0;
+            for (size_t i = 0; i < sorted.size(); ++i) {
+                live += sorted[i].size;
+                if (i > 0 && sorted[i].memory == sorted[i - 1].memory) {
+                    REQUIRE(sorted[i].offset >= sorted[i - 1].offset + sorted[i - 1].size);
+                }
+            }
+            VulkMemoryStats stats = allocator.getStats();
+            CHECK(stats.liveBytes == live);
+            CHECK(stats.liveBytes + stats.freeBytes == stats.reservedBytes);
+
+            for (VulkAllocation& a : allocs) {
+                allocator.free(a);
+            }
+            stats = allocator.getStats();
+            CHECK(stats.freeBytes == stats.reservedBytes);
+            CHECK(stats.fragmentation() == 0.0f);
+        }
+
+        SECTION("errors") {
+            REQUIRE_THROWS(allocator.allocate(reqs(64, 1, 0x1), VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, true));
+            mock.failAllocs = true;
+            REQUIRE_THROWS(allocator.allocate(reqs(64, 1), VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, true));
+            CHECK(allocator.getStats().numAllocations == 0);
+        }
+    }
+
+    // destroying the allocator gives everything back
+    CHECK(mock.live.empty());
+    CHECK(mock.mapped.empty());
+}
+
+TEST_CASE("thread pool and async cache") {
+    SECTION("tasks run and exceptions reach the future") {
+        VulkThreadPool pool(4);
+        std::vector<std::future<int>> futures;
+        for (int i = 0; i < 100; ++i) {
+            futures.push_back(pool.submit([i]() { return i * i; }));
+        }
+        for (int i = 0; i < 100; ++i) {
+            CHECK(futures[i].get() == i * i);
+        }
+        std::future<int> failed = pool.submit([]() -> int { VULK_THROW("load failed"); });
+        REQUIRE_THROWS_AS(failed.get(), VulkException);
+    }
+
+    SECTION("tasks can wait on tasks submitted before them") {
+        // with one thread a task waiting on a later one would hang
+        for (uint32_t numThreads : {1u, 3u}) {
+            VulkThreadPool pool(numThreads);
+            std::vector<std::shared_future<int>> leaves;
+            for (int i = 0; i < 10; ++i) {
+                leaves.push_back(pool.submit([i]() { return i; }).share());
+            }
+            std::future<int> sum = pool.submit([leaves]() {
+                int total = 0;
+                for (auto& leaf : leaves) {
+                    total += leaf.get();
+                }
+                return total;
+            });
+            CHECK(sum.get() == 45);
+        }
+    }
+
+    SECTION("destroying the pool finishes what's queued") {
+        std::atomic<int> ran = 0;
+        {
+            VulkThreadPool pool(2);
+            for (int i = 0; i < 50; ++i) {
+                pool.submit([&ran]() { ran++; });
+            }
+        }
+        CHECK(ran == 50);
+    }
+
+    SECTION("cache loads each key once") {
+        VulkThreadPool pool(4);
+        VulkAsyncCache<const int> cache;
+        std::atomic<int> loads = 0;
+        auto get               = [&](std::string const& key) {
+            return cache.getOrLoad(key, [&]() {
+                return pool.submit([&loads, key]() {
+                    loads++;
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    return std::make_shared<const int>((int)key.size());
+                });
+            });
+        };
+
+        // ask for the same things from several threads while they're still loading
+        std::vector<std::thread> threads;
+        std::vector<VulkFuture<const int>> results(8);
+        for (int i = 0; i < 8; ++i) {
+            threads.emplace_back([&, i]() { results[i] = get(i % 2 ? "a" : "bb"); });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        CHECK(loads == 2);
+        for (int i = 0; i < 8; ++i) {
+            CHECK(*results[i].get() == (i % 2 ? 1 : 2));
+            CHECK(results[i].get() == cache.at(i % 2 ? "a" : "bb").get());
+        }
+        CHECK(cache.contains("a"));
+        CHECK(!cache.contains("c"));
+        REQUIRE_THROWS(cache.at("c"));
+    }
+
+    SECTION("deferred loads run on the first get") {
+        VulkAsyncCache<const int> cache;
+        int loads = 0;
+        auto load = [&]() { return std::async(std::launch::deferred, [&]() { return std::make_shared<const int>(++loads); }); };
+        VulkFuture<const int> first = cache.getOrLoad("x", load);
+        CHECK(loads == 0);
+        CHECK(*first.get() == 1);
+        CHECK(*cache.getOrLoad("x", load).get() == 1);
+        CHECK(loads == 1);
+    }
+}
+
+TEST_CASE("texture cache") {
+    // a 2x1 binary ppm: red, then blue. stb decodes it to RGBA with alpha 255
+    std::string ppm = "P6\n2 1\n255\n";
+    ppm += std::string("\xff\x00\x00\x00\x00\xff", 6);
+    std::vector<uint8_t> const expected = {255, 0, 0, 255, 0, 0, 255, 255};
+
+    std::filesystem::path cacheDir = "TestTextureCache.texcache";
+    std::filesystem::remove_all(cacheDir);
+    CHECK(VulkTextureCache::cacheDirFor("Foo/Assets/") == std::filesystem::path("Foo/Assets.texcache"));
+
+    {
+        VulkTextureCache cache(cacheDir);
+        VulkDecodedImage image = cache.decode(ppm, "test.ppm");
+        CHECK(image.width == 2);
+        CHECK(image.height == 1);
+        CHECK(image.pixels == expected);
+        CHECK(cache.numMisses() == 1);
+        CHECK(cache.decode(ppm, "test.ppm").pixels == expected);
+        CHECK(cache.numHits() == 1);
+    }
+
+    // a new cache, e.g. the next run, reads what the last one wrote
+    std::vector<std::filesystem::path> entries(std::filesystem::directory_iterator(cacheDir), {});
+    REQUIRE(entries.size() == 1);
+    {
+        VulkTextureCache cache(cacheDir);
+        CHECK(cache.decode(ppm, "test.ppm").pixels == expected);
+        CHECK(cache.numHits() == 1);
+        CHECK(cache.numMisses() == 0);
+    }
+
+    // a bad entry is decoded again and replaced
+    std::filesystem::resize_file(entries[0], sizeof(VulkDecodedImageHeader) + 1);
+    {
+        VulkTextureCache cache(cacheDir);
+        CHECK(cache.decode(ppm, "test.ppm").pixels == expected);
+        CHECK(cache.numMisses() == 1);
+        CHECK(cache.decode(ppm, "test.ppm").pixels == expected);
+        CHECK(cache.numHits() == 1);
+    }
+
+    // so is one whose header asks for more pixels than the file has
+    {
+        std::fstream file(entries[0], std::ios::binary | std::ios::in | std::ios::out);
+        VulkDecodedImageHeader header;
+        REQUIRE(file.read((char*)&header, sizeof(header)));
+        header.width = header.height = 0x10000;
+        file.seekp(0);
+        file.write((char const*)&header, sizeof(header));
+    }
+    {
+        VulkTextureCache cache(cacheDir);
+        CHECK(cache.decode(ppm, "test.ppm").pixels == expected);
+        CHECK(cache.numMisses() == 1);
+        CHECK(cache.decode(ppm, "test.ppm").pixels == expected);
+        CHECK(cache.numHits() == 1);
+    }
+
+    VulkTextureCache uncached;
+    CHECK(uncached.decode(ppm, "test.ppm").pixels == expected);
+    REQUIRE_THROWS(uncached.decode(std::string("not an image"), "garbage"));
+    std::filesystem::remove_all(cacheDir);
+}
+
+TEST_CASE("cooked texture") {
+    // 6x3 so the edge blocks are partial and the mips round down: 6x3, 3x1, 1x1
+    VulkDecodedImage image;
+    image.width  = 6;
+    image.height = 3;
+    for (uint32_t i = 0; i < image.width * image.height; ++i) {
+        uint8_t v = (uint8_t)(i * 10);
+        image.pixels.insert(image.pixels.end(), {v, (uint8_t)(255 - v), 128, 255});
+    }
+
+    VulkCookedTexture cooked = VulkCookedTexture::cook(image, VulkTextureKind::Color);
+    CHECK(cooked.format == VK_FORMAT_BC1_RGB_SRGB_BLOCK);
+    CHECK(cooked.mipLevels == 3);
+    CHECK(cooked.mipSizes() == std::vector<VkDeviceSize>{2 * 8, 8, 8});
+    CHECK(cooked.data.size() == 32);
+    CHECK(VulkCookedTexture::cook(image, VulkTextureKind::Normal).format == VK_FORMAT_BC5_UNORM_BLOCK);
+    CHECK(VulkCookedTexture::cook(image, VulkTextureKind::Single).format == VK_FORMAT_BC4_UNORM_BLOCK);
+    image.pixels[3] = 128;
+    CHECK(VulkCookedTexture::cook(image, VulkTextureKind::Color).format == VK_FORMAT_BC3_SRGB_BLOCK);
+
+    // black and white average to half in linear space for color, and in the stored value otherwise.
+    // normals tilted either way average to straight up
+    VulkDecodedImage quad;
+    quad.width  = 2;
+    quad.height = 2;
+    quad.pixels = {0, 0, 0, 255, 255, 255, 255, 255, 0, 0, 0, 255, 255, 255, 255, 255};
+    CHECK(VulkCookedTexture::downsample(quad, VulkTextureKind::Color).pixels == std::vector<uint8_t>{188, 188, 188, 255});
+    CHECK(VulkCookedTexture::downsample(quad, VulkTextureKind::Single).pixels == std::vector<uint8_t>{128, 128, 128, 255});
+    quad.pixels = {218, 128, 218, 255, 37, 128, 218, 255, 218, 128, 218, 255, 37, 128, 218, 255};
+    CHECK(VulkCookedTexture::downsample(quad, VulkTextureKind::Normal).pixels == std::vector<uint8_t>{128, 128, 255, 255});
+
+    std::filesystem::path cookedFile = VulkCookedTexture::cookedPathFor("TestTexture.png");
+    CHECK(cookedFile == std::filesystem::path("TestTexture.png.vulktex"));
+    cooked.writeCooked(cookedFile);
+    VulkCookedTexture loaded = VulkCookedTexture::loadFromAssets(nullptr, cookedFile);
+    CHECK(loaded.format == cooked.format);
+    CHECK(loaded.width == 6);
+    CHECK(loaded.height == 3);
+    CHECK(loaded.mipLevels == 3);
+    CHECK(loaded.data == cooked.data);
+
+    std::vector<char> data = readFileIntoMem(cookedFile.string());
+    data.pop_back();
+    REQUIRE_THROWS(VulkCookedTexture::loadCooked(data, "truncated"));
+    data = readFileIntoMem(cookedFile.string());
+    data[4]++;  // version
+    REQUIRE_THROWS(VulkCookedTexture::loadCooked(data, "old version"));
+    std::filesystem::remove(cookedFile);
+}
+
+TEST_CASE("pipeline cache file") {
+    VkPhysicalDeviceProperties props{};
+    props.vendorID      = 0x10de;
+    props.deviceID      = 0x2684;
+    props.driverVersion = 0x8a4c0000;
+    std::fill(std::begin(props.pipelineCacheUUID), std::end(props.pipelineCacheUUID), (uint8_t)7);
+
+    // what a driver would give back: its header then whatever it likes
+    VkPipelineCacheHeaderVersionOne driverHeader{};
+    driverHeader.headerSize    = sizeof(driverHeader);
+    driverHeader.headerVersion = VK_PIPELINE_CACHE_HEADER_VERSION_ONE;
+    driverHeader.vendorID      = props.vendorID;
+    driverHeader.deviceID      = props.deviceID;
+    memcpy(driverHeader.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+    std::vector<char> blob((char const*)&driverHeader, (char const*)&driverHeader + sizeof(driverHeader));
+    blob.insert(blob.end(), {'p', 'i', 'p', 'e'});
+
+    std::vector<char> file = VulkPipelineCache::serialize(props, blob);
+    CHECK(file.size() == sizeof(VulkPipelineCacheFileHeader) + blob.size());
+    std::span<char const> data;
+    std::string reason;
+    REQUIRE(VulkPipelineCache::deserialize(file, props, data, reason));
+    CHECK(std::vector<char>(data.begin(), data.end()) == blob);
+
+    VkPhysicalDeviceProperties other = props;
+    other.driverVersion++;
+    CHECK_FALSE(VulkPipelineCache::deserialize(file, other, data, reason));
+    other = props;
+    other.deviceID++;
+    CHECK_FALSE(VulkPipelineCache::deserialize(file, other, data, reason));
+    other = props;
+    other.pipelineCacheUUID[0]++;
+    CHECK_FALSE(VulkPipelineCache::deserialize(file, other, data, reason));
+
+    std::vector<char> corrupt = file;
+    corrupt.back()++;
+    CHECK_FALSE(VulkPipelineCache::deserialize(corrupt, props, data, reason));
+    corrupt = file;
+    corrupt.pop_back();
+    CHECK_FALSE(VulkPipelineCache::deserialize(corrupt, props, data, reason));
+    CHECK_FALSE(VulkPipelineCache::deserialize(std::span<char const>(file).first(10), props, data, reason));
+
+    // our header matches but the driver's doesn't
+    driverHeader.headerVersion = (VkPipelineCacheHeaderVersion)2;
+    memcpy(blob.data(), &driverHeader, sizeof(driverHeader));
+    CHECK_FALSE(VulkPipelineCache::deserialize(VulkPipelineCache::serialize(props, blob), props, data, reason));
+}
+
+TEST_CASE("descriptor counts") {
+    std::vector<VkDescriptorSetLayoutBinding> bindings = {
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+        {2, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr},
+        {3, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr},
+    };
+    VulkDescriptorCounts counts = VulkDescriptorAllocator::countsFor(bindings);
+    REQUIRE(counts.size() == 3);
+    CHECK(counts[0] == std::make_pair(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1u));
+    CHECK(counts[1] == std::make_pair(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3u));
+    CHECK(counts[2] == std::make_pair(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1u));
+
+    // binding order doesn't matter, so layouts with the same counts share pools
+    std::reverse(bindings.begin(), bindings.end());
+    CHECK(VulkDescriptorAllocator::countsFor(bindings) == counts);
+}
+
+TEST_CASE("draw list sort") {
+    // each field outranks everything after it
+    CHECK(VulkDrawList::makeKey(0, 5, 5, 5, 1.0f) < VulkDrawList::makeKey(1, 0, 0, 0, 0.0f));
+    CHECK(VulkDrawList::makeKey(0, 0, 5, 5, 1.0f) < VulkDrawList::makeKey(0, 1, 0, 0, 0.0f));
+    CHECK(VulkDrawList::makeKey(0, 0, 0, 5, 1.0f) < VulkDrawList::makeKey(0, 0, 1, 0, 0.0f));
+    CHECK(VulkDrawList::makeKey(0, 0, 0, 0, 1.0f) < VulkDrawList::makeKey(0, 0, 0, 1, 0.0f));
+    CHECK(VulkDrawList::makeKey(0, 0, 0, 0, 0.25f) < VulkDrawList::makeKey(0, 0, 0, 0, 0.5f));
+    CHECK(VulkDrawList::makeKey(0, 0, 0, 0, -1.0f) == VulkDrawList::makeKey(0, 0, 0, 0, 0.0f));
+    CHECK_THROWS(VulkDrawList::makeKey(1u << VulkDrawList::PASS_BITS, 0, 0, 0, 0.0f));
+
+    CHECK(VulkDrawList::radixSort({}).empty());
+    std::vector<uint64_t> keys = {VulkDrawList::makeKey(1, 0, 0, 0, 0.0f),
+                                  VulkDrawList::makeKey(0, 2, 0, 0, 0.0f),
+                                  VulkDrawList::makeKey(0, 1, 3, 0, 0.5f),
+                                  VulkDrawList::makeKey(0, 2, 0, 0, 0.0f),
+                                  VulkDrawList::makeKey(0, 1, 3, 0, 0.1f),
+                                  7,
+                                  0xffffffffffffffffull};
+    std::vector<uint32_t> order = VulkDrawList::radixSort(keys);
+    // equal keys (1 and 3) stay in the order they were added
+    CHECK(order == std::vector<uint32_t>{5, 4, 2, 1, 3, 0, 6});
+}
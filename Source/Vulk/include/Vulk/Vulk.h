@@ -15,10 +15,17 @@
 #include <mutex>
 #include <optional>
 #include <set>
+#include <span>
 #include <stdexcept>
 #include <thread>
 #include <unordered_map>
 #include <vector>
+#include "VulkCookedTexture.h"
+#include "VulkDescriptorAllocator.h"
+#include "VulkMemoryAllocator.h"
+#include "VulkPipelineCache.h"
+#include "VulkTextureCache.h"
+#include "VulkUploader.h"
 #include "VulkUtil.h"
 
 struct MouseDragContext {
@@ -98,27 +105,67 @@ class Vulk {
     VkRenderPass renderPass;
     VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
     VkPresentModeKHR presentMode;  // for ImGUI
+    // the device can sample BCn textures, otherwise VulkResources decodes the source images instead of the cooked ones
+    bool bcTextureCompression = false;
+    // all buffer and image memory comes from here
+    std::unique_ptr<VulkMemoryAllocator> allocator;
+    // fills device local buffers and images. see VulkUploader for when the data lands
+    std::unique_ptr<VulkUploader> uploader;
+    // shared by every pipeline build, loaded from pipelineCachePath at startup and saved back at shutdown
+    std::unique_ptr<VulkPipelineCache> pipelineCache;
+    // every VulkDescriptorSet comes from here
+    std::unique_ptr<VulkDescriptorAllocator> descriptorAllocator;
+    static constexpr char const* pipelineCachePath = "VulkPipelineCache.bin";
 
    public:  // utilities
     void createBuffer(VkDeviceSize size,
                       VkBufferUsageFlags usage,
                       VkMemoryPropertyFlags properties,
                       VkBuffer& buffer,
-                      VkDeviceMemory& bufferMemory);
+                      VulkAllocation& bufferAlloc);
+    // destroys the buffer and frees its memory
+    void destroyBuffer(VkBuffer buffer, VulkAllocation& bufferAlloc);
+    void destroyImage(VkImage image, VulkAllocation& imageAlloc);
+    // queued on the uploader, so it's there by the next frame. uploader->flush() if it's needed sooner
     void copyMemToBuffer(void const* srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+    // these run right away on the graphics queue and wait, after flushing the uploader so they see its pending uploads
     void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
     void copyImageToBuffer(VkImage image, VkBuffer buffer, uint32_t width, uint32_t height);
     void copyBufferToMem(VkBuffer srcBuffer, void* dstMem, VkDeviceSize size);
     void copyImageToMem(VkImage image, void* dstBuffer, uint32_t width, uint32_t height, VkDeviceSize dstEltSize);
-    VkSampler createTextureSampler();
-    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
+    VkSampler createTextureSampler(float maxLod = VK_LOD_CLAMP_NONE);
+    VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels = 1);
     VkImage createTextureImage(char const* texture_path,
-                               VkDeviceMemory& textureImageMemory,
+                               VulkAllocation& textureImageAlloc,
                                VkImage& textureImage,
                                bool isUNORM,
                                VkFormat& formatOut);
+    // encoded is the contents of an image file, name is for errors
+    VkImage createTextureImage(std::span<char const> encoded,
+                               char const* name,
+                               VulkAllocation& textureImageAlloc,
+                               VkImage& textureImage,
+                               bool isUNORM,
+                               VkFormat& formatOut);
+    VkImage createTextureImage(VulkDecodedImage const& decoded,
+                               VulkAllocation& textureImageAlloc,
+                               VkImage& textureImage,
+                               bool isUNORM,
+                               VkFormat& formatOut);
+    // generateMips builds a full mip chain on the GPU by blitting, if the format supports it. mipLevelsOut
+    // is how many levels the image ended up with
+    VkImage createTextureImage(VulkDecodedImage const& decoded,
+                               VulkAllocation& textureImageAlloc,
+                               VkImage& textureImage,
+                               bool isUNORM,
+                               VkFormat& formatOut,
+                               bool generateMips,
+                               uint32_t& mipLevelsOut);
+    // uploaded as is, every mip. needs bcTextureCompression for the formats BuildTool cooks to
+    VkImage createTextureImage(VulkCookedTexture const& cooked, VulkAllocation& textureImageAlloc, VkImage& textureImage);
     uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
     VkShaderModule createShaderModule(const std::vector<char>& code);
+    VkShaderModule createShaderModule(std::span<char const> code);
     VkDescriptorSet createDescriptorSet(VkDescriptorSetLayout descriptorSetLayout, VkDescriptorPool descriptorPool);
     VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
     VkFormat findDepthFormat();
@@ -134,7 +181,8 @@ class Vulk {
                      VkImageUsageFlags usage,
                      VkMemoryPropertyFlags properties,
                      VkImage& image,
-                     VkDeviceMemory& imageMemory);
+                     VulkAllocation& imageAlloc,
+                     uint32_t mipLevels = 1);
 
     // e.g. convert a created buffer to a texture buffer or when you transition a depth buffer to a shader readable
     // format
@@ -181,6 +229,7 @@ class Vulk {
 
     VkQueue graphicsQueue;
     VkQueue presentQueue;
+    VkQueue transferQueue;  // graphicsQueue if there's no transfer family
 
     VkSwapchainKHR swapChain;
     std::vector<VkImage> swapChainImages;
@@ -193,7 +242,7 @@ class Vulk {
     std::vector<VkFence> inFlightFences;
 
     VkImage depthImage;
-    VkDeviceMemory depthImageMemory;
+    VulkAllocation depthImageAlloc;
     VkImageView depthImageView;
 
     bool framebufferResized = false;
@@ -205,6 +254,7 @@ class Vulk {
     void copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
 
    private:
+    void flushUploads();
     void initWindow();
     void initVulkan();
     void cleanupSwapChain();
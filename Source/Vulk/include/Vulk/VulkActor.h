@@ -1,5 +1,8 @@
 #pragma once
 
+#include <span>
+#include <vector>
+
 #include "Vulk.h"
 #include "VulkMesh.h"
 #include "VulkModel.h"
@@ -20,10 +23,27 @@ class VulkActor {
     // std::shared_ptr<const VulkFrameUBOs<glm::mat4>> xformUBOs;
     std::shared_ptr<const VulkDescriptorSetInfo> dsInfo;
     std::shared_ptr<const VulkPipeline> pipeline;
+    uint32_t instance = 0;  // where the transform is in the scene's instances, i.e. gl_InstanceIndex
     VulkActor(Vulk&,
               std::shared_ptr<const VulkModel> model,
               // std::shared_ptr<const VulkFrameUBOs<glm::mat4>> xformUBOs,
               std::shared_ptr<const VulkDescriptorSetInfo> dsInfo,
-              std::shared_ptr<const VulkPipeline> pipeline)
-        : model(model), /*xformUBOs(xformUBOs),*/ dsInfo(dsInfo), pipeline(pipeline) {}
-};
\ No newline at end of file
+              std::shared_ptr<const VulkPipeline> pipeline,
+              uint32_t instance = 0)
+        : model(model), /*xformUBOs(xformUBOs),*/ dsInfo(dsInfo), pipeline(pipeline), instance(instance) {}
+};
+
+// actors that draw the same model with the same pipeline and descriptor sets, and whose instances are consecutive, can
+// be drawn with one instanced draw. actor stands in for all of them, see batchActors
+struct VulkActorBatch {
+    std::shared_ptr<const VulkActor> actor;
+    uint32_t firstInstance = 0;
+    uint32_t instanceCount = 0;
+
+    // binds everything and draws every instance
+    void draw(VkCommandBuffer commandBuffer, uint32_t frame) const;
+
+    // the fewest batches that draw all of actors. only shaders that get the transform from the instances SSBO can be
+    // drawn this way, so actors whose pipeline has a dynamic UBO (ModelXform) are always a batch of one
+    static std::vector<VulkActorBatch> batchActors(std::span<std::shared_ptr<const VulkActor> const> actors);
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ClassNonCopyableNonMovable.h"
+#include "VulkUtil.h"
+
+// A whole built Assets directory packed into one file so that startup is a single open and
+// page-in instead of a directory walk plus an open/read per shader, mesh, texture and def.
+//
+// Layout:
+// - Header
+// - each file's contents, starting on an ALIGNMENT boundary so e.g. SPIR-V can be handed
+//   straight to vkCreateShaderModule
+// - the table of contents: an AssetPackDef serialized with thrift's compact protocol
+//
+// The pack is memory mapped when opened and find() returns views into the mapping, so the
+// data is only valid while the pack is alive. Files are looked up by their path on disk as
+// if the pack had been unpacked into mountDir, which lets the loaders keep using the
+// (absolute) paths that the metadata is built from.
+class VulkAssetPack : public ClassNonCopyableNonMovable {
+   public:
+    static constexpr char MAGIC[4]     = {'V', 'K', 'P', 'K'};
+    static constexpr uint32_t VERSION  = 1;
+    static constexpr uint64_t ALIGNMENT = 16;
+
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint64_t tocOffset;
+        uint64_t tocSize;
+    };
+    static_assert(sizeof(Header) == 24);
+
+    std::filesystem::path const packFile;
+    std::filesystem::path const mountDir;
+
+    ~VulkAssetPack();
+
+    // mountDir is where the files would be if the pack was unpacked, usually the Assets dir next to it
+    static std::shared_ptr<VulkAssetPack const> open(std::filesystem::path packFile, std::filesystem::path mountDir);
+
+    // packs every file under srcDir into packFile
+    static void write(std::filesystem::path srcDir, std::filesystem::path packFile);
+
+    // where BuildTool puts the pack for an assets dir: Assets -> Assets.vulkpack
+    static std::filesystem::path packFileFor(std::filesystem::path assetsDir) {
+        std::filesystem::path packFile = assetsDir.lexically_normal();
+        if (!packFile.has_filename()) {
+            packFile = packFile.parent_path();
+        }
+        packFile += ".vulkpack";
+        return packFile;
+    }
+
+    // empty if the file isn't in the pack
+    std::span<char const> find(std::filesystem::path const& path) const;
+    bool contains(std::filesystem::path const& path) const {
+        return entries.contains(toKey(path));
+    }
+
+    // the absolute path of every file in the pack, as if it were unpacked into mountDir
+    std::vector<std::filesystem::path> paths() const;
+
+   private:
+    VulkAssetPack(std::filesystem::path packFile, std::filesystem::path mountDir);
+
+    std::string toKey(std::filesystem::path const& path) const;
+
+    char const* data = nullptr;
+    size_t size      = 0;
+#ifdef _WIN32
+    void* fileHandle    = nullptr;
+    void* mappingHandle = nullptr;
+#else
+    int fd = -1;
+#endif
+    std::unordered_map<std::string, std::span<char const>> entries;
+};
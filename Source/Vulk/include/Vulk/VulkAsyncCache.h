@@ -0,0 +1,50 @@
+#pragma once
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "VulkUtil.h"
+
+template <typename T>
+using VulkFuture = std::shared_future<std::shared_ptr<T>>;
+
+// Thread safe cache of resources by name. Entries are futures so a resource asked for while it's
+// still loading is only loaded once: everyone gets the same future. A load that throws stays
+// cached, and everyone waiting on it gets the exception.
+template <typename T>
+class VulkAsyncCache {
+   public:
+    // the future for key. if there isn't one load() is called, under the lock, to start loading
+    // it: it should hand the work to a thread pool or return a deferred std::async rather than
+    // doing it there and then
+    template <typename F>
+    VulkFuture<T> getOrLoad(std::string const& key, F&& load) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        if (it != entries.end()) {
+            return it->second;
+        }
+        VulkFuture<T> future = load().share();
+        entries.emplace(key, future);
+        return future;
+    }
+
+    VulkFuture<T> at(std::string const& key) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = entries.find(key);
+        VULK_ASSERT(it != entries.end(), "{} isn't loaded", key);
+        return it->second;
+    }
+
+    bool contains(std::string const& key) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return entries.contains(key);
+    }
+
+   private:
+    std::unordered_map<std::string, VulkFuture<T>> entries;
+    mutable std::mutex mutex;
+};
@@ -7,15 +7,17 @@
 struct VulkBuffer : public ClassNonCopyableNonMovable {
     Vulk& vk;
     VkBuffer buf;
-    VkDeviceMemory bufMem;
+    VulkAllocation bufAlloc;
 
-    VulkBuffer(Vulk& vk, VkBuffer buf, VkDeviceMemory bufMem) : vk(vk), buf(buf), bufMem(bufMem) {
-        VULK_TRACE("VulkBuffer: constructed with buffer {:p} and memory {:p}", (void*)buf, (void*)bufMem);
+    VulkBuffer(Vulk& vk, VkBuffer buf, VulkAllocation bufAlloc) : vk(vk), buf(buf), bufAlloc(bufAlloc) {
+        VULK_TRACE("VulkBuffer: constructed with buffer {:p} and memory {:p}+{}",
+                   (void*)buf,
+                   (void*)bufAlloc.memory,
+                   bufAlloc.offset);
     }
 
     ~VulkBuffer() {
-        VULK_TRACE("VulkBuffer: destructed buffer {:p} and memory {:p}", (void*)buf, (void*)bufMem);
-        vkDestroyBuffer(vk.device, buf, nullptr);
-        vkFreeMemory(vk.device, bufMem, nullptr);
+        VULK_TRACE("VulkBuffer: destructed buffer {:p} and memory {:p}+{}", (void*)buf, (void*)bufAlloc.memory, bufAlloc.offset);
+        vk.destroyBuffer(buf, bufAlloc);
     }
 };
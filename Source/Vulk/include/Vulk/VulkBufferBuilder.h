@@ -43,11 +43,11 @@ class VulkBufferBuilder {
         assert(usage != 0);
         assert(properties != 0);
         VkBuffer buf;
-        VkDeviceMemory bufMem;
-        vk.createBuffer(size, usage, properties, buf, bufMem);
+        VulkAllocation bufAlloc;
+        vk.createBuffer(size, usage, properties, buf, bufAlloc);
         if (mem) {
             vk.copyMemToBuffer(mem, buf, size);
         }
-        return std::make_shared<VulkBuffer>(vk, buf, bufMem);
+        return std::make_shared<VulkBuffer>(vk, buf, bufAlloc);
     }
 };
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "VulkTextureCache.h"
+
+class VulkAssetPack;
+
+// What a material map holds, which decides how it's filtered and compressed
+enum class VulkTextureKind : uint32_t {
+    Color,   // sRGB albedo: BC1, or BC3 if any texel isn't opaque. mips are averaged in linear space
+    Normal,  // tangent space normals: BC5 of x and y, shaders rebuild z. mips are renormalized
+    Single,  // one channel data, e.g. metallic, roughness, AO, displacement: BC4 of the red channel
+};
+
+// A texture as cooked by BuildTool: block compressed with its full mip chain, so loading it is a
+// read and an upload with no decode. Layout: this header, then each mip's blocks largest first,
+// back to back. Blocks are 4x4 texels, partial blocks at the edges of small mips are padded with
+// copies of the edge texels. Little endian.
+struct VulkCookedTextureHeader {
+    static constexpr char MAGIC[4]    = {'V', 'K', 'T', 'C'};
+    static constexpr uint32_t VERSION = 1;  // bump if the layout, the filtering or the compression changes
+
+    char magic[4];
+    uint32_t version;
+    uint32_t format;  // VkFormat
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipLevels;
+};
+static_assert(sizeof(VulkCookedTextureHeader) == 24);
+
+class VulkCookedTexture {
+   public:
+    VkFormat format    = VK_FORMAT_UNDEFINED;
+    uint32_t width     = 0;
+    uint32_t height    = 0;
+    uint32_t mipLevels = 0;
+    std::vector<uint8_t> data;  // every mip, largest first
+
+    // cooked textures sit next to the image they were cooked from: albedo.png -> albedo.png.vulktex
+    static constexpr char const* COOKED_EXT = ".vulktex";
+    static std::filesystem::path cookedPathFor(std::filesystem::path srcPath) {
+        srcPath += COOKED_EXT;
+        return srcPath;
+    }
+
+    static VkFormat formatFor(VulkTextureKind kind, bool hasAlpha);
+    // bytes per 4x4 block
+    static uint32_t blockSize(VkFormat format);
+    static uint32_t numMipLevels(uint32_t width, uint32_t height);
+    // sizes of each mip's data, in the order they're stored
+    std::vector<VkDeviceSize> mipSizes() const;
+
+    // builds the mip chain for image and compresses each level
+    static VulkCookedTexture cook(VulkDecodedImage const& image, VulkTextureKind kind);
+    // the next mip down: a 2x2 box filter. odd sizes round down, dropping the last row or column
+    static VulkDecodedImage downsample(VulkDecodedImage const& image, VulkTextureKind kind);
+
+    static VulkCookedTexture loadCooked(std::span<char const> data, std::string const& name);
+    // from the pack if it has the file, otherwise from disk. pack can be null
+    static VulkCookedTexture loadFromAssets(VulkAssetPack const* pack, std::filesystem::path const& path);
+    void writeCooked(std::filesystem::path const& path) const;
+};
@@ -35,7 +35,7 @@ class VulkDeferredRenderpass : public ClassNonCopyableNonMovable {
 
         DeferredImage(Vulk& vkIn, VkFormat formatIn, bool isDepth) : vk(vkIn), format(formatIn) {
             VkImage image;
-            VkDeviceMemory imageMemory;
+            VulkAllocation imageAlloc;
             VkImageView imageView;
 
             // VK_IMAGE_USAGE_SAMPLED_BIT so that we can sample from the image in the shader
@@ -47,7 +47,7 @@ class VulkDeferredRenderpass : public ClassNonCopyableNonMovable {
                                VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
                                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                                image,
-                               imageMemory);
+                               imageAlloc);
                 imageView = vk.createImageView(image, format, VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT);
             } else {
                 vk.createImage(
@@ -58,10 +58,10 @@ class VulkDeferredRenderpass : public ClassNonCopyableNonMovable {
                     VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT,
                     VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                     image,
-                    imageMemory);
+                    imageAlloc);
                 imageView = vk.createImageView(image, format, VK_IMAGE_ASPECT_COLOR_BIT);
             }
-            view = std::make_shared<VulkImageView>(vk, image, imageMemory, imageView);
+            view = std::make_shared<VulkImageView>(vk, image, imageAlloc, imageView);
         }
     };
 
@@ -146,7 +146,9 @@ class VulkDeferredRenderpass : public ClassNonCopyableNonMovable {
 
     VulkDeferredRenderpass(Vulk& vkIn, VulkResources& resources, VulkScene& scene);
 
-    void beginRenderToGBufs(VkCommandBuffer commandBuffer) const {
+    // with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the geometry goes in secondaries, which set their own viewport
+    // and scissor, e.g. see VulkParallelRecorder
+    void beginRenderToGBufs(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE) const {
         vk.beginDebugLabel(commandBuffer, "Deferred GBuffer Creation");
         std::array<VkClearValue, TEnumTraits<GBufAtmtIdx>::size + 1> clearValues{};
         clearValues[(int)GBufAtmtIdx::Depth].depthStencil = {1.0f, 0};
@@ -162,7 +164,10 @@ class VulkDeferredRenderpass : public ClassNonCopyableNonMovable {
                                              .clearValueCount = static_cast<uint32_t>(clearValues.size()),
                                              .pClearValues    = clearValues.data()};
 
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+        if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS) {
+            return;  // only vkCmdExecuteCommands is allowed until the next subpass
+        }
         VkViewport viewport{
             .x        = 0.0f,
             .y        = 0.0f,
@@ -186,14 +191,7 @@ class VulkDeferredRenderpass : public ClassNonCopyableNonMovable {
         vk.beginDebugLabel(commandBuffer, "Deferred Lighting Pass");
         vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, deferredLightingPipeline->pipeline);
-        vkCmdBindDescriptorSets(commandBuffer,
-                                VK_PIPELINE_BIND_POINT_GRAPHICS,
-                                deferredLightingPipeline->pipelineLayout,
-                                0,
-                                1,
-                                &deferredLightingDescriptorSetInfo->descriptorSets[vk.currentFrame]->descriptorSet,
-                                0,
-                                nullptr);
+        deferredLightingDescriptorSetInfo->bind(commandBuffer, deferredLightingPipeline->pipelineLayout, vk.currentFrame);
         vkCmdDraw(commandBuffer, 4, 1, 0, 0);  // the vert shader handles this, just need 4 verts to draw a quad
         vkCmdEndRenderPass(commandBuffer);
         vk.endDebugLabel(commandBuffer);
@@ -16,7 +16,7 @@ class VulkDepthView : public ClassNonCopyableNonMovable {
     VulkDepthView(Vulk& vkIn, VkExtent2D extentIn, VkFormat depthFormatIn)
         : vk(vkIn), extent(extentIn), depthFormat(depthFormatIn) {
         VkImage depthImage;
-        VkDeviceMemory depthImageMemory;
+        VulkAllocation depthImageAlloc;
         VkImageView depthImageView;
 
         vk.createImage(
@@ -27,9 +27,9 @@ class VulkDepthView : public ClassNonCopyableNonMovable {
             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             depthImage,
-            depthImageMemory
+            depthImageAlloc
         );
         depthImageView = vk.createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
-        depthView      = std::make_shared<VulkImageView>(vk, depthImage, depthImageMemory, depthImageView);
+        depthView      = std::make_shared<VulkImageView>(vk, depthImage, depthImageAlloc, depthImageView);
     }
 };
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <vector>
+
+#include "ClassNonCopyableNonMovable.h"
+
+class VulkDescriptorSet;
+
+// how many descriptors of each type a set needs, sorted by type
+using VulkDescriptorCounts = std::vector<std::pair<VkDescriptorType, uint32_t>>;
+
+// Descriptor sets out of shared pools, rather than a pool per VulkDescriptorSetInfo.
+// - pools are grouped by the descriptor counts of the sets they hold, and each holds SETS_PER_POOL sets. when a group's
+//   pools are full it gets another one
+// - sets go back to their pool when their VulkDescriptorSet is destroyed
+// - VulkDescriptorSetBuilder caches what it builds here, by the layout and what's bound to each frame's set, so building
+//   the same thing again, e.g. the shadow map set for actors whose only difference is a dynamic offset, writes nothing
+//   and allocates nothing. entries only last as long as the sets do
+// thread safe
+class VulkDescriptorAllocator : public ClassNonCopyableNonMovable {
+   public:
+    static constexpr uint32_t SETS_PER_POOL = 64;
+
+    // the layout's bindings and every bound resource, see VulkDescriptorSetBuilder::build
+    using CacheKey = std::vector<uint64_t>;
+
+    struct Stats {
+        uint32_t numPools    = 0;
+        uint32_t numSets     = 0;
+        uint32_t cacheHits   = 0;
+        uint32_t cacheMisses = 0;
+    };
+
+    explicit VulkDescriptorAllocator(VkDevice device);
+    ~VulkDescriptorAllocator();
+
+    static VulkDescriptorCounts countsFor(std::span<VkDescriptorSetLayoutBinding const> bindings);
+
+    // the pool the set came from goes in poolOut, for free
+    VkDescriptorSet allocate(VkDescriptorSetLayout layout, VulkDescriptorCounts const& counts, VkDescriptorPool& poolOut);
+    void free(VkDescriptorSet set, VkDescriptorPool pool);
+
+    // true and the sets, one per frame in flight, if they're all still alive
+    bool findCached(CacheKey const& key, std::span<std::shared_ptr<const VulkDescriptorSet>> sets);
+    void cache(CacheKey key, std::span<std::shared_ptr<const VulkDescriptorSet> const> sets);
+
+    Stats getStats() const;
+
+   private:
+    VkDevice device;
+    mutable std::mutex mutex;
+    std::map<VulkDescriptorCounts, std::vector<VkDescriptorPool>> poolsByCounts;
+    std::map<VkDescriptorPool, uint32_t> setsInPool;
+    std::map<CacheKey, std::vector<std::weak_ptr<const VulkDescriptorSet>>> setCache;
+    size_t nextCacheSweep = 64;  // dead entries are dropped when the cache gets this big
+    Stats stats;
+
+    VkDescriptorPool createPool(VulkDescriptorCounts const& counts);
+};
@@ -8,14 +8,21 @@
 
 class VulkImageView;
 
+// a set from vk.descriptorAllocator, which it goes back to when this is destroyed
 class VulkDescriptorSet : public ClassNonCopyableNonMovable {
     friend class VulkDescriptorSetUpdater;
+    Vulk& vk;
+    VkDescriptorPool descriptorPool;
     std::vector<std::shared_ptr<const VulkImageView>> textureImageViews;
     std::vector<std::shared_ptr<const VulkSampler>> textureSamplers;
 
    public:
     VkDescriptorSet descriptorSet;
-    VulkDescriptorSet(Vulk& vk, VkDescriptorSetLayout descriptorSetLayout, VkDescriptorPool descriptorPool) {
-        descriptorSet = vk.createDescriptorSet(descriptorSetLayout, descriptorPool);
+    // counts has to match the layout, see VulkDescriptorAllocator::countsFor
+    VulkDescriptorSet(Vulk& vk, VkDescriptorSetLayout descriptorSetLayout, VulkDescriptorCounts const& counts) : vk(vk) {
+        descriptorSet = vk.descriptorAllocator->allocate(descriptorSetLayout, counts, descriptorPool);
     };
+    ~VulkDescriptorSet() {
+        vk.descriptorAllocator->free(descriptorSet, descriptorPool);
+    }
 };
\ No newline at end of file
@@ -2,10 +2,11 @@
 
 #include "ClassNonCopyableNonMovable.h"
 #include "Vulk.h"
-#include "VulkDescriptorPoolBuilder.h"
 #include "VulkDescriptorSet.h"
 #include "VulkDescriptorSetLayoutBuilder.h"
 #include "VulkDescriptorSetUpdater.h"
+#include "VulkFrameSSBOs.h"
+#include "VulkFrameUBOArena.h"
 #include "VulkFrameUBOs.h"
 #include "VulkSampler.h"
 #include "VulkUniformBuffer.h"
@@ -20,55 +21,68 @@ class VulkDescriptorSetInfo : public ClassNonCopyableNonMovable {
    public:
     // These need to be kept around as long as the descriptor set is in use
     std::shared_ptr<const VulkDescriptorSetLayout> descriptorSetLayout;
-    VkDescriptorPool descriptorPool;
 
+    // may be shared with other infos bound to the same things, see VulkDescriptorAllocator
     std::array<std::shared_ptr<const VulkDescriptorSet>, MAX_FRAMES_IN_FLIGHT> descriptorSets;
+    // one per dynamic binding, in binding order as vkCmdBindDescriptorSets wants them. the same for every frame
+    std::vector<uint32_t> dynamicOffsets;
 
     VulkDescriptorSetInfo(Vulk& vk,
                           std::shared_ptr<const VulkDescriptorSetLayout> descriptorSetLayout,
-                          VkDescriptorPool descriptorPool,
-                          std::array<std::shared_ptr<const VulkDescriptorSet>, MAX_FRAMES_IN_FLIGHT>&& descriptorSets)
+                          std::array<std::shared_ptr<const VulkDescriptorSet>, MAX_FRAMES_IN_FLIGHT>&& descriptorSets,
+                          std::vector<uint32_t> dynamicOffsets = {})
         : vk(vk),
           descriptorSetLayout(descriptorSetLayout),
-          descriptorPool(descriptorPool),
-          descriptorSets(std::move(descriptorSets)) {}
+          descriptorSets(std::move(descriptorSets)),
+          dynamicOffsets(std::move(dynamicOffsets)) {}
 
-    ~VulkDescriptorSetInfo() {
-        vkDestroyDescriptorPool(vk.device, descriptorPool, nullptr);
+    // binds frame's set as set 0, with the dynamic offsets
+    void bind(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, uint32_t frame) const {
+        vkCmdBindDescriptorSets(commandBuffer,
+                                VK_PIPELINE_BIND_POINT_GRAPHICS,
+                                pipelineLayout,
+                                0,
+                                1,
+                                &descriptorSets[frame]->descriptorSet,
+                                (uint32_t)dynamicOffsets.size(),
+                                dynamicOffsets.data());
     }
 };
 
 class VulkDescriptorSetBuilder {
     Vulk& vk;
     VulkDescriptorSetLayoutBuilder layoutBuilder;
-    VulkDescriptorPoolBuilder poolBuilder;
     std::shared_ptr<const VulkDescriptorSetLayout> descriptorSetLayoutOverride;
     struct BufSetUpdaterInfo {
         VkBuffer buf;
         VkDeviceSize range;
+        uint64_t ownerId;  // the id of whatever owns buf, see cacheKey
     };
 
     struct PerFrameInfo {
-        std::unordered_map<vulk::cpp2::VulkShaderUBOBinding, BufSetUpdaterInfo> uniformSetInfos;
-        std::unordered_map<vulk::cpp2::VulkShaderSSBOBinding, BufSetUpdaterInfo> ssboSetInfos;
+        // ordered so the cache keys are the same however the bindings were added
+        std::map<vulk::cpp2::VulkShaderUBOBinding, BufSetUpdaterInfo> uniformSetInfos;
+        std::map<vulk::cpp2::VulkShaderUBOBinding, BufSetUpdaterInfo> dynamicUniformSetInfos;
+        std::map<vulk::cpp2::VulkShaderSSBOBinding, BufSetUpdaterInfo> ssboSetInfos;
     };
     std::array<PerFrameInfo, MAX_FRAMES_IN_FLIGHT> perFrameInfos;
+    std::map<vulk::cpp2::VulkShaderUBOBinding, uint32_t> dynamicOffsets;  // ordered by binding
 
     struct SamplerSetUpdaterInfo {
         std::shared_ptr<const VulkImageView> imageView;
         std::shared_ptr<const VulkSampler> sampler;
     };
-    std::array<std::unordered_map<vulk::cpp2::VulkShaderTextureBinding, SamplerSetUpdaterInfo>, MAX_FRAMES_IN_FLIGHT>
+    std::array<std::map<vulk::cpp2::VulkShaderTextureBinding, SamplerSetUpdaterInfo>, MAX_FRAMES_IN_FLIGHT>
         perFrameSamplerSetInfos;
 
     struct InputAttachmentInfo {
         // uint32_t atmtIdx;
         std::shared_ptr<const VulkImageView> imageView;
     };
-    std::unordered_map<vulk::cpp2::GBufBinding, InputAttachmentInfo> inputAttachments;
+    std::map<vulk::cpp2::GBufBinding, InputAttachmentInfo> inputAttachments;
 
    public:
-    VulkDescriptorSetBuilder(Vulk& vk) : vk(vk), layoutBuilder(vk), poolBuilder(vk) {}
+    VulkDescriptorSetBuilder(Vulk& vk) : vk(vk), layoutBuilder(vk) {}
 
     // if we have this cached and it matches the current layout just use it. make sure you know what you're doing
     VulkDescriptorSetBuilder& setDescriptorSetLayout(std::shared_ptr<const VulkDescriptorSetLayout> descriptorSetLayout) {
@@ -82,9 +96,33 @@ class VulkDescriptorSetBuilder {
                                            VkShaderStageFlagBits stageFlags,
                                            vulk::cpp2::VulkShaderUBOBinding bindingID) {
         layoutBuilder.addUniformBuffer(stageFlags, bindingID);
-        poolBuilder.addUniformBufferCount(MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            perFrameInfos[i].uniformSetInfos[bindingID] = {ubos.bufs[i], sizeof(T)};
+            perFrameInfos[i].uniformSetInfos[bindingID] = {ubos.bufs[i], sizeof(T), ubos.id};
+        }
+        return *this;
+    }
+
+    // a slot from a VulkFrameUBOArena, bound with its offset. the binding has to be dynamic in the layout too, see
+    // VulkDescriptorSetLayoutBuilder::addDynamicUniformBuffer
+    template <typename T>
+    VulkDescriptorSetBuilder& addDynamicFrameUBO(VulkFrameUBOSlot<T> const& slot,
+                                                 VkShaderStageFlagBits stageFlags,
+                                                 vulk::cpp2::VulkShaderUBOBinding bindingID) {
+        layoutBuilder.addDynamicUniformBuffer(stageFlags, bindingID);
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            perFrameInfos[i].dynamicUniformSetInfos[bindingID] = {slot.buf(i), sizeof(T), slot.block->id};
+        }
+        dynamicOffsets[bindingID] = slot.offset;
+        return *this;
+    }
+
+    template <typename T>
+    VulkDescriptorSetBuilder& addFrameSSBOs(VulkFrameSSBOs<T> const& ssbos,
+                                            VkShaderStageFlagBits stageFlags,
+                                            vulk::cpp2::VulkShaderSSBOBinding bindingID) {
+        layoutBuilder.addStorageBuffer(stageFlags, bindingID);
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            perFrameInfos[i].ssboSetInfos[bindingID] = {ssbos.bufs[i], ssbos.getSize(), ssbos.id};
         }
         return *this;
     }
@@ -95,9 +133,8 @@ class VulkDescriptorSetBuilder {
                                                VkShaderStageFlagBits stageFlags,
                                                vulk::cpp2::VulkShaderUBOBinding bindingID) {
         layoutBuilder.addUniformBuffer(stageFlags, bindingID);
-        poolBuilder.addUniformBufferCount(MAX_FRAMES_IN_FLIGHT);
         for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            perFrameInfos[i].uniformSetInfos[bindingID] = {uniformBuffer.buf, sizeof(T)};
+            perFrameInfos[i].uniformSetInfos[bindingID] = {uniformBuffer.buf, sizeof(T), uniformBuffer.id};
         }
         return *this;
     }
@@ -109,7 +146,6 @@ class VulkDescriptorSetBuilder {
                                                         std::shared_ptr<const VulkSampler> sampler) {
         VULK_ASSERT(imageView && sampler);
         layoutBuilder.addImageSampler(stageFlags, bindingID);
-        poolBuilder.addCombinedImageSamplerCount(MAX_FRAMES_IN_FLIGHT);
         perFrameSamplerSetInfos[0][bindingID] = {imageView, sampler};
         perFrameSamplerSetInfos[1][bindingID] = {imageView, sampler};
         return *this;
@@ -122,7 +158,6 @@ class VulkDescriptorSetBuilder {
                                                    std::shared_ptr<const VulkSampler> sampler) {
         VULK_ASSERT(imageView && sampler);
         layoutBuilder.addImageSampler(stageFlags, bindingID);
-        poolBuilder.addCombinedImageSamplerCount(1);
         perFrameSamplerSetInfos[frame][bindingID] = {imageView, sampler};
         return *this;
     }
@@ -133,7 +168,6 @@ class VulkDescriptorSetBuilder {
         requires InputAtmtBinding<decltype(bindingID)>
     {
         layoutBuilder.addInputAttachment(stageFlags, bindingID);
-        poolBuilder.addInputAttachmentCount(1);
         InputAttachmentInfo info                             = {imageView};
         inputAttachments[(vulk::cpp2::GBufBinding)bindingID] = info;
         return *this;
@@ -146,28 +180,86 @@ class VulkDescriptorSetBuilder {
         } else {
             descriptorSetLayout = layoutBuilder.build();
         }
-        VkDescriptorPool pool = poolBuilder.build(MAX_FRAMES_IN_FLIGHT);
         std::array<std::shared_ptr<const VulkDescriptorSet>, MAX_FRAMES_IN_FLIGHT> descriptorSets;
-        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-            auto ds = std::make_shared<VulkDescriptorSet>(vk, descriptorSetLayout->layout, pool);
-            VulkDescriptorSetUpdater updater(ds);
+        VulkDescriptorAllocator::CacheKey key = cacheKey(*descriptorSetLayout);
+        if (!vk.descriptorAllocator->findCached(key, descriptorSets)) {
+            VulkDescriptorCounts counts = VulkDescriptorAllocator::countsFor(descriptorSetLayout->bindings);
+            for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+                auto ds = std::make_shared<VulkDescriptorSet>(vk, descriptorSetLayout->layout, counts);
+                VulkDescriptorSetUpdater updater(ds);
 
-            for (auto& pair : perFrameInfos[i].uniformSetInfos) {
-                updater.addUniformBuffer(pair.second.buf, pair.second.range, pair.first);
-            }
-            for (auto& pair : perFrameInfos[i].ssboSetInfos) {
-                updater.addStorageBuffer(pair.second.buf, pair.second.range, pair.first);
+                for (auto& pair : perFrameInfos[i].uniformSetInfos) {
+                    updater.addUniformBuffer(pair.second.buf, pair.second.range, pair.first);
+                }
+                for (auto& pair : perFrameInfos[i].dynamicUniformSetInfos) {
+                    updater.addDynamicUniformBuffer(pair.second.buf, pair.second.range, pair.first);
+                }
+                for (auto& pair : perFrameInfos[i].ssboSetInfos) {
+                    updater.addStorageBuffer(pair.second.buf, pair.second.range, pair.first);
+                }
+                for (auto& pair : perFrameSamplerSetInfos[i]) {
+                    updater.addImageSampler(pair.second.imageView, pair.second.sampler, pair.first);
+                }
+                for (auto& [binding, info] : inputAttachments) {
+                    updater.addInputAttachment(info.imageView, binding);
+                }
+
+                updater.update(vk.device);
+                descriptorSets[i] = ds;
             }
-            for (auto& pair : perFrameSamplerSetInfos[i]) {
-                updater.addImageSampler(pair.second.imageView, pair.second.sampler, pair.first);
+            vk.descriptorAllocator->cache(std::move(key), descriptorSets);
+        }
+
+        std::vector<uint32_t> offsets;
+        for (auto& [binding, offset] : dynamicOffsets) {
+            offsets.push_back(offset);
+        }
+        return std::make_shared<const VulkDescriptorSetInfo>(vk,
+                                                             descriptorSetLayout,
+                                                             std::move(descriptorSets),
+                                                             std::move(offsets));
+    }
+
+   private:
+    template <typename T>
+    static uint64_t handleKey(T handle) {
+        return (uint64_t)handle;
+    }
+
+    // everything that goes into the sets. the layout goes in by its bindings rather than its handle: a set works with
+    // any layout defined the same way, so pipelines with matching layouts share sets too. dynamic offsets aren't in
+    // the sets so they're not in here.
+    // a destroyed handle can come back for something else, which would find this one's sets. the sets hold their image
+    // views and samplers, so those handles can't be reused while there's anything to find. they don't hold their
+    // buffers, so buffers go in by their owner's id, which is never reused
+    VulkDescriptorAllocator::CacheKey cacheKey(VulkDescriptorSetLayout const& layout) const {
+        VulkDescriptorAllocator::CacheKey key;
+        std::vector<VkDescriptorSetLayoutBinding> bindings = layout.bindings;
+        std::sort(bindings.begin(), bindings.end(), [](auto const& a, auto const& b) { return a.binding < b.binding; });
+        key.push_back(bindings.size());
+        for (VkDescriptorSetLayoutBinding const& b : bindings) {
+            key.insert(key.end(), {b.binding, (uint64_t)b.descriptorType, b.descriptorCount, b.stageFlags});
+        }
+        auto addBufs = [&key](auto const& infos) {
+            key.push_back(infos.size());
+            for (auto& [binding, info] : infos) {
+                key.insert(key.end(), {(uint64_t)binding, info.ownerId, info.range});
             }
-            for (auto& [binding, info] : inputAttachments) {
-                updater.addInputAttachment(info.imageView, binding);
+        };
+        for (int i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+            addBufs(perFrameInfos[i].uniformSetInfos);
+            addBufs(perFrameInfos[i].dynamicUniformSetInfos);
+            addBufs(perFrameInfos[i].ssboSetInfos);
+            key.push_back(perFrameSamplerSetInfos[i].size());
+            for (auto& [binding, info] : perFrameSamplerSetInfos[i]) {
+                key.insert(key.end(),
+                           {(uint64_t)binding, handleKey(info.imageView->imageView), handleKey(info.sampler->get())});
             }
-
-            updater.update(vk.device);
-            descriptorSets[i] = ds;
         }
-        return std::make_shared<const VulkDescriptorSetInfo>(vk, descriptorSetLayout, pool, std::move(descriptorSets));
+        key.push_back(inputAttachments.size());
+        for (auto& [binding, info] : inputAttachments) {
+            key.insert(key.end(), {(uint64_t)binding, handleKey(info.imageView->imageView)});
+        }
+        return key;
     }
 };
\ No newline at end of file
@@ -10,6 +10,9 @@ class VulkDescriptorSetLayoutBuilder {
    public:
     VulkDescriptorSetLayoutBuilder(Vulk& vk) : vk(vk) {}
     VulkDescriptorSetLayoutBuilder& addUniformBuffer(VkShaderStageFlags stageFlags, vulk::cpp2::VulkShaderUBOBinding binding);
+    // the buffer offset is given when the set is bound, see VulkFrameUBOArena
+    VulkDescriptorSetLayoutBuilder& addDynamicUniformBuffer(VkShaderStageFlags stageFlags,
+                                                            vulk::cpp2::VulkShaderUBOBinding binding);
     VulkDescriptorSetLayoutBuilder& addImageSampler(VkShaderStageFlags stageFlags, vulk::cpp2::VulkShaderTextureBinding binding);
     VulkDescriptorSetLayoutBuilder& addStorageBuffer(VkShaderStageFlags stageFlags, vulk::cpp2::VulkShaderSSBOBinding binding);
     VulkDescriptorSetLayoutBuilder& addInputAttachment(VkShaderStageFlags stageFlags, auto bindingIn)
@@ -26,6 +26,10 @@ class VulkDescriptorSetUpdater {
     VulkDescriptorSetUpdater(std::shared_ptr<VulkDescriptorSet> descriptorSet) : descriptorSet(descriptorSet) {}
 
     VulkDescriptorSetUpdater& addUniformBuffer(VkBuffer buf, VkDeviceSize range, vulk::cpp2::VulkShaderUBOBinding binding);
+    // the offset comes from vkCmdBindDescriptorSets
+    VulkDescriptorSetUpdater& addDynamicUniformBuffer(VkBuffer buf,
+                                                      VkDeviceSize range,
+                                                      vulk::cpp2::VulkShaderUBOBinding binding);
     VulkDescriptorSetUpdater& addImageSampler(std::shared_ptr<const VulkImageView> textureImageView,
                                               std::shared_ptr<const VulkSampler> textureSampler,
                                               vulk::cpp2::VulkShaderTextureBinding binding);
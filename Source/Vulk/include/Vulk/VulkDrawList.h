@@ -0,0 +1,81 @@
+#pragma once
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "VulkActor.h"
+
+// Records a pass's draws sorted so that draws sharing state are next to each other, and only binds what changed
+// between them. Renderables are added as VulkActorBatches each with a 64 bit sort key, most significant first:
+// - pass (4 bits): e.g. opaque before transparent within a render pass
+// - pipeline (12 bits)
+// - descriptor set (16 bits): the sets, which are shared when bound to the same things, see VulkDescriptorAllocator
+// - mesh (16 bits): the model, whose vertex and index buffers are bound together
+// - depth (16 bits): 0 to 1, nearest first
+// pipelines, sets and meshes get ids in the order the list first sees them, and keep them across clear() so the order
+// doesn't shuffle from frame to frame.
+// not thread safe, except recordRange once sorted, which is how VulkParallelRecorder splits a list across threads
+class VulkDrawList {
+   public:
+    static constexpr uint32_t PASS_BITS     = 4;
+    static constexpr uint32_t PIPELINE_BITS = 12;
+    static constexpr uint32_t SET_BITS      = 16;
+    static constexpr uint32_t MESH_BITS     = 16;
+    static constexpr uint32_t DEPTH_BITS    = 16;
+
+    struct Stats {
+        uint32_t draws                     = 0;
+        uint32_t pipelineBinds             = 0;
+        uint32_t pipelineBindsSkipped      = 0;
+        uint32_t descriptorSetBinds        = 0;
+        uint32_t descriptorSetBindsSkipped = 0;
+        uint32_t vertexBufferBinds         = 0;
+        uint32_t vertexBufferBindsSkipped  = 0;
+
+        uint32_t bindsSkipped() const {
+            return pipelineBindsSkipped + descriptorSetBindsSkipped + vertexBufferBindsSkipped;
+        }
+        Stats& operator+=(Stats const& rhs);
+    };
+
+    static uint64_t makeKey(uint32_t pass, uint32_t pipeline, uint32_t descriptorSet, uint32_t mesh, float depth);
+
+    // the order that sorts keys, stable for equal keys. LSD radix sort a byte at a time, skipping the bytes that are
+    // the same in every key, which for a frame's draws is most of the high ones
+    static std::vector<uint32_t> radixSort(std::span<uint64_t const> keys);
+
+    // the batch's actor has to outlive the list, or at least the next clear()
+    void add(VulkActorBatch const& batch, uint32_t pass = 0, float depth = 0.0f);
+    void clear();
+    size_t size() const {
+        return draws.size();
+    }
+
+    // if anything was added since the last time
+    void sort();
+
+    // sorts, then binds and draws everything inside the current render pass. nothing is assumed to be bound beforehand
+    void record(VkCommandBuffer commandBuffer, uint32_t frame);
+
+    // count of the sorted draws starting at first, with the same binding as record. const so a sorted list can be
+    // recorded from several threads at once
+    Stats recordRange(VkCommandBuffer commandBuffer, uint32_t frame, size_t first, size_t count) const;
+
+    // from the last record
+    Stats const& getStats() const {
+        return stats;
+    }
+
+   private:
+    struct Draw {
+        uint64_t key;
+        VulkActorBatch batch;
+    };
+    std::vector<Draw> draws;
+    std::vector<uint32_t> order;  // draws, sorted. empty until the next record after an add
+    std::unordered_map<void const*, uint32_t> pipelineIDs, setIDs, meshIDs;
+    Stats stats;
+
+    static uint32_t idFor(std::unordered_map<void const*, uint32_t>& ids, void const* p, uint32_t bits);
+};
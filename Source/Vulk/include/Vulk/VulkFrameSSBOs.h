@@ -0,0 +1,41 @@
+#pragma once
+
+#include "ClassNonCopyableNonMovable.h"
+#include "Vulk.h"
+#include "VulkUtil.h"
+
+// like VulkFrameUBOs but an array of count Ts in a storage buffer, for when there are too many for a UBO,
+// e.g. one per instance
+template <typename T>
+class VulkFrameSSBOs : public ClassNonCopyableNonMovable {
+    Vulk& vk;
+    std::array<VulkAllocation, MAX_FRAMES_IN_FLIGHT> allocs;
+
+   public:
+    std::array<VkBuffer, MAX_FRAMES_IN_FLIGHT> bufs;
+    std::array<T*, MAX_FRAMES_IN_FLIGHT> ptrs;
+    uint32_t count;
+    uint64_t const id = vulkUniqueId();  // stands in for bufs in cache keys, see VulkDescriptorSetBuilder
+
+    VulkFrameSSBOs(Vulk& vk, uint32_t count) : vk(vk), count(count) {
+        VULK_ASSERT(count > 0, "can't make an empty SSBO");
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+            vk.createBuffer(sizeof(T) * count,
+                            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                            bufs[i],
+                            allocs[i]);
+            ptrs[i] = static_cast<T*>(allocs[i].mapped);
+        }
+    }
+
+    ~VulkFrameSSBOs() {
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+            vk.destroyBuffer(bufs[i], allocs[i]);
+        }
+    }
+
+    VkDeviceSize getSize() const {
+        return sizeof(T) * count;
+    }
+};
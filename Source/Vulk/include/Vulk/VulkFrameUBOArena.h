@@ -0,0 +1,79 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "ClassNonCopyableNonMovable.h"
+#include "Vulk.h"
+#include "VulkUtil.h"
+
+// one host visible buffer per frame in flight, all the same size, which slots are cut from
+struct VulkFrameUBOBlock : public ClassNonCopyableNonMovable {
+    Vulk& vk;
+    VkDeviceSize size;
+    VkDeviceSize used = 0;
+    std::array<VkBuffer, MAX_FRAMES_IN_FLIGHT> bufs;
+    std::array<VulkAllocation, MAX_FRAMES_IN_FLIGHT> allocs;
+    uint64_t const id = vulkUniqueId();  // stands in for bufs in cache keys, see VulkDescriptorSetBuilder
+
+    VulkFrameUBOBlock(Vulk& vk, VkDeviceSize size);
+    ~VulkFrameUBOBlock();
+};
+
+// a T in each of a block's buffers, at the same offset in all of them
+template <typename T>
+struct VulkFrameUBOSlot {
+    std::shared_ptr<VulkFrameUBOBlock const> block;  // keeps the buffers alive as long as something can bind them
+    uint32_t offset = 0;                             // the dynamic offset for vkCmdBindDescriptorSets
+
+    VkBuffer buf(uint32_t frame) const {
+        return block->bufs[frame];
+    }
+    T* ptr(uint32_t frame) const {
+        return reinterpret_cast<T*>(static_cast<uint8_t*>(block->allocs[frame].mapped) + offset);
+    }
+};
+
+// Per frame UBOs without a buffer and an allocation each. VulkFrameUBOs<T> makes MAX_FRAMES_IN_FLIGHT buffers, which is
+// fine for a handful of scene wide UBOs but not for one per actor. Here a UBO is a bump of an offset into one
+// persistently mapped buffer per frame, bound as VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC with the offset given at
+// vkCmdBindDescriptorSets, see VulkDescriptorSetBuilder::addDynamicFrameUBO.
+// - offsets are multiples of minUniformBufferOffsetAlignment
+// - a slot has the same offset in every frame's buffer, so frame i's copy can be written while the GPU reads the others
+// - when a block is full another is made, slots never move
+// - nothing is freed until the arena and every slot cut from it are gone
+// - not thread safe, it's meant for createDSInfoFromPipeline which isn't either
+class VulkFrameUBOArena : public ClassNonCopyableNonMovable {
+   public:
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit VulkFrameUBOArena(Vulk& vk, VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+
+    // every frame's copy starts as init
+    template <typename T>
+    VulkFrameUBOSlot<T> allocate(T const& init) {
+        VulkFrameUBOSlot<T> slot;
+        slot.offset = reserve(sizeof(T), slot.block);
+        for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+            *slot.ptr(i) = init;
+        }
+        return slot;
+    }
+
+    VkDeviceSize getAlignment() const {
+        return alignment;
+    }
+    size_t numBlocks() const {
+        return blocks.size();
+    }
+
+   private:
+    Vulk& vk;
+    VkDeviceSize blockSize;
+    VkDeviceSize alignment;
+    std::vector<std::shared_ptr<VulkFrameUBOBlock>> blocks;
+
+    // the offset of size bytes in block, which is the current block or a new one if that's full
+    uint32_t reserve(VkDeviceSize size, std::shared_ptr<VulkFrameUBOBlock const>& block);
+};
@@ -15,17 +15,18 @@ class VulkFrameUBOs {
                 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                 bufs[i],
-                mems[i]
+                allocs[i]
             );
-            vkMapMemory(vk.device, mems[i], 0, bufferSize, 0, (void**)&ptrs[i]);
+            ptrs[i] = static_cast<T*>(allocs[i].mapped);
         }
     }
 
-    std::array<VkDeviceMemory, MAX_FRAMES_IN_FLIGHT> mems;
+    std::array<VulkAllocation, MAX_FRAMES_IN_FLIGHT> allocs;
 
    public:
     std::array<VkBuffer, MAX_FRAMES_IN_FLIGHT> bufs;
     std::array<T*, MAX_FRAMES_IN_FLIGHT> ptrs;
+    uint64_t const id = vulkUniqueId();  // stands in for bufs in cache keys, see VulkDescriptorSetBuilder
 
     explicit VulkFrameUBOs(Vulk& vk) : vk(vk) {
         init();
@@ -40,9 +41,7 @@ class VulkFrameUBOs {
 
     ~VulkFrameUBOs() {
         for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
-            vkUnmapMemory(vk.device, mems[i]);
-            vkDestroyBuffer(vk.device, bufs[i], nullptr);
-            vkFreeMemory(vk.device, mems[i], nullptr);
+            vk.destroyBuffer(bufs[i], allocs[i]);
         }
     }
 };
\ No newline at end of file
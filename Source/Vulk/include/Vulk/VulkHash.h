@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "VulkException.h"
+
+// 64-bit FNV-1a hash for keying on-disk caches by content.
+// Not cryptographic, but stable across runs and platforms, which is what
+// the build/resource caches need: a value written by one run has to match
+// the value computed for the same bytes by the next.
+class VulkHasher {
+   public:
+    static constexpr uint64_t OFFSET_BASIS = 0xcbf29ce484222325ull;
+    static constexpr uint64_t PRIME        = 0x100000001b3ull;
+
+    VulkHasher& add(void const* data, size_t size) {
+        uint8_t const* bytes = static_cast<uint8_t const*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= bytes[i];
+            hash *= PRIME;
+        }
+        return *this;
+    }
+
+    // the length goes in too so that e.g. "ab"+"c" and "a"+"bc" hash differently
+    VulkHasher& add(std::string_view s) {
+        addValue((uint64_t)s.size());
+        return add(s.data(), s.size());
+    }
+
+    template <typename T>
+        requires std::is_trivially_copyable_v<T> && (!std::is_pointer_v<T>)
+    VulkHasher& addValue(T const& value) {
+        return add(&value, sizeof(T));
+    }
+
+    VulkHasher& addFile(std::filesystem::path const& path) {
+        std::ifstream file(path, std::ios::binary);
+        VULK_ASSERT(file.is_open(), "Failed to open file for hashing: {}", path.string());
+        char buf[64 * 1024];
+        while (file) {
+            file.read(buf, sizeof(buf));
+            add(buf, (size_t)file.gcount());
+        }
+        return *this;
+    }
+
+    uint64_t get() const {
+        return hash;
+    }
+
+    // fixed width hex, handy for filenames and JSON (thrift i64s are signed)
+    std::string toString() const {
+        return toString(hash);
+    }
+
+    static std::string toString(uint64_t h) {
+        return fmt::format("{:016x}", h);
+    }
+
+    static uint64_t hashFile(std::filesystem::path const& path) {
+        return VulkHasher().addFile(path).get();
+    }
+
+   private:
+    uint64_t hash = OFFSET_BASIS;
+};
@@ -2,25 +2,40 @@
 #include <vulkan/vulkan.h>
 
 #include "ClassNonCopyableNonMovable.h"
+#include "VulkCookedTexture.h"
+#include "VulkMemoryAllocator.h"
+#include "VulkTextureCache.h"
 
 class Vulk;
+class VulkAssetPack;
 class VulkImageView : public ClassNonCopyableNonMovable {
    public:
     Vulk& vk;
     VkImage image;
-    VkDeviceMemory imageMemory;
+    VulkAllocation imageAlloc;
     VkImageView imageView;
+    uint32_t mipLevels = 1;
 
     // isUNORM just means load the texture without changing the format - for example loading a normal map.
     VulkImageView(Vulk& vkIn, std::filesystem::path const& texturePath, bool isUNORM);
     VulkImageView(Vulk& vkIn, char const* texturePath, bool isUNORM);
     VulkImageView(Vulk& vkIn, std::string const& texturePath, bool isUNORM) : VulkImageView(vkIn, texturePath.c_str(), isUNORM) {}
-    VulkImageView(Vulk& vkIn, VkImage depthImage, VkDeviceMemory depthImageMemory, VkImageView depthImageView)
-        : vk(vkIn), image(depthImage), imageMemory(depthImageMemory), imageView(depthImageView) {}
+    // loads from the pack if it has the texture, otherwise from disk. pack can be null
+    VulkImageView(Vulk& vkIn, VulkAssetPack const* pack, std::filesystem::path const& texturePath, bool isUNORM);
+    // generateMips blits a full mip chain from the decoded image on the GPU, for textures that weren't cooked
+    VulkImageView(Vulk& vkIn, VulkDecodedImage const& decoded, bool isUNORM, bool generateMips = false);
+    // block compressed with its mips, see VulkCookedTexture. nothing to decode, it's uploaded as is
+    VulkImageView(Vulk& vkIn, VulkCookedTexture const& cooked);
+    VulkImageView(Vulk& vkIn, VkImage depthImage, VulkAllocation depthImageAlloc, VkImageView depthImageView)
+        : vk(vkIn), image(depthImage), imageAlloc(depthImageAlloc), imageView(depthImageView) {}
     ~VulkImageView();
 
     VulkImageView(Vulk& vkIn) : vk(vkIn) {}
-    static std::shared_ptr<VulkImageView> createCubemapView(Vulk& vk, std::array<std::string, 6> const& cubemapImgs);
+    static std::shared_ptr<VulkImageView> createCubemapView(Vulk& vk,
+                                                            std::array<std::string, 6> const& cubemapImgs,
+                                                            VulkAssetPack const* pack = nullptr);
+    // faces are pos-x, neg-x, pos-y, neg-y, pos-z, neg-z and all the same size
+    static std::shared_ptr<VulkImageView> createCubemapView(Vulk& vk, std::array<VulkDecodedImage, 6> const& faces);
 
    private:
     void loadTextureView(char const* texturePath, bool isUNORM);
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "VulkUtil.h"
+
+struct VulkMemoryBlock;
+
+// A piece of device memory handed out by VulkMemoryAllocator. Bind the resource to memory at
+// offset. Host visible memory stays mapped for the allocation's lifetime, so write through
+// mapped rather than vkMapMemory'ing memory - it's shared with other allocations and can only
+// be mapped once.
+struct VulkAllocation {
+    VkDeviceMemory memory  = VK_NULL_HANDLE;
+    VkDeviceSize offset    = 0;
+    VkDeviceSize size      = 0;
+    void* mapped           = nullptr;  // null unless host visible
+    uint32_t memoryType    = 0;
+    bool linear            = false;
+    VulkMemoryBlock* block = nullptr;  // null for dedicated allocations
+
+    explicit operator bool() const {
+        return memory != VK_NULL_HANDLE;
+    }
+};
+
+struct VulkMemoryStats {
+    uint32_t numBlocks           = 0;
+    uint32_t numDedicated        = 0;
+    uint32_t numAllocations      = 0;  // live, including dedicated
+    VkDeviceSize reservedBytes   = 0;  // allocated from the device: blocks + dedicated
+    VkDeviceSize liveBytes       = 0;  // handed out
+    VkDeviceSize freeBytes       = 0;  // unused space in blocks
+    VkDeviceSize largestFree     = 0;  // biggest single free range in any block
+    VkDeviceSize fragmentedBytes = 0;  // free space outside its block's largest free range
+
+    // 0 when each block's free space is one range, approaching 1 as it gets chopped into little pieces
+    float fragmentation() const {
+        return freeBytes ? (float)fragmentedBytes / (float)freeBytes : 0.0f;
+    }
+};
+
+// Sub-allocates buffers and images out of large blocks of device memory instead of a
+// vkAllocateMemory per resource, which is slow and capped by maxMemoryAllocationCount (4096
+// on plenty of drivers).
+// - each memory type gets its own blocks, split by whether they hold linear (buffers) or
+//   optimal (images) resources so neighbours never violate bufferImageGranularity
+// - blocks keep an offset ordered free list; allocation is best fit respecting the
+//   resource's alignment and frees coalesce with their neighbours
+// - anything bigger than half a block, or asked for, gets a dedicated allocation, e.g. big
+//   render targets
+// - an empty block is kept around per pool so alloc/free churn doesn't hit the driver
+//
+// Thread safe. All device calls go through Backend so tests can run it without a device.
+class VulkMemoryAllocator {
+   public:
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+    struct Backend {
+        std::function<VkResult(uint32_t memoryType, VkDeviceSize size, VkDeviceMemory* memoryOut)> allocate;
+        std::function<void(VkDeviceMemory memory)> free;
+        std::function<void*(VkDeviceMemory memory)> map;  // the whole allocation
+        std::function<void(VkDeviceMemory memory)> unmap;
+    };
+
+    // memoryTypes are the propertyFlags from VkPhysicalDeviceMemoryProperties, by index
+    VulkMemoryAllocator(Backend backend,
+                        std::vector<VkMemoryPropertyFlags> memoryTypes,
+                        VkDeviceSize blockSize = DEFAULT_BLOCK_SIZE);
+    ~VulkMemoryAllocator();
+
+    static std::unique_ptr<VulkMemoryAllocator> create(VkDevice device, VkPhysicalDevice physicalDevice);
+
+    // linear is true for buffers and linear tiled images. throws if no memory type fits
+    VulkAllocation allocate(VkMemoryRequirements const& reqs,
+                            VkMemoryPropertyFlags properties,
+                            bool linear,
+                            bool dedicated = false);
+    // resets alloc. freeing an empty allocation does nothing
+    void free(VulkAllocation& alloc);
+
+    uint32_t findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+    VulkMemoryStats getStats() const;
+
+   private:
+    struct Pool {
+        std::vector<std::unique_ptr<VulkMemoryBlock>> blocks;
+    };
+
+    Backend backend;
+    std::vector<VkMemoryPropertyFlags> memoryTypes;
+    VkDeviceSize blockSize;
+    std::vector<Pool> pools;  // memoryType * 2 + linear
+    std::map<VkDeviceMemory, VkDeviceSize> dedicated;
+    VkDeviceSize liveBytes  = 0;
+    uint32_t numAllocations = 0;
+    mutable std::mutex mutex;
+
+    VulkAllocation allocateDedicated(uint32_t memoryType, VkDeviceSize size, bool linear);
+    std::unique_ptr<VulkMemoryBlock> createBlock(uint32_t memoryType);
+    void destroyBlock(VulkMemoryBlock& block);
+};
@@ -3,12 +3,20 @@
 #include <filesystem>
 
 #include "Vulk.h"
+#include "VulkAssetPack.h"
 
+// a draw range within a VulkMesh. the indices are absolute, i.e. already offset by
+// firstVertex, so draw with vkCmdDrawIndexed(indexCount, 1, firstIndex, 0, 0)
 struct VulkMeshRef {
     std::string name;
     uint32_t firstVertex = 0;
     uint32_t firstIndex  = 0;
     uint32_t indexCount  = 0;
+
+    template <class Archive>
+    void serialize(Archive& archive) {
+        archive(name, firstVertex, firstIndex, indexCount);
+    }
 };
 
 struct Vertex {
@@ -18,22 +26,59 @@ struct Vertex {
     glm::vec2 uv;
 };
 
+// VulkMesh as cooked by BuildTool, so loading a model is a read and a copy instead of an
+// Assimp import. Layout: this header, then the vertex attributes as separate streams
+// (positions, normals, tangents, uvs, numVertices each), the indices, and then the submeshes
+// (firstVertex, firstIndex, indexCount, name length, name). Little endian.
+struct VulkCookedMeshHeader {
+    static constexpr char MAGIC[4]    = {'V', 'K', 'M', 'S'};
+    static constexpr uint32_t VERSION = 2;  // bump if the layout changes
+
+    char magic[4];
+    uint32_t version;
+    uint32_t numVertices;
+    uint32_t numIndices;
+    uint32_t numSubmeshes;
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+static_assert(sizeof(VulkCookedMeshHeader) == 44);
+
 class VulkMesh {
    public:
     std::string name;
     std::vector<Vertex> vertices;
     std::vector<uint32_t> indices;
+    // one range per mesh instance when several were merged into this one, e.g. every mesh in an
+    // imported scene, so a model is one vertex/index buffer pair drawn as many ranges. empty
+    // means the whole index buffer is one range, which is how the geo generators make them.
+    std::vector<VulkMeshRef> submeshes;
 
+    // adds mesh's ranges to the submeshes, after a range for what was already here if there weren't any.
+    // returns the range covering all of mesh
     VulkMeshRef appendMesh(VulkMesh const& mesh);
+    // what to draw: the submeshes, or the whole index buffer as one range if there aren't any
+    std::vector<VulkMeshRef> getDrawRanges() const;
     void xform(glm::mat4 const& xform);
 
+    // imports every mesh in the file's node hierarchy, baking in the node transforms. each mesh
+    // instance becomes a submesh
     static VulkMesh loadFromFile(char const* filename, std::string name);
     static VulkMesh loadFromPath(std::filesystem::path const& path, std::string name) {
         return loadFromFile(path.string().c_str(), name);
     }
+    // data is the contents of a model file, formatHint its extension (e.g. "obj")
+    static VulkMesh loadFromMemory(std::span<char const> data, char const* formatHint, std::string name);
+    // from the pack if it has the file, otherwise from disk. pack can be null.
+    // .vulkmesh files are loaded as cooked meshes, anything else goes through Assimp
+    static VulkMesh loadFromAssets(VulkAssetPack const* pack, std::filesystem::path const& path, std::string name);
+
+    static constexpr char const* COOKED_EXT = ".vulkmesh";
+    static VulkMesh loadCooked(std::span<char const> data, std::string name);
+    void writeCooked(std::filesystem::path const& path) const;
 
     template <class Archive>
     void serialize(Archive& archive) {
-        archive(name, vertices, indices);
+        archive(name, vertices, indices, submeshes);
     }
 };
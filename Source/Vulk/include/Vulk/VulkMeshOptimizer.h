@@ -0,0 +1,45 @@
+#pragma once
+
+#include "VulkMesh.h"
+
+// How well an index order uses the post-transform vertex cache, simulated as a FIFO of
+// cacheSize vertices:
+// - ACMR (average cache miss ratio): vertex shader invocations per triangle. 3 is no reuse
+//   at all, ~0.5-0.7 is about as good as it gets for a regular closed mesh.
+// - ATVR (average transformed vertex ratio): invocations per referenced vertex. 1 is ideal.
+struct VulkVertexCacheStats {
+    uint32_t numTriangles   = 0;
+    uint32_t numVertices    = 0;  // referenced by the indices
+    uint32_t numTransformed = 0;  // cache misses
+    float acmr              = 0.0f;
+    float atvr              = 0.0f;
+};
+
+// Offline optimizations for meshes that BuildTool runs when it cooks them. They only
+// reorder/merge vertices and triangles so the mesh renders identically, just cheaper:
+// - deduplicateVertices: merge bitwise identical vertices. Assimp and the geo generators
+//   emit a vertex per face corner in places
+// - optimizeVertexCache: reorder triangles for the post-transform cache (Tipsify, Sander et
+//   al. 2007 "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw")
+// - optimizeOverdraw: reorder the clusters the cache pass produced so outward facing ones
+//   draw first, as long as ACMR doesn't get more than threshold times worse
+// - optimizeVertexFetch: renumber vertices in the order they are first used so fetches are
+//   mostly sequential. drops vertices no triangle uses
+// optimize() runs them in that order, which is the order they need to run in. Triangles are
+// only reordered within their submesh so the draw ranges stay valid.
+class VulkMeshOptimizer {
+   public:
+    // bump this when the output of optimize() changes so cooked meshes get rebuilt
+    static constexpr int32_t VERSION = 1;
+    // a conservative guess at the hardware's cache, which isn't really a FIFO anyway
+    static constexpr uint32_t CACHE_SIZE = 16;
+
+    // returns the number of vertices removed
+    static uint32_t deduplicateVertices(VulkMesh& mesh);
+    static void optimizeVertexCache(VulkMesh& mesh, uint32_t cacheSize = CACHE_SIZE);
+    static void optimizeOverdraw(VulkMesh& mesh, float threshold = 1.05f, uint32_t cacheSize = CACHE_SIZE);
+    static void optimizeVertexFetch(VulkMesh& mesh);
+    static void optimize(VulkMesh& mesh);
+
+    static VulkVertexCacheStats analyzeVertexCache(VulkMesh const& mesh, uint32_t cacheSize = CACHE_SIZE);
+};
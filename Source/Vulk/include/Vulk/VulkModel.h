@@ -8,11 +8,12 @@
 #include "Vulk.h"
 #include "VulkBufferBuilder.h"
 #include "VulkDescriptorSetLayoutBuilder.h"
-#include "VulkFrameUBOs.h"
+#include "VulkFrameUBOArena.h"
 #include "VulkImageView.h"
 #include "VulkMaterialTextures.h"
 #include "VulkMesh.h"
 #include "VulkPipeline.h"
+#include "VulkVertexLayout.h"
 
 // a model is the minimal set of things needed to render something in a visually interesting way. it consists of a subset of the
 // following:
@@ -27,80 +28,69 @@ struct VulkModel {
     std::shared_ptr<const VulkMaterialTextures> textures;
     std::shared_ptr<const VulkUniformBuffer<VulkMaterialConstants>> materialUBO;
     uint32_t numIndices, numVertices;
-    std::unordered_map<vulk::cpp2::VulkShaderLocation, std::shared_ptr<const VulkBuffer>>
-        bufs;  // each index is VulkShaderLocation_Pos, Color, Normal, etc.;
+    std::vector<VulkMeshRef> drawRanges;  // one vkCmdDrawIndexed each, see VulkMesh::getDrawRanges
+    VulkVertexLayout vertexLayout;  // has to match the pipeline's, see VulkPipelineBuilder::setVertexLayout
+    std::vector<std::pair<uint32_t, std::shared_ptr<const VulkBuffer>>> vertexBufs;  // by binding
     std::shared_ptr<const VulkBuffer> indexBuf;
 
-    // mutable: don't allocate this unless a descriptor set uses it in a scene.
-    mutable std::shared_ptr<const VulkFrameUBOs<glm::mat4>> xformUBOs;
+    // mutable: don't allocate this unless a descriptor set uses it in a scene. it comes from the scene's actorUBOs
+    mutable std::shared_ptr<const VulkFrameUBOSlot<glm::mat4>> xformUBO;
 
     VulkModel(Vulk& vk,
               std::shared_ptr<const VulkMesh> meshIn,
               std::shared_ptr<const VulkMaterialTextures> texturesIn,
               std::shared_ptr<const VulkUniformBuffer<VulkMaterialConstants>> materialUBO,
-              std::vector<vulk::cpp2::VulkShaderLocation> const& inputs)
+              std::vector<vulk::cpp2::VulkShaderLocation> const& inputs,
+              vulk::cpp2::VulkVertexLayoutType layout = vulk::cpp2::VulkVertexLayoutType::Separate)
         : vk(vk),
           mesh(meshIn),
           textures(texturesIn),
           materialUBO(materialUBO),
           numIndices((uint32_t)meshIn->indices.size()),
           numVertices((uint32_t)meshIn->vertices.size()),
+          drawRanges(meshIn->getDrawRanges()),
+          vertexLayout(layout, inputs),
           indexBuf(VulkBufferBuilder(vk)
                        .setSize(sizeof(meshIn->indices[0]) * meshIn->indices.size())
                        .setMem(meshIn->indices.data())
                        .setUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT)
                        .setProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
                        .build()) {
-        for (vulk::cpp2::VulkShaderLocation i : inputs) {
-            if (i == vulk::cpp2::VulkShaderLocation::Pos || i == vulk::cpp2::VulkShaderLocation::Normal ||
-                i == vulk::cpp2::VulkShaderLocation::Tangent) {
-                std::vector<glm::vec3> vec3s;
-                vec3s.reserve(meshIn->vertices.size());
-                for (auto& v : meshIn->vertices) {
-                    switch (i) {
-                        case vulk::cpp2::VulkShaderLocation::Pos:
-                            vec3s.push_back(v.pos);
-                            break;
-                        case vulk::cpp2::VulkShaderLocation::Normal:
-                            vec3s.push_back(v.normal);
-                            break;
-                        case vulk::cpp2::VulkShaderLocation::Tangent:
-                            vec3s.push_back(v.tangent);
-                            break;
-                        default:
-                            VULK_THROW("Unhandled vulk::cpp2::VulkShaderLocation");
-                    }
-                }
-                bufs[i] = VulkBufferBuilder(vk)
-                              .setSize(sizeof(vec3s[0]) * vec3s.size())
-                              .setMem(vec3s.data())
-                              .setUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
-                              .setProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-                              .build();
-            } else if (i == vulk::cpp2::VulkShaderLocation::TexCoord) {
-                std::vector<glm::vec2> vec2s;
-                vec2s.reserve(meshIn->vertices.size());
-                for (auto& v : meshIn->vertices) {
-                    vec2s.push_back(v.uv);
-                }
-                bufs[i] = VulkBufferBuilder(vk)
-                              .setSize(sizeof(vec2s[0]) * vec2s.size())
-                              .setMem(vec2s.data())
-                              .setUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
-                              .setProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
-                              .build();
-            } else {
-                VULK_THROW("Unhandled vulk::cpp2::VulkShaderLocation");
-            }
+        for (VulkVertexLayout::Binding const& binding : vertexLayout.bindings) {
+            std::vector<uint8_t> data = vertexLayout.buildVertexBuffer(binding, meshIn->vertices);
+            vertexBufs.push_back({binding.binding,
+                                  VulkBufferBuilder(vk)
+                                      .setSize(data.size())
+                                      .setMem(data.data())
+                                      .setUsage(VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT)
+                                      .setProperties(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)
+                                      .build()});
         }
     }
 
     void bindInputBuffers(VkCommandBuffer cmdBuf) const {
-        for (auto& [binding, buf] : this->bufs) {
-            VkDeviceSize offsets[] = {0};
-            vkCmdBindVertexBuffers(cmdBuf, (uint32_t)binding, 1, &buf->buf, offsets);
+        // one call per run of consecutive bindings, i.e. one call for the interleaved layouts
+        std::vector<VkBuffer> bufs;
+        std::vector<VkDeviceSize> offsets;
+        for (size_t i = 0; i < vertexBufs.size(); ++i) {
+            bufs.push_back(vertexBufs[i].second->buf);
+            offsets.push_back(0);
+            bool lastInRun = i + 1 == vertexBufs.size() || vertexBufs[i + 1].first != vertexBufs[i].first + 1;
+            if (lastInRun) {
+                uint32_t firstBinding = vertexBufs[i + 1 - bufs.size()].first;
+                vkCmdBindVertexBuffers(cmdBuf, firstBinding, (uint32_t)bufs.size(), bufs.data(), offsets.data());
+                bufs.clear();
+                offsets.clear();
+            }
         }
 
         vkCmdBindIndexBuffer(cmdBuf, indexBuf->buf, 0, VK_INDEX_TYPE_UINT32);
     }
+
+    // draws every range with the buffers bound by bindInputBuffers, all with whatever material is bound
+    void draw(VkCommandBuffer cmdBuf, uint32_t instanceCount = 1, uint32_t firstInstance = 0) const {
+        for (VulkMeshRef const& range : drawRanges) {
+            vkCmdDrawIndexed(cmdBuf, range.indexCount, instanceCount, range.firstIndex, 0, firstInstance);
+        }
+    }
 };
@@ -8,9 +8,11 @@
 #include "VulkDescriptorPoolBuilder.h"
 #include "VulkDescriptorSetBuilder.h"
 #include "VulkDescriptorSetUpdater.h"
+#include "VulkDrawList.h"
 #include "VulkFence.h"
 #include "VulkGeo.h"
 #include "VulkMesh.h"
+#include "VulkParallelRecorder.h"
 #include "VulkPickRenderpass.h"
 #include "VulkPipeline.h"
 #include "VulkPipelineBuilder.h"
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <array>
+#include <vector>
+
+#include "ClassNonCopyableNonMovable.h"
+#include "Vulk.h"
+#include "VulkDrawList.h"
+#include "VulkThreadPool.h"
+
+// Records a VulkDrawList across threads. The sorted list is cut into one contiguous chunk per thread, each chunk is
+// recorded into a secondary command buffer, and the primary runs them in order with vkCmdExecuteCommands.
+// - the render pass (or subpass) has to have been begun with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, and
+//   nothing else can be recorded into it inline
+// - each chunk has its own command pool per frame in flight, so no pool is used by two threads at once. the pools are
+//   reset by the first record of a frame, after Vulk::render has waited for that frame's fence
+// - nothing is bound at the start of a secondary, so every chunk rebinds its first draw's state. chunks are at least
+//   MIN_DRAWS_PER_CHUNK draws so that and the handoff stay small next to the recording they save
+// - the first chunk is recorded by the calling thread
+class VulkParallelRecorder : public ClassNonCopyableNonMovable {
+   public:
+    static constexpr size_t MIN_DRAWS_PER_CHUNK = 64;
+
+    explicit VulkParallelRecorder(Vulk& vk, uint32_t numThreads = VulkThreadPool::defaultNumThreads() + 1);
+    ~VulkParallelRecorder();
+
+    // sorts list and records it into commandBuffer, which has to be inside subpass of renderPass on framebuffer. the
+    // viewport and scissor are set to extent in every secondary, as they aren't inherited from the primary
+    VulkDrawList::Stats record(VkCommandBuffer commandBuffer,
+                               VulkDrawList& list,
+                               VkRenderPass renderPass,
+                               uint32_t subpass,
+                               VkFramebuffer framebuffer,
+                               VkExtent2D extent);
+
+    // the most chunks a list is cut into
+    uint32_t numThreads() const {
+        return (uint32_t)chunks[0].size();
+    }
+
+   private:
+    // one per thread per frame in flight
+    struct Chunk {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        std::vector<VkCommandBuffer> bufs;  // allocated as needed, reused once the pool is reset
+        uint32_t numUsed = 0;               // this frame
+    };
+
+    Vulk& vk;
+    std::array<std::vector<Chunk>, MAX_FRAMES_IN_FLIGHT> chunks;
+    std::array<uint32_t, MAX_FRAMES_IN_FLIGHT> resetFrameCount;  // vk.frameCount when the frame's pools were reset
+    VulkThreadPool workers;  // last, so it's joined before the pools go away
+
+    VkCommandBuffer nextBuffer(Chunk& chunk);
+};
@@ -14,7 +14,7 @@ class VulkPickView : public ClassNonCopyableNonMovable {
 
     VulkPickView(Vulk& vkIn, VkExtent2D extentIn, VkFormat formatIn) : vk(vkIn), extent(extentIn), format(formatIn) {
         VkImage image;
-        VkDeviceMemory imageMemory;
+        VulkAllocation imageAlloc;
         VkImageView pickImageView;
 
         vk.createImage(
@@ -25,10 +25,10 @@ class VulkPickView : public ClassNonCopyableNonMovable {
             VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             image,
-            imageMemory
+            imageAlloc
         );
         pickImageView = vk.createImageView(image, format, VK_IMAGE_ASPECT_COLOR_BIT);
-        view          = std::make_shared<VulkImageView>(vk, image, imageMemory, pickImageView);
+        view          = std::make_shared<VulkImageView>(vk, image, imageAlloc, pickImageView);
     }
 };
 
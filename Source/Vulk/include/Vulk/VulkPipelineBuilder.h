@@ -4,6 +4,7 @@
 #include "VulkDescriptorSetLayoutBuilder.h"
 #include "VulkPipeline.h"
 #include "VulkShaderModule.h"
+#include "VulkVertexLayout.h"
 
 struct PipelineDef;
 
@@ -11,14 +12,10 @@ class VulkPipelineBuilder {
     Vulk& vk;
     std::shared_ptr<const PipelineDef> def;
 
-    struct VertInput {
-        VkVertexInputBindingDescription binding     = {};
-        VkVertexInputAttributeDescription attribute = {};
-    };
-
     std::vector<std::shared_ptr<const VulkShaderModule>> shaderModules;
     std::vector<VkPipelineShaderStageCreateInfo> shaderStages;
-    std::unordered_map<vulk::cpp2::VulkShaderLocation, VertInput> vertInputs;
+    std::vector<vulk::cpp2::VulkShaderLocation> vertInputs;
+    vulk::cpp2::VulkVertexLayoutType vertexLayout = vulk::cpp2::VulkVertexLayoutType::Separate;
     VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
     VkPipelineViewportStateCreateInfo viewportState{};
     VkPipelineRasterizationStateCreateInfo rasterizer{};
@@ -69,7 +66,13 @@ class VulkPipelineBuilder {
     VulkPipelineBuilder& setFrontStencilReference(uint32_t reference);
     VulkPipelineBuilder& copyFrontStencilToBack();
 
+    // the binding/attribute descriptions come from VulkVertexLayout, so the layout has to match the one
+    // the models drawn with this pipeline were built with
     VulkPipelineBuilder& addVertexInput(vulk::cpp2::VulkShaderLocation input);
+    VulkPipelineBuilder& setVertexLayout(vulk::cpp2::VulkVertexLayoutType layout) {
+        vertexLayout = layout;
+        return *this;
+    }
     VulkPipelineBuilder& addColorBlendAttachment(bool blendingEnabled,
                                                  VkColorComponentFlags colorWriteMask = VK_COLOR_COMPONENT_R_BIT |
                                                                                         VK_COLOR_COMPONENT_G_BIT |
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+// The cache file is this header followed by the driver's cache data. The driver's data starts with
+// its own header, which has the vendor, device and cache UUID but not the driver version, and not
+// every driver changes the UUID when it's updated. So we keep our own copy of all of them and
+// throw the data away if any don't match this device.
+struct VulkPipelineCacheFileHeader {
+    static constexpr char MAGIC[4]    = {'V', 'K', 'P', 'C'};
+    static constexpr uint32_t VERSION = 1;  // bump if the layout changes
+
+    char magic[4];
+    uint32_t version;
+    uint32_t vendorID;
+    uint32_t deviceID;
+    uint32_t driverVersion;
+    uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+    uint32_t dataSize;
+    uint64_t dataHash;  // VulkHasher of the driver's data, catches truncated or corrupt files
+};
+static_assert(sizeof(VulkPipelineCacheFileHeader) == 48);
+
+// A VkPipelineCache that's loaded from disk when it's made and written back by save(), so pipelines
+// compiled by one run don't have to be compiled again by the next. Every pipeline build shares it,
+// VkPipelineCache is internally synchronized so building on worker threads is fine.
+// - a missing, stale or corrupt file just means starting with an empty cache
+// - save() writes to a temp file and renames it into place. failing to write only logs
+// - hits and misses come from VkPipelineCreationFeedback, see recordFeedback
+class VulkPipelineCache {
+   public:
+    VulkPipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, std::filesystem::path path);
+    ~VulkPipelineCache();
+
+    VkPipelineCache get() const {
+        return cache;
+    }
+
+    void save();
+
+    // creation feedback is core in 1.3. without it nothing is counted
+    bool hasCreationFeedback() const {
+        return creationFeedback;
+    }
+    // call with the pipeline feedback from each vkCreate*Pipelines that used this cache
+    void recordFeedback(VkPipelineCreationFeedback const& feedback);
+    void logStats() const;
+
+    uint32_t numHits() const {
+        return hits;
+    }
+    uint32_t numMisses() const {
+        return misses;
+    }
+
+    // our header and data, ready to write
+    static std::vector<char> serialize(VkPhysicalDeviceProperties const& props, std::span<char const> data);
+    // true if file was written by serialize for a device with these properties, otherwise false
+    // with why in reason. data is the driver's part of file
+    static bool deserialize(std::span<char const> file,
+                            VkPhysicalDeviceProperties const& props,
+                            std::span<char const>& data,
+                            std::string& reason);
+
+   private:
+    VkDevice device;
+    VkPhysicalDeviceProperties props;
+    std::filesystem::path path;
+    VkPipelineCache cache           = VK_NULL_HANDLE;
+    bool creationFeedback           = false;
+    size_t loadedSize               = 0;
+    std::atomic<uint32_t> hits      = 0;
+    std::atomic<uint32_t> misses    = 0;
+    std::atomic<uint64_t> hitNanos  = 0;
+    std::atomic<uint64_t> missNanos = 0;
+};
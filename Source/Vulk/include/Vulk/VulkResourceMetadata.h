@@ -1,10 +1,12 @@
 #pragma once
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <unordered_map>
 
@@ -13,6 +15,7 @@
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 #pragma warning(pop)
 
+#include "VulkAssetPack.h"
 #include "VulkCamera.h"
 #include "VulkGeo.h"
 #include "VulkPointLight.h"
@@ -24,27 +27,107 @@ namespace fs = std::filesystem;
 
 #include <glm/vec3.hpp>
 
+// Source assets are always SimpleJSON so they stay hand editable. Built artifacts (the .proj and
+// .pipeline files BuildTool writes) can instead be written with one of thrift's binary protocols,
+// which are much smaller and faster to parse at startup. readDefFromFile figures out which one
+// a file is from its header, so loaders don't need to know.
+enum class VulkDefFormat : uint16_t {
+    Json    = 0,
+    Compact = 1,
+    Binary  = 2,
+};
+
+// binary defs start with this, JSON defs never do since they start with '{'
+struct VulkDefFileHeader {
+    static constexpr char MAGIC[4]    = {'V', 'K', 'D', 'F'};
+    static constexpr uint16_t VERSION = 1;  // bump if the header or the way defs are serialized changes
+
+    char magic[4];
+    uint16_t version;
+    VulkDefFormat format;
+};
+static_assert(sizeof(VulkDefFileHeader) == 8);
+
+// name is just for error messages
+template <typename T>
+void readDefFromMemory(std::string_view serializedData, T& def, std::string const& name) {
+    VulkDefFileHeader header;
+    if (serializedData.size() < sizeof(header) ||
+        memcmp(serializedData.data(), VulkDefFileHeader::MAGIC, sizeof(header.magic)) != 0) {
+        // Deserialize JSON to Thrift object
+        apache::thrift::SimpleJSONSerializer::deserialize(folly::StringPiece(serializedData.data(), serializedData.size()),
+                                                          def);
+        return;
+    }
+
+    memcpy(&header, serializedData.data(), sizeof(header));
+    VULK_ASSERT(header.version == VulkDefFileHeader::VERSION,
+                "{} is def version {}, expected {}. rebuild it.",
+                name,
+                header.version,
+                VulkDefFileHeader::VERSION);
+    folly::StringPiece body(serializedData.data() + sizeof(header), serializedData.size() - sizeof(header));
+    switch (header.format) {
+    case VulkDefFormat::Compact:
+        apache::thrift::CompactSerializer::deserialize(body, def);
+        break;
+    case VulkDefFormat::Binary:
+        apache::thrift::BinarySerializer::deserialize(body, def);
+        break;
+    default:
+        VULK_THROW("{} has unknown def format {}", name, (uint16_t)header.format);
+    }
+}
+
 template <typename T>
 void readDefFromFile(const std::string& path, T& def) {
-    std::ifstream ifs(path);
-    VULK_ASSERT(ifs.is_open(), "Could not open file for reading: %s", path.c_str());
+    std::ifstream ifs(path, std::ios::binary);
+    VULK_ASSERT(ifs.is_open(), "Could not open file for reading: {}", path);
 
     std::string serializedData((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
     ifs.close();
+    readDefFromMemory(serializedData, def, path);
+}
 
-    // Deserialize JSON to Thrift object
-    apache::thrift::SimpleJSONSerializer::deserialize(serializedData, def);
+// reads from the pack if it has the file, otherwise from disk
+template <typename T>
+void readDefFromAssets(VulkAssetPack const* pack, std::filesystem::path const& path, T& def) {
+    if (pack && pack->contains(path)) {
+        std::span<char const> data = pack->find(path);
+        readDefFromMemory(std::string_view(data.data(), data.size()), def, path.string());
+    } else {
+        readDefFromFile(path.string(), def);
+    }
 }
 
 template <typename T>
-void writeDefToFile(const std::string& path, const T& def) {
+void writeDefToFile(const std::string& path, const T& def, VulkDefFormat format = VulkDefFormat::Json) {
     std::string serializedData;
-    apache::thrift::SimpleJSONSerializer::serialize(def, &serializedData);
+    switch (format) {
+    case VulkDefFormat::Json:
+        apache::thrift::SimpleJSONSerializer::serialize(def, &serializedData);
+        break;
+    case VulkDefFormat::Compact:
+        apache::thrift::CompactSerializer::serialize(def, &serializedData);
+        break;
+    case VulkDefFormat::Binary:
+        apache::thrift::BinarySerializer::serialize(def, &serializedData);
+        break;
+    default:
+        VULK_THROW("unknown def format {}", (uint16_t)format);
+    }
 
-    std::ofstream ofs(path);
+    std::ofstream ofs(path, std::ios::binary);
     if (!ofs.is_open()) {
         throw std::runtime_error("Could not open file for writing");
     }
+    if (format != VulkDefFormat::Json) {
+        VulkDefFileHeader header;
+        memcpy(header.magic, VulkDefFileHeader::MAGIC, sizeof(header.magic));
+        header.version = VulkDefFileHeader::VERSION;
+        header.format  = format;
+        ofs.write((char const*)&header, sizeof(header));
+    }
     ofs << serializedData;
     ofs.close();
 }
@@ -134,6 +217,7 @@ struct PipelineDef {
 
 struct ModelMeshDef {
     std::string path;
+    std::string cookedPath;  // the .vulkmesh BuildTool cooked from path, if there is one. loaded in preference to path
 };
 
 struct MeshDef {
@@ -218,6 +302,7 @@ struct SceneDef {
 // not contain the resources themselves. The resources are loaded on demand.
 struct Metadata {
     std::filesystem::path assetsDir;
+    std::shared_ptr<VulkAssetPack const> pack;  // if set, assets are read from here rather than assetsDir
     unordered_map<string, shared_ptr<MeshDef>> meshes;
     unordered_map<string, shared_ptr<vulk::cpp2::ShaderDef>> vertShaders;
     unordered_map<string, shared_ptr<vulk::cpp2::ShaderDef>> geometryShaders;
@@ -228,6 +313,9 @@ struct Metadata {
     unordered_map<string, shared_ptr<SceneDef>> scenes;
 };
 
+// parses a .mtl file. texture paths in it are made absolute. pack can be null
+extern MaterialDef loadMaterialDef(const fs::path& file, VulkAssetPack const* pack);
 extern void findAndProcessMetadata(const fs::path path, Metadata& metadata);
+extern void findAndProcessMetadata(std::shared_ptr<VulkAssetPack const> pack, Metadata& metadata);
 extern std::shared_ptr<const Metadata> getMetadata();
 // extern std::filesystem::path getResourcesDir();
\ No newline at end of file
@@ -7,6 +7,7 @@
 
 #include "Vulk.h"
 #include "VulkActor.h"
+#include "VulkAsyncCache.h"
 #include "VulkDescriptorSetLayoutBuilder.h"
 #include "VulkFrameUBOs.h"
 #include "VulkImageView.h"
@@ -17,6 +18,7 @@
 #include "VulkSampler.h"
 #include "VulkScene.h"
 #include "VulkShaderModule.h"
+#include "VulkThreadPool.h"
 
 struct ActorDef;
 struct DescriptorSetDef;
@@ -25,11 +27,24 @@ struct ModelDef;
 struct PipelineDef;
 struct Metadata;
 
+// one pipeline for loadPipelines
+struct VulkPipelineLoad {
+    std::string name;
+    VkRenderPass renderPass;
+    VkExtent2D extent;
+};
+
 // It is expected that an instance of this will be made for a world/level/scene, the approriate resources will be loaded
 // off of it, and then this can be destructed at the end of the loading process to free up unused resources
 // while used resources will be kept alive by the shared_ptrs that are returned to the caller.
 //
-// Note: not thread safe
+// The *Async functions return futures and do the work on a pool of worker threads: parsing meshes, decoding textures,
+// creating the GPU resources and recording their uploads into vk.uploader, which submits them with the next frame. So a
+// scene's textures and meshes all load in parallel. Everything is cached by name, and asking for something that's still
+// loading gets the same future rather than loading it again. The plain versions just wait on the async ones.
+//
+// Thread safe, except createDSInfoFromPipeline and createActorFromPipeline which fill in the scene's and model's UBOs
+// as they find they need them, so keep those on one thread. Destroying this waits for any loads in progress.
 class VulkResources {
    public:
     Vulk& vk;
@@ -43,41 +58,45 @@ class VulkResources {
     enum ShaderType { Vert, Geom, Frag };
 
     std::shared_ptr<const VulkShaderModule> createShaderModule(ShaderType type, std::string const& name) const;
+    std::shared_ptr<const VulkShaderModule> getShader(ShaderType type, std::string const& name) const;
+    std::shared_ptr<const VulkPipeline> createPipeline(VkRenderPass renderPass, VkExtent2D extent, std::string const& name);
 
-    std::shared_ptr<const VulkUniformBuffer<VulkMaterialConstants>> getMaterial(std::string const& name);
-    std::shared_ptr<const VulkMesh> getMesh(MeshDef& meshDef);
-    std::shared_ptr<const VulkMaterialTextures> getMaterialTextures(std::string const& name);
-    std::shared_ptr<const VulkModel> getModel(ModelDef const& modelDef, PipelineDef const& pipelineDef);
+    VulkFuture<const VulkUniformBuffer<VulkMaterialConstants>> getMaterialAsync(std::string const& name);
+    VulkFuture<VulkImageView> getTextureAsync(std::string const& path, bool isUNORM);
+    VulkFuture<VulkImageView> getCubemapAsync(std::array<std::string, 6> const& cubemapImgs);
 
    public:
     // these are the caches of loaded resources
-    mutable std::unordered_map<std::string, std::shared_ptr<const VulkMaterialTextures>> materialTextures;
-    mutable std::unordered_map<std::string, std::shared_ptr<const VulkUniformBuffer<VulkMaterialConstants>>> materialUBOs;
-    mutable std::unordered_map<std::string, std::shared_ptr<const VulkMesh>> meshes;
-    mutable std::unordered_map<std::string, std::shared_ptr<const VulkPipeline>> pipelines;
-    mutable std::unordered_map<std::string, std::shared_ptr<const VulkBuffer>> buffers;
-    mutable std::unordered_map<std::string, std::shared_ptr<const VulkModel>> pipelineModels;
-    mutable std::unordered_map<std::string, std::shared_ptr<VulkScene>> scenes;
-    mutable std::unordered_map<std::string, std::shared_ptr<const VulkShaderModule>> vertShaders, geomShaders, fragShaders;
+    mutable VulkAsyncCache<const VulkMaterialTextures> materialTextures;
+    mutable VulkAsyncCache<VulkImageView> textures;  // by path and format, shared between materials
+    mutable VulkAsyncCache<const VulkUniformBuffer<VulkMaterialConstants>> materialUBOs;
+    mutable VulkAsyncCache<const VulkMesh> meshes;
+    mutable VulkAsyncCache<const VulkPipeline> pipelines;
+    mutable VulkAsyncCache<const VulkModel> pipelineModels;
+    mutable VulkAsyncCache<VulkScene> scenes;
+    mutable VulkAsyncCache<const VulkShaderModule> vertShaders, geomShaders, fragShaders;
     mutable std::shared_ptr<VulkSampler> textureSampler, shadowMapSampler;
 
-    std::shared_ptr<VulkScene> loadScene(std::string name,
-                                         std::array<std::shared_ptr<VulkDepthView>, MAX_FRAMES_IN_FLIGHT> shadowMapViews) const;
+    // ready once the scene's meshes and textures are. the models are made per pipeline as the actors are created
+    VulkFuture<VulkScene> loadSceneAsync(std::string const& name,
+                                         std::array<std::shared_ptr<VulkDepthView>, MAX_FRAMES_IN_FLIGHT> shadowMapViews);
+    std::shared_ptr<VulkScene> loadScene(std::string const& name,
+                                         std::array<std::shared_ptr<VulkDepthView>, MAX_FRAMES_IN_FLIGHT> shadowMapViews) {
+        return loadSceneAsync(name, shadowMapViews).get();
+    }
+
+    VulkFuture<const VulkMesh> getMeshAsync(MeshDef& meshDef);
+    VulkFuture<const VulkMaterialTextures> getMaterialTexturesAsync(std::string const& name);
+    VulkFuture<const VulkModel> getModelAsync(ModelDef const& modelDef, PipelineDef const& pipelineDef);
 
     std::shared_ptr<const VulkShaderModule> getvertShader(std::string const& name) const {
-        if (!vertShaders.contains(name))
-            vertShaders[name] = createShaderModule(Vert, name);
-        return vertShaders.at(name);
+        return getShader(Vert, name);
     }
     std::shared_ptr<const VulkShaderModule> getGeometryShader(std::string const& name) const {
-        if (!geomShaders.contains(name))
-            geomShaders[name] = createShaderModule(Geom, name);
-        return geomShaders.at(name);
+        return getShader(Geom, name);
     }
     std::shared_ptr<const VulkShaderModule> getFragmentShader(std::string const& name) const {
-        if (!fragShaders.contains(name))
-            fragShaders[name] = createShaderModule(Frag, name);
-        return fragShaders.at(name);
+        return getShader(Frag, name);
     }
 
     std::shared_ptr<const VulkDescriptorSetInfo> createDSInfoFromPipeline(VulkPipeline const& pipeline,
@@ -92,8 +111,19 @@ class VulkResources {
                                                              vulk::VulkDeferredRenderpass const* deferredRenderpass);
 
     std::shared_ptr<const VulkDescriptorSetLayout> buildDescriptorSetLayoutFromPipeline(std::string name);
-    std::shared_ptr<const VulkPipeline> loadPipeline(VkRenderPass renderPass, VkExtent2D extent, std::string const& name);
+    VulkFuture<const VulkPipeline> loadPipelineAsync(VkRenderPass renderPass, VkExtent2D extent, std::string const& name);
+    std::shared_ptr<const VulkPipeline> loadPipeline(VkRenderPass renderPass, VkExtent2D extent, std::string const& name) {
+        return loadPipelineAsync(renderPass, extent, name).get();
+    }
+    // starts every pipeline in loads compiling on the workers before waiting on any, so they build in parallel against
+    // vk.pipelineCache rather than one after another. the results are in the order of loads, and in pipelines
+    std::vector<VulkFuture<const VulkPipeline>> loadPipelinesAsync(std::vector<VulkPipelineLoad> const& loads);
+    std::vector<std::shared_ptr<const VulkPipeline>> loadPipelines(std::vector<VulkPipelineLoad> const& loads);
     std::shared_ptr<const VulkPipeline> getPipeline(std::string const& name) {
-        return pipelines.at(name);
+        return pipelines.at(name).get();
     }
+
+   private:
+    VulkTextureCache textureCache;  // decoded pixels on disk, next to the assets
+    VulkThreadPool workers;  // last, so it finishes what it's doing before anything it uses goes away
 };
\ No newline at end of file
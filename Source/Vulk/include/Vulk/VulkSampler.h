@@ -44,7 +44,10 @@ class VulkSampler {
         return std::make_shared<VulkSampler>(vk, sampler);
     }
 
-    static std::shared_ptr<VulkSampler> createImageSampler(Vulk& vk) {
-        return std::make_shared<VulkSampler>(vk, vk.createTextureSampler());
+    // samples up to maxLod, which is clamped to the image view's mip levels anyway, so the default
+    // suits every texture whether it has mips or not. pass a VulkImageView's mipLevels - 1 to
+    // make a sampler that matches one image exactly
+    static std::shared_ptr<VulkSampler> createImageSampler(Vulk& vk, float maxLod = VK_LOD_CLAMP_NONE) {
+        return std::make_shared<VulkSampler>(vk, vk.createTextureSampler(maxLod));
     }
 };
\ No newline at end of file
@@ -1,7 +1,12 @@
 #pragma once
 
+#include <memory>
+#include <unordered_map>
+
 #include "VulkActor.h"
 #include "VulkCamera.h"
+#include "VulkFrameSSBOs.h"
+#include "VulkFrameUBOArena.h"
 #include "VulkFrameUBOs.h"
 #include "VulkPointLight.h"
 #include "VulkUBO.h"
@@ -13,11 +18,19 @@ namespace vulk {
 class VulkDeferredRenderpass;
 }
 struct SceneDef;
+struct ActorDef;
 
 struct LightsUBO {
     VulkPointLight lights[(int)vulk::cpp2::VulkLights::NumLights];
 };
 
+// what an instanced draw needs per actor, see VulkActorBatch. matches Instance in common.glsl, which is std430
+struct VulkInstance {
+    alignas(16) glm::mat4 xform;
+    uint32_t pickID;  // 0 is nothing, see VulkPickRenderpass
+};
+static_assert(sizeof(VulkInstance) == 80, "VulkInstance has to match the std430 layout");
+
 struct VulkSceneUBOs {
     struct XformsUBO {
         alignas(16) glm::mat4 world;
@@ -28,7 +41,10 @@ struct VulkSceneUBOs {
     VulkFrameUBOs<XformsUBO> xforms;
     VulkFrameUBOs<glm::vec3> eyePos;
     VulkUniformBuffer<LightsUBO> lightsUBO;
-    VulkSceneUBOs(Vulk& vk) : xforms(vk), eyePos(vk), lightsUBO(vk) {}
+    // the per actor UBOs, e.g. each model's transform
+    std::shared_ptr<VulkFrameUBOArena> actorUBOs;
+    VulkSceneUBOs(Vulk& vk)
+        : xforms(vk), eyePos(vk), lightsUBO(vk), actorUBOs(std::make_shared<VulkFrameUBOArena>(vk)) {}
 };
 
 class VulkScene {
@@ -39,6 +55,11 @@ class VulkScene {
 
     std::shared_ptr<vulk::VulkDeferredRenderpass> deferredRenderpass;
 
+    // one per actor, ordered so actors with the same model are next to each other and can be drawn with one
+    // instanced draw. actorInstances is where each actor is. set up by VulkResources::loadSceneAsync
+    std::unique_ptr<VulkFrameSSBOs<VulkInstance>> instances;
+    std::unordered_map<ActorDef const*, uint32_t> actorInstances;
+
     mutable std::shared_ptr<VulkUniformBuffer<VulkLightViewProjUBO>> lightViewProjUBO;
     mutable std::array<std::shared_ptr<VulkDepthView>, MAX_FRAMES_IN_FLIGHT> shadowMapViews;
     mutable std::shared_ptr<VulkUniformBuffer<VulkGlobalConstantsUBO>> globalConstantsUBO;
@@ -6,9 +6,9 @@
  * between the vertex shader and the fragment shader. SSBOs are useful when you need to pass large amounts of data to shaders, or
  * when you need to read and write data from within a shader.
  *
- * The VulkStorageBuffer struct encapsulates a Vulkan buffer handle, a device memory handle, and a contiguous array of memory
- * mapped objects. It provides methods to create and map the memory for the buffer, as well as clean up the buffer and device
- * memory.
+ * The VulkStorageBuffer struct encapsulates a Vulkan buffer handle, its device memory allocation, and a contiguous array of
+ * memory mapped objects. It provides methods to create and map the memory for the buffer, as well as clean up the buffer and
+ * device memory.
  *
  * Usage example:
  *
@@ -20,7 +20,7 @@
  *     storageBuffer.mappedObjs[i].data = ...;
  * }
  *
- * storageBuffer.cleanup(vk.device);
+ * storageBuffer.cleanup(vk);
  */
 #pragma once
 
@@ -30,10 +30,10 @@
 template <typename T>
 class VulkStorageBuffer : public ClassNonCopyableNonMovable {
    public:
-    VkBuffer buf;        // Vulkan buffer handle
-    VkDeviceMemory mem;  // Vulkan device memory handle
-    T* mappedObjs;       // Contiguous array of memory mapped objects
-    uint32_t numObjs;    // Number of objects in the buffer
+    VkBuffer buf;          // Vulkan buffer handle
+    VulkAllocation alloc;  // Where the buffer lives in device memory
+    T* mappedObjs;         // Contiguous array of memory mapped objects
+    uint32_t numObjs;      // Number of objects in the buffer
 
     /**
      * Creates a Vulkan storage buffer and maps the memory for the specified number of objects.
@@ -47,19 +47,18 @@ class VulkStorageBuffer : public ClassNonCopyableNonMovable {
             VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
             buf,
-            mem
+            alloc
         );
-        vkMapMemory(vk.device, mem, 0, bufferSize, 0, (void**)&mappedObjs);
+        mappedObjs = static_cast<T*>(alloc.mapped);
         numObjs = numElts;
     }
 
     /**
      * Cleans up the Vulkan buffer and device memory.
-     * @param dev The Vulkan device.
+     * @param vk The Vulk object the buffer was created with.
      */
-    void cleanup(VkDevice dev) {
-        vkDestroyBuffer(dev, buf, nullptr);
-        vkFreeMemory(dev, mem, nullptr);
+    void cleanup(Vulk& vk) {
+        vk.destroyBuffer(buf, alloc);
     }
 
     uint32_t getSize() {
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+class VulkAssetPack;
+
+// RGBA8 pixels, however they were decoded
+struct VulkDecodedImage {
+    uint32_t width  = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels;  // width * height * 4
+};
+
+// A cache entry is this header followed by the pixels
+struct VulkDecodedImageHeader {
+    static constexpr char MAGIC[4]    = {'V', 'K', 'T', 'X'};
+    static constexpr uint32_t VERSION = 1;  // bump if the layout or the decoding changes
+
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+};
+static_assert(sizeof(VulkDecodedImageHeader) == 16);
+
+// Decodes image files (png, jpg, etc.) to RGBA8 and keeps the results on disk, named by the hash
+// of the encoded bytes, so loading an unchanged texture again is a read rather than a decode.
+// Decoding is most of the CPU time spent loading a PBR material's textures.
+// - an empty cacheDir turns the disk cache off
+// - entries are written to a temp file and renamed into place, so readers never see half of
+//   one. thread safe: two threads decoding the same image only wastes some work
+// - entries that can't be read or are from an old VERSION are decoded again and rewritten
+// - if an entry can't be written, e.g. the directory is read only, we stop trying
+// - nothing is evicted, delete the directory to clear it
+class VulkTextureCache {
+   public:
+    explicit VulkTextureCache(std::filesystem::path cacheDir = {});
+
+    // where the cache for an assets dir goes: Assets -> Assets.texcache
+    static std::filesystem::path cacheDirFor(std::filesystem::path assetsDir);
+
+    // encoded is the contents of an image file, name is for errors
+    VulkDecodedImage decode(std::span<char const> encoded, std::string const& name);
+    // reads path from pack if it has it, otherwise from disk. pack can be null
+    VulkDecodedImage load(VulkAssetPack const* pack, std::filesystem::path const& path);
+
+    static VulkDecodedImage decodeUncached(std::span<char const> encoded, std::string const& name);
+
+    uint32_t numHits() const {
+        return hits;
+    }
+    uint32_t numMisses() const {
+        return misses;
+    }
+
+   private:
+    std::filesystem::path cacheDir;
+    std::atomic<bool> writable   = true;
+    std::atomic<uint32_t> hits   = 0;
+    std::atomic<uint32_t> misses = 0;
+
+    bool readEntry(std::filesystem::path const& path, VulkDecodedImage& image) const;
+    void writeEntry(std::filesystem::path const& path, VulkDecodedImage const& image);
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "ClassNonCopyableNonMovable.h"
+
+// A fixed set of worker threads that run tasks in the order they were submitted. Because of the
+// ordering a task can block on the future of anything submitted before it: that was picked up
+// first, so it's running or done, and the pool can't deadlock on itself. Don't wait on anything
+// submitted after, or from inside the task.
+//
+// Exceptions end up in the task's future. The destructor runs whatever is still queued and joins.
+class VulkThreadPool : public ClassNonCopyableNonMovable {
+   public:
+    explicit VulkThreadPool(uint32_t numThreads = defaultNumThreads()) {
+        for (uint32_t i = 0; i < std::max(numThreads, 1u); ++i) {
+            threads.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+    ~VulkThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    }
+
+    // leave a core for the thread that's submitting
+    static uint32_t defaultNumThreads() {
+        return std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+
+    uint32_t numThreads() const {
+        return static_cast<uint32_t>(threads.size());
+    }
+
+    template <typename F>
+    std::future<std::invoke_result_t<F>> submit(F&& fn) {
+        // std::function has to be copyable, packaged_task isn't
+        auto task   = std::make_shared<std::packaged_task<std::invoke_result_t<F>()>>(std::forward<F>(fn));
+        auto future = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.emplace_back([task]() { (*task)(); });
+        }
+        cv.notify_one();
+        return future;
+    }
+
+   private:
+    std::vector<std::thread> threads;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stopping = false;
+
+    void workerLoop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if (tasks.empty()) {
+                    return;
+                }
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
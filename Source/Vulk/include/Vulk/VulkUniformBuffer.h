@@ -43,7 +43,7 @@
 template <typename T>
 class VulkUniformBuffer : public ClassNonCopyableNonMovable {
     Vulk& vk;
-    VkDeviceMemory mem;
+    VulkAllocation alloc;
 
     void init() {
         VkDeviceSize bufferSize = sizeof(T);
@@ -52,14 +52,15 @@ class VulkUniformBuffer : public ClassNonCopyableNonMovable {
             VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
             buf,
-            mem
+            alloc
         );
-        vkMapMemory(vk.device, mem, 0, bufferSize, 0, (void**)&mappedUBO);
+        mappedUBO = static_cast<T*>(alloc.mapped);
     }
 
    public:
     VkBuffer buf;
     T* mappedUBO;
+    uint64_t const id = vulkUniqueId();  // stands in for buf in cache keys, see VulkDescriptorSetBuilder
 
     VulkUniformBuffer(Vulk& vk) : vk(vk) {
         init();
@@ -71,9 +72,7 @@ class VulkUniformBuffer : public ClassNonCopyableNonMovable {
     }
 
     ~VulkUniformBuffer() {
-        vkUnmapMemory(vk.device, mem);
-        vkDestroyBuffer(vk.device, buf, nullptr);
-        vkFreeMemory(vk.device, mem, nullptr);
+        vk.destroyBuffer(buf, alloc);
     }
 
     VkDeviceSize getSize() const {
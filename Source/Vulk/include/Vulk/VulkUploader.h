@@ -0,0 +1,148 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "ClassNonCopyableNonMovable.h"
+#include "VulkMemoryAllocator.h"
+
+class Vulk;
+
+// Gets data into device local buffers and images without a round trip to the GPU per resource.
+// Uploads are copied into a persistently mapped staging ring right away (so the caller's memory
+// can go as soon as the call returns) and the copies are recorded into one command buffer that
+// is submitted to the transfer queue when:
+// - submit() is called, which Vulk::render does before each frame so everything uploaded
+//   before a frame is visible to it
+// - flush() is called, which also waits for it all to land. use this when the data is needed
+//   right away, e.g. reading it back
+// When the ring fills up we wait for the oldest batch to retire and reuse its space. If it's the
+// batch being recorded that filled it, the rest of its uploads get their own staging buffers, as
+// do uploads bigger than half the ring. Those are freed when their batch retires. Images end up
+// in SHADER_READ_ONLY_OPTIMAL.
+//
+// When the device has a dedicated transfer queue family the copies run there, off the graphics
+// queue, and each batch releases ownership of what it wrote to the graphics family. submit()
+// then queues the matching acquire on the graphics queue, waiting (on the GPU, the CPU never
+// blocks) for the batch's timeline value. Without one everything goes on the graphics queue and
+// a barrier at the end of each batch covers whatever is submitted after it.
+//
+// Batches are tracked with timeline semaphores rather than a fence each. Thread safe: uploads
+// never touch a queue so any thread can make them, e.g. VulkResources' loaders. submit() and
+// flush() use the graphics queue so they belong on the thread that renders.
+class VulkUploader : public ClassNonCopyableNonMovable {
+   public:
+    static constexpr VkDeviceSize DEFAULT_RING_SIZE = 32ull * 1024 * 1024;
+
+    VulkUploader(Vulk& vk,
+                 uint32_t transferFamily,
+                 VkQueue transferQueue,
+                 uint32_t graphicsFamily,
+                 VkQueue graphicsQueue,
+                 VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+    ~VulkUploader();
+
+    void uploadToBuffer(VkBuffer dst, VkDeviceSize dstOffset, void const* data, VkDeviceSize size);
+    // layers are each layerSize bytes of tightly packed texels for mip 0 of that layer, e.g. 6 faces of a cubemap
+    void uploadToImage(VkImage dst, VkExtent2D extent, VkDeviceSize layerSize, std::span<void const* const> layers);
+    void uploadToImage(VkImage dst, VkExtent2D extent, void const* data, VkDeviceSize size) {
+        uploadToImage(dst, extent, size, std::span<void const* const>(&data, 1));
+    }
+    // data is every mip level of the image back to back, largest first, mipSizes[i] bytes for level i.
+    // for block compressed formats each level is whole blocks, e.g. a VulkCookedTexture's data
+    void uploadMipsToImage(VkImage dst, VkExtent2D extent, std::span<VkDeviceSize const> mipSizes, void const* data);
+    // uploads mip 0 and fills in the rest of the mipLevels by blitting each level down from the one above.
+    // the format has to support linear filtered blits, see Vulk::createTextureImage. the blits run on the
+    // graphics queue, with the acquire if there's a transfer queue
+    void uploadAndGenerateMips(VkImage dst, VkExtent2D extent, uint32_t mipLevels, void const* data, VkDeviceSize size);
+
+    // start the pending uploads on the GPU, doesn't wait for them. anything submitted to the
+    // graphics queue after this sees them
+    void submit();
+    // submit and wait for every upload so far to finish
+    void flush();
+
+    bool usesTransferQueue() const {
+        return transferFamily != graphicsFamily;
+    }
+
+   private:
+    // copies into the ring start at multiples of this, enough for any texel block size
+    static constexpr VkDeviceSize ALIGNMENT = 16;
+
+    // an image whose mip 0 has been written and whose other levels need blitting from it
+    struct MipGeneration {
+        VkImage image;
+        VkExtent2D extent;
+        uint32_t mipLevels;
+    };
+    struct Batch {
+        VkCommandBuffer cmd  = VK_NULL_HANDLE;
+        uint64_t value       = 0;  // transferTimeline reaches this when the batch is done
+        VkDeviceSize ringEnd = 0;  // ring position after this batch's last upload
+        std::vector<std::pair<VkBuffer, VulkAllocation>> ownStaging;
+        std::vector<VkBufferMemoryBarrier> bufferAcquires;
+        std::vector<VkImageMemoryBarrier> imageAcquires;
+        std::vector<MipGeneration> mipGenerations;  // done after the acquires, on the graphics queue
+    };
+    struct AcquireBatch {
+        VkCommandBuffer cmd;
+        uint64_t value;  // acquireTimeline reaches this when the batch is done
+    };
+
+    Vulk& vk;
+    uint32_t transferFamily;
+    VkQueue transferQueue;
+    uint32_t graphicsFamily;
+    VkQueue graphicsQueue;
+    VkCommandPool transferPool;
+    VkCommandPool graphicsPool;  // for the acquires, only if usesTransferQueue()
+    VkSemaphore transferTimeline;
+    VkSemaphore acquireTimeline;
+    uint64_t transferValue = 0;  // last value submitted
+    uint64_t acquireValue  = 0;
+
+    VkDeviceSize ringSize;
+    VkBuffer ring;
+    VulkAllocation ringAlloc;
+    // ring positions only ever increase, index the ring with them % ringSize. everything in
+    // [tail, head) is still waiting to be copied by the GPU
+    VkDeviceSize head = 0;
+    VkDeviceSize tail = 0;
+
+    bool recording = false;
+    Batch current;
+    std::deque<Batch> inFlight;  // oldest first
+    std::vector<VkCommandBuffer> freeCmds;
+    // released by submitted batches, waiting to be acquired on the graphics queue
+    std::vector<VkBufferMemoryBarrier> pendingBufferAcquires;
+    std::vector<VkImageMemoryBarrier> pendingImageAcquires;
+    std::vector<MipGeneration> pendingMipGenerations;
+    std::deque<AcquireBatch> acquiresInFlight;
+    std::vector<VkCommandBuffer> freeAcquireCmds;
+    std::mutex mutex;
+
+    // these all expect mutex to be held
+    VkCommandBuffer begin();
+    // reserves size bytes in the ring, waiting on the GPU if it's full. returns the offset into
+    // ring, or nullopt if the batch being recorded has filled it
+    std::optional<VkDeviceSize> reserve(VkDeviceSize size);
+    // returns the buffer to copy from and where in it
+    std::pair<VkBuffer, VkDeviceSize> stage(std::span<void const* const> pieces, VkDeviceSize pieceSize);
+    // records the copies and gets dst to SHADER_READ_ONLY_OPTIMAL on the graphics queue
+    void copyToImage(VkBuffer src,
+                     VkImage dst,
+                     std::span<VkBufferImageCopy const> regions,
+                     uint32_t mipLevels,
+                     uint32_t layerCount);
+    // mip 0 is in TRANSFER_DST_OPTIMAL, written by earlier transfer commands. leaves every level SHADER_READ_ONLY_OPTIMAL
+    void recordMipBlits(VkCommandBuffer cmd, MipGeneration const& gen);
+    void submitLocked();
+    void submitAcquires();
+    void retire(bool wait);
+    void retireOldest(bool wait);
+    VkCommandBuffer allocateCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList);
+};
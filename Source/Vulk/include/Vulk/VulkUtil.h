@@ -102,6 +102,8 @@ struct VulkMaterialConstants {
 struct QueueFamilyIndices {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // a family that can transfer but not draw, i.e. backed by a DMA engine. not every device has one
+    std::optional<uint32_t> transferFamily;
 
     bool isComplete() {
         return graphicsFamily.has_value() && presentFamily.has_value();
@@ -119,6 +121,8 @@ class VulkMesh;
 SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface);
 QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surface);
 std::vector<char> readFileIntoMem(const std::string& filename);
+// never handed out twice, unlike a Vulkan handle which the driver can reuse once it's destroyed
+uint64_t vulkUniqueId();
 
 class VulkPauseableTimer {
    public:
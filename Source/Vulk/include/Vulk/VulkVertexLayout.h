@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+#include <glm/gtc/packing.hpp>
+#include <vector>
+
+#include "VulkMesh.h"
+#include "VulkUtil.h"
+
+// Where each vertex input of a pipeline lives in a model's vertex buffers, and how to fill those
+// buffers from a mesh. VulkModel and VulkPipelineBuilder both work from this so the buffers and
+// the attribute descriptions always agree. Inputs are laid out in location order.
+// - Separate: a buffer per attribute, binding == location, 32 bit floats
+// - Interleaved: every attribute in binding 0, 32 bit floats. one allocation, one upload, one bind
+// - Packed: interleaved with normals/tangents as R16G16B16A16_SNORM and uvs as R16G16_SFLOAT,
+//   32 bytes a vertex instead of 44. the vertex fetch expands them so shaders don't change, but
+//   uvs lose precision past a few thousand and normals/tangents are only good to ~1e-5
+class VulkVertexLayout {
+   public:
+    struct Attribute {
+        vulk::cpp2::VulkShaderLocation location;
+        uint32_t binding;
+        VkFormat format;
+        uint32_t offset;
+    };
+    struct Binding {
+        uint32_t binding;
+        uint32_t stride;
+    };
+
+    vulk::cpp2::VulkVertexLayoutType type;
+    std::vector<Attribute> attributes;  // by location
+    std::vector<Binding> bindings;      // by binding
+
+    VulkVertexLayout(vulk::cpp2::VulkVertexLayoutType type, std::vector<vulk::cpp2::VulkShaderLocation> inputs) : type(type) {
+        std::sort(inputs.begin(), inputs.end());
+        VULK_ASSERT(std::adjacent_find(inputs.begin(), inputs.end()) == inputs.end(), "Duplicate vertex input location");
+        uint32_t interleavedStride = 0;
+        for (vulk::cpp2::VulkShaderLocation input : inputs) {
+            VkFormat format = formatFor(type, input);
+            uint32_t size   = formatSize(format);
+            if (type == vulk::cpp2::VulkVertexLayoutType::Separate) {
+                uint32_t binding = static_cast<uint32_t>(input);
+                attributes.push_back({input, binding, format, 0});
+                bindings.push_back({binding, size});
+            } else {
+                attributes.push_back({input, 0, format, interleavedStride});
+                interleavedStride += size;
+            }
+        }
+        if (interleavedStride > 0) {
+            bindings.push_back({0, interleavedStride});
+        }
+    }
+
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions() const {
+        std::vector<VkVertexInputBindingDescription> out;
+        for (Binding const& b : bindings) {
+            out.push_back({b.binding, b.stride, VK_VERTEX_INPUT_RATE_VERTEX});
+        }
+        return out;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions() const {
+        std::vector<VkVertexInputAttributeDescription> out;
+        for (Attribute const& a : attributes) {
+            out.push_back({static_cast<uint32_t>(a.location), a.binding, a.format, a.offset});
+        }
+        return out;
+    }
+
+    // the contents of binding's vertex buffer
+    std::vector<uint8_t> buildVertexBuffer(Binding const& binding, std::vector<Vertex> const& vertices) const {
+        std::vector<uint8_t> out((size_t)binding.stride * vertices.size());
+        for (Attribute const& a : attributes) {
+            if (a.binding != binding.binding) {
+                continue;
+            }
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                writeAttribute(a, vertices[i], out.data() + i * binding.stride + a.offset);
+            }
+        }
+        return out;
+    }
+
+    // throws for locations that don't come from the mesh
+    static VkFormat formatFor(vulk::cpp2::VulkVertexLayoutType type, vulk::cpp2::VulkShaderLocation location) {
+        bool packed = type == vulk::cpp2::VulkVertexLayoutType::Packed;
+        switch (location) {
+            case vulk::cpp2::VulkShaderLocation::Pos:
+                return VK_FORMAT_R32G32B32_SFLOAT;
+            case vulk::cpp2::VulkShaderLocation::Normal:
+            case vulk::cpp2::VulkShaderLocation::Tangent:
+                return packed ? VK_FORMAT_R16G16B16A16_SNORM : VK_FORMAT_R32G32B32_SFLOAT;
+            case vulk::cpp2::VulkShaderLocation::TexCoord:
+                return packed ? VK_FORMAT_R16G16_SFLOAT : VK_FORMAT_R32G32_SFLOAT;
+            default:
+                VULK_THROW("Unknown vertex input location {}", (int)location);
+        }
+    }
+
+    static uint32_t formatSize(VkFormat format) {
+        switch (format) {
+            case VK_FORMAT_R32G32B32_SFLOAT:
+                return sizeof(glm::vec3);
+            case VK_FORMAT_R32G32_SFLOAT:
+            case VK_FORMAT_R16G16B16A16_SNORM:
+                return 8;
+            case VK_FORMAT_R16G16_SFLOAT:
+                return 4;
+            default:
+                VULK_THROW("Unhandled vertex format {}", (int)format);
+        }
+    }
+
+   private:
+    static void writeAttribute(Attribute const& a, Vertex const& v, uint8_t* dst) {
+        glm::vec3 vec3;
+        switch (a.location) {
+            case vulk::cpp2::VulkShaderLocation::Pos:
+                vec3 = v.pos;
+                break;
+            case vulk::cpp2::VulkShaderLocation::Normal:
+                vec3 = v.normal;
+                break;
+            case vulk::cpp2::VulkShaderLocation::Tangent:
+                vec3 = v.tangent;
+                break;
+            case vulk::cpp2::VulkShaderLocation::TexCoord: {
+                if (a.format == VK_FORMAT_R16G16_SFLOAT) {
+                    uint32_t packed = glm::packHalf2x16(v.uv);
+                    memcpy(dst, &packed, sizeof(packed));
+                } else {
+                    memcpy(dst, &v.uv, sizeof(v.uv));
+                }
+                return;
+            }
+            default:
+                VULK_THROW("Unknown vertex input location {}", (int)a.location);
+        }
+        if (a.format == VK_FORMAT_R16G16B16A16_SNORM) {
+            // snorm clamps, so keep longer than unit vectors (e.g. unnormalized tangents) pointing the right way
+            if (glm::length(vec3) > 1.0f) {
+                vec3 = glm::normalize(vec3);
+            }
+            uint64_t packed = glm::packSnorm4x16(glm::vec4(vec3, 0.0f));
+            memcpy(dst, &packed, sizeof(packed));
+        } else {
+            memcpy(dst, &vec3, sizeof(vec3));
+        }
+    }
+};
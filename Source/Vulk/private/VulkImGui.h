@@ -119,7 +119,7 @@ class VulkImGui {
         init_info.Device                    = vk.device;
         init_info.QueueFamily               = vk.indices.graphicsFamily.value();
         init_info.Queue                     = vk.graphicsQueue;
-        init_info.PipelineCache             = nullptr;
+        init_info.PipelineCache             = vk.pipelineCache->get();
         init_info.DescriptorPool            = imguiDescriptorPool;
         init_info.Subpass                   = 0;
         init_info.MinImageCount             = 2;
@@ -202,7 +202,7 @@ void Vulk::createBuffer(VkDeviceSize size,
                         VkBufferUsageFlags usage,
                         VkMemoryPropertyFlags properties,
                         VkBuffer& buffer,
-                        VkDeviceMemory& bufferMemory) {
+                        VulkAllocation& bufferAlloc) {
     VkBufferCreateInfo bufferInfo{};
     bufferInfo.sType       = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
     bufferInfo.size        = size;
@@ -214,34 +214,33 @@ void Vulk::createBuffer(VkDeviceSize size,
     VkMemoryRequirements memRequirements;
     vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize  = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+    bufferAlloc = allocator->allocate(memRequirements, properties, true);
+    VK_CALL(vkBindBufferMemory(device, buffer, bufferAlloc.memory, bufferAlloc.offset));
+}
 
-    VK_CALL(vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory));
+void Vulk::destroyBuffer(VkBuffer buffer, VulkAllocation& bufferAlloc) {
+    vkDestroyBuffer(device, buffer, nullptr);
+    allocator->free(bufferAlloc);
+}
 
-    vkBindBufferMemory(device, buffer, bufferMemory, 0);
+void Vulk::destroyImage(VkImage image, VulkAllocation& imageAlloc) {
+    vkDestroyImage(device, image, nullptr);
+    allocator->free(imageAlloc);
 }
 
 void Vulk::copyMemToBuffer(void const* srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(size,
-                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 stagingBuffer,
-                 stagingBufferMemory);
-    void* data;
-    vkMapMemory(device, stagingBufferMemory, 0, size, 0, &data);
-    memcpy(data, srcBuffer, size);
-    vkUnmapMemory(device, stagingBufferMemory);
-    copyBuffer(stagingBuffer, dstBuffer, size);
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    uploader->uploadToBuffer(dstBuffer, 0, srcBuffer, size);
+}
+
+// the uploader's copies may still be queued in its staging ring, or running on the transfer queue
+void Vulk::flushUploads() {
+    if (uploader) {
+        uploader->flush();
+    }
 }
 
 void Vulk::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+    flushUploads();
     VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
     VkBufferCopy copyRegion{};
@@ -252,6 +251,7 @@ void Vulk::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size)
 }
 
 void Vulk::copyImageToBuffer(VkImage image, VkBuffer buffer, uint32_t width, uint32_t height) {
+    flushUploads();
     VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
     VkBufferImageCopy region{};
@@ -277,32 +277,29 @@ void Vulk::copyBufferToMem(VkBuffer srcBuffer, void* dstBuffer, VkDeviceSize siz
     // Copy the data from the source buffer to the staging buffer
     // Map the staging buffer memory and copy the data to the destination buffer in CPU memory
     VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
+    VulkAllocation stagingBufferAlloc;
     createBuffer(size,
                  VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                  stagingBuffer,
-                 stagingBufferMemory);
+                 stagingBufferAlloc);
     copyBuffer(srcBuffer, stagingBuffer, size);
-    void* data;
-    vkMapMemory(device, stagingBufferMemory, 0, size, 0, &data);
-    memcpy(dstBuffer, data, (size_t)size);
-    vkUnmapMemory(device, stagingBufferMemory);
+    memcpy(dstBuffer, stagingBufferAlloc.mapped, (size_t)size);
     // Clean up the staging buffer and its memory
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    destroyBuffer(stagingBuffer, stagingBufferAlloc);
 }
 
 void Vulk::copyImageToMem(VkImage image, void* dstBuffer, uint32_t width, uint32_t height, VkDeviceSize dstEltSize) {
     VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
+    VulkAllocation stagingBufferAlloc;
     VkDeviceSize size = width * height * dstEltSize;
     createBuffer(size,
                  VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
                  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
                  stagingBuffer,
-                 stagingBufferMemory);
+                 stagingBufferAlloc);
 
+    flushUploads();
     VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
     // VkImageMemoryBarrier barrier{};
@@ -349,8 +346,7 @@ void Vulk::copyImageToMem(VkImage image, void* dstBuffer, uint32_t width, uint32
 
     copyBufferToMem(stagingBuffer, dstBuffer, size);
 
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    destroyBuffer(stagingBuffer, stagingBufferAlloc);
 }
 
 void Vulk::initWindow() {
@@ -376,10 +372,18 @@ void Vulk::initVulkan() {
     createSurface();
     pickPhysicalDevice();
     createLogicalDevice();
+    allocator           = VulkMemoryAllocator::create(device, physicalDevice);
+    pipelineCache       = std::make_unique<VulkPipelineCache>(device, physicalDevice, pipelineCachePath);
+    descriptorAllocator = std::make_unique<VulkDescriptorAllocator>(device);
     createSwapChain();
     createImageViews();
     createRenderPass();
     createCommandPool();
+    uploader = std::make_unique<VulkUploader>(*this,
+                                              indices.transferFamily.value_or(indices.graphicsFamily.value()),
+                                              transferQueue,
+                                              indices.graphicsFamily.value(),
+                                              graphicsQueue);
     createCommandBuffers();
     createDepthResources();
     createFramebuffers();
@@ -390,8 +394,7 @@ void Vulk::initVulkan() {
 
 void Vulk::cleanupSwapChain() {
     vkDestroyImageView(device, depthImageView, nullptr);
-    vkDestroyImage(device, depthImage, nullptr);
-    vkFreeMemory(device, depthImageMemory, nullptr);
+    destroyImage(depthImage, depthImageAlloc);
 
     for (auto framebuffer : swapChainFramebuffers) {
         vkDestroyFramebuffer(device, framebuffer, nullptr);
@@ -409,6 +412,7 @@ void Vulk::cleanupVulkan() {
 
     renderable.reset();
     uiRenderer.reset();
+    uploader.reset();
 
     cleanupSwapChain();
 
@@ -420,6 +424,26 @@ void Vulk::cleanupVulkan() {
 
     vkDestroyCommandPool(device, commandPool, nullptr);
     vkDestroyRenderPass(device, renderPass, nullptr);
+
+    VulkDescriptorAllocator::Stats dsStats = descriptorAllocator->getStats();
+    logger->info("Descriptor sets at exit: {} pools, {} sets, {} cache hits, {} misses",
+                 dsStats.numPools,
+                 dsStats.numSets,
+                 dsStats.cacheHits,
+                 dsStats.cacheMisses);
+    descriptorAllocator.reset();
+
+    pipelineCache->logStats();
+    pipelineCache->save();
+    pipelineCache.reset();
+
+    VulkMemoryStats memStats = allocator->getStats();
+    logger->info("Device memory at exit: {} blocks, {} dedicated, {} bytes reserved, {:.2f} fragmentation",
+                 memStats.numBlocks,
+                 memStats.numDedicated,
+                 memStats.reservedBytes,
+                 memStats.fragmentation());
+    allocator.reset();
     vkDestroyDevice(device, nullptr);
 
     if (enableValidationLayers) {
@@ -444,15 +468,41 @@ static const std::unordered_map<VkFormat, uint32_t> numChannelsFromFormat = {
 };
 
 VkImage Vulk::createTextureImage(char const* texture_path,
-                                 VkDeviceMemory& textureImageMemory,
+                                 VulkAllocation& textureImageAlloc,
                                  VkImage& textureImage,
                                  bool isUNORM,
                                  VkFormat& formatOut) {
-    int texWidth, texHeight, texChannels;
-    stbi_uc* pixels        = stbi_load(texture_path, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-    VkDeviceSize imageSize = texWidth * texHeight * 4;  // not texChannels because we always load 4 channels because
-                                                        // drivers prefer 32 bit aligned data...
-    assert(pixels);
+    std::vector<char> encoded = readFileIntoMem(texture_path);
+    return createTextureImage(encoded, texture_path, textureImageAlloc, textureImage, isUNORM, formatOut);
+}
+
+VkImage Vulk::createTextureImage(std::span<char const> encoded,
+                                 char const* name,
+                                 VulkAllocation& textureImageAlloc,
+                                 VkImage& textureImage,
+                                 bool isUNORM,
+                                 VkFormat& formatOut) {
+    VulkDecodedImage decoded = VulkTextureCache::decodeUncached(encoded, name);
+    return createTextureImage(decoded, textureImageAlloc, textureImage, isUNORM, formatOut);
+}
+
+VkImage Vulk::createTextureImage(VulkDecodedImage const& decoded,
+                                 VulkAllocation& textureImageAlloc,
+                                 VkImage& textureImage,
+                                 bool isUNORM,
+                                 VkFormat& formatOut) {
+    uint32_t mipLevels;
+    return createTextureImage(decoded, textureImageAlloc, textureImage, isUNORM, formatOut, false, mipLevels);
+}
+
+VkImage Vulk::createTextureImage(VulkDecodedImage const& decoded,
+                                 VulkAllocation& textureImageAlloc,
+                                 VkImage& textureImage,
+                                 bool isUNORM,
+                                 VkFormat& formatOut,
+                                 bool generateMips,
+                                 uint32_t& mipLevelsOut) {
+    VkDeviceSize imageSize = decoded.pixels.size();  // always 4 channels because drivers prefer 32 bit aligned data
     VkFormat format;
     if (isUNORM) {
         format = VK_FORMAT_R8G8B8A8_UNORM;
@@ -461,45 +511,57 @@ VkImage Vulk::createTextureImage(char const* texture_path,
     }
     formatOut = format;
 
-    VkBuffer stagingBuffer;
-    VkDeviceMemory stagingBufferMemory;
-    createBuffer(imageSize,
-                 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-                 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-                 stagingBuffer,
-                 stagingBufferMemory);
-
-    void* data;
-    vkMapMemory(device, stagingBufferMemory, 0, imageSize, 0, &data);
-    memcpy(data, pixels, static_cast<size_t>(imageSize));
-    vkUnmapMemory(device, stagingBufferMemory);
-
-    stbi_image_free(pixels);
+    // the mips are made by blitting each level from the one above with linear filtering
+    uint32_t mipLevels = 1;
+    if (generateMips) {
+        try {
+            findSupportedFormat({format},
+                                VK_IMAGE_TILING_OPTIMAL,
+                                VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT |
+                                    VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT);
+            mipLevels = VulkCookedTexture::numMipLevels(decoded.width, decoded.height);
+        } catch (VulkException const&) {
+            logger->warn("Format {} can't be blitted with linear filtering, not generating mips", (int)format);
+        }
+    }
+    mipLevelsOut = mipLevels;
 
-    createImage(texWidth,
-                texHeight,
+    VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    if (mipLevels > 1) {
+        usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    }
+    createImage(decoded.width,
+                decoded.height,
                 format,
                 VK_IMAGE_TILING_OPTIMAL,
-                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                usage,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                 textureImage,
-                textureImageMemory);
-
-    VkCommandBuffer commandBuffer = beginSingleTimeCommands();
-    transitionImageLayout(commandBuffer, textureImage, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-    endSingleTimeCommands(commandBuffer);
+                textureImageAlloc,
+                mipLevels);
 
-    copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight));
+    VkExtent2D extent = {decoded.width, decoded.height};
+    if (mipLevels > 1) {
+        uploader->uploadAndGenerateMips(textureImage, extent, mipLevels, decoded.pixels.data(), imageSize);
+    } else {
+        uploader->uploadToImage(textureImage, extent, decoded.pixels.data(), imageSize);
+    }
+    return textureImage;
+}
 
-    commandBuffer = beginSingleTimeCommands();
-    transitionImageLayout(commandBuffer,
-                          textureImage,
-                          VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                          VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
-    endSingleTimeCommands(commandBuffer);
+VkImage Vulk::createTextureImage(VulkCookedTexture const& cooked, VulkAllocation& textureImageAlloc, VkImage& textureImage) {
+    createImage(cooked.width,
+                cooked.height,
+                cooked.format,
+                VK_IMAGE_TILING_OPTIMAL,
+                VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                textureImage,
+                textureImageAlloc,
+                cooked.mipLevels);
 
-    vkDestroyBuffer(device, stagingBuffer, nullptr);
-    vkFreeMemory(device, stagingBufferMemory, nullptr);
+    std::vector<VkDeviceSize> mipSizes = cooked.mipSizes();
+    uploader->uploadMipsToImage(textureImage, {cooked.width, cooked.height}, mipSizes, cooked.data.data());
     return textureImage;
 }
 
@@ -517,6 +579,11 @@ uint32_t Vulk::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags propert
 }
 
 VkShaderModule Vulk::createShaderModule(const std::vector<char>& code) {
+    return createShaderModule(std::span<char const>(code));
+}
+
+// code must be 4 byte aligned, vectors and asset pack entries both are
+VkShaderModule Vulk::createShaderModule(std::span<char const> code) {
     VkShaderModuleCreateInfo createInfo{};
     createInfo.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     createInfo.codeSize = code.size();
@@ -541,7 +608,7 @@ VkDescriptorSet Vulk::createDescriptorSet(VkDescriptorSetLayout descriptorSetLay
     return descriptorSet;
 }
 
-VkSampler Vulk::createTextureSampler() {
+VkSampler Vulk::createTextureSampler(float maxLod) {
     VkPhysicalDeviceProperties properties{};
     vkGetPhysicalDeviceProperties(physicalDevice, &properties);
 
@@ -559,13 +626,15 @@ VkSampler Vulk::createTextureSampler() {
     samplerInfo.compareEnable           = VK_FALSE;
     samplerInfo.compareOp               = VK_COMPARE_OP_ALWAYS;
     samplerInfo.mipmapMode              = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    samplerInfo.minLod                  = 0.0f;
+    samplerInfo.maxLod                  = maxLod;
 
     VkSampler textureSampler;
     VK_CALL(vkCreateSampler(device, &samplerInfo, nullptr, &textureSampler));
     return textureSampler;
 }
 
-VkImageView Vulk::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags) {
+VkImageView Vulk::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels) {
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType                           = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
     viewInfo.image                           = image;
@@ -573,7 +642,7 @@ VkImageView Vulk::createImageView(VkImage image, VkFormat format, VkImageAspectF
     viewInfo.format                          = format;
     viewInfo.subresourceRange.aspectMask     = aspectFlags;
     viewInfo.subresourceRange.baseMipLevel   = 0;
-    viewInfo.subresourceRange.levelCount     = 1;
+    viewInfo.subresourceRange.levelCount     = mipLevels;
     viewInfo.subresourceRange.baseArrayLayer = 0;
     viewInfo.subresourceRange.layerCount     = 1;
 
@@ -732,6 +801,9 @@ void Vulk::createLogicalDevice() {
 
     std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
     std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily.value(), indices.presentFamily.value()};
+    if (indices.transferFamily) {
+        uniqueQueueFamilies.insert(indices.transferFamily.value());
+    }
 
     float queuePriority = 1.0f;
     for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -748,8 +820,20 @@ void Vulk::createLogicalDevice() {
     deviceFeatures.geometryShader    = VK_TRUE;
     deviceFeatures.fillModeNonSolid  = VK_TRUE;  // enables wireframe
 
+    // optional: without it the cooked textures aren't used
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+    bcTextureCompression                = supportedFeatures.textureCompressionBC == VK_TRUE;
+    deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+
+    // VulkUploader tracks its batches with timeline semaphores
+    VkPhysicalDeviceVulkan12Features vulkan12Features{};
+    vulkan12Features.sType             = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    vulkan12Features.timelineSemaphore = VK_TRUE;
+
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = &vulkan12Features;
 
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
     createInfo.pQueueCreateInfos    = queueCreateInfos.data();
@@ -770,6 +854,13 @@ void Vulk::createLogicalDevice() {
 
     vkGetDeviceQueue(device, indices.graphicsFamily.value(), 0, &graphicsQueue);
     vkGetDeviceQueue(device, indices.presentFamily.value(), 0, &presentQueue);
+    if (indices.transferFamily) {
+        vkGetDeviceQueue(device, indices.transferFamily.value(), 0, &transferQueue);
+        logger->info("Uploading on transfer queue family {}", indices.transferFamily.value());
+    } else {
+        transferQueue = graphicsQueue;
+        logger->info("No transfer queue family, uploading on the graphics queue");
+    }
 }
 
 void Vulk::createSwapChain() {
@@ -936,7 +1027,7 @@ void Vulk::createDepthResources() {
                 VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                 depthImage,
-                depthImageMemory);
+                depthImageAlloc);
     depthImageView = createImageView(depthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT);
 }
 
@@ -997,14 +1088,15 @@ void Vulk::createImage(uint32_t width,
                        VkImageUsageFlags usage,
                        VkMemoryPropertyFlags properties,
                        VkImage& image,
-                       VkDeviceMemory& imageMemory) {
+                       VulkAllocation& imageAlloc,
+                       uint32_t mipLevels) {
     VkImageCreateInfo imageInfo{};
     imageInfo.sType         = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
     imageInfo.imageType     = VK_IMAGE_TYPE_2D;
     imageInfo.extent.width  = width;
     imageInfo.extent.height = height;
     imageInfo.extent.depth  = 1;
-    imageInfo.mipLevels     = 1;
+    imageInfo.mipLevels     = mipLevels;
     imageInfo.arrayLayers   = 1;
     imageInfo.format        = format;
     imageInfo.tiling        = tiling;
@@ -1019,13 +1111,8 @@ void Vulk::createImage(uint32_t width,
     VkMemoryRequirements memRequirements;
     vkGetImageMemoryRequirements(device, image, &memRequirements);
 
-    VkMemoryAllocateInfo allocInfo{};
-    allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    allocInfo.allocationSize  = memRequirements.size;
-    allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-    VK_CALL(vkAllocateMemory(device, &allocInfo, nullptr, &imageMemory));
-    VK_CALL(vkBindImageMemory(device, image, imageMemory, 0));
+    imageAlloc = allocator->allocate(memRequirements, properties, tiling == VK_IMAGE_TILING_LINEAR);
+    VK_CALL(vkBindImageMemory(device, image, imageAlloc.memory, imageAlloc.offset));
 }
 
 void Vulk::transitionImageLayout(VkCommandBuffer commandBuffer,
@@ -1096,6 +1183,7 @@ void Vulk::transitionImageLayout(VkCommandBuffer commandBuffer,
 }
 
 void Vulk::copyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height) {
+    flushUploads();
     VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
     VkBufferImageCopy region{};
@@ -1226,6 +1314,8 @@ void Vulk::render() {
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores    = signalSemaphores;
 
+    // anything uploaded before this frame has to be on the queue ahead of it
+    uploader->submit();
     VK_CALL(vkQueueSubmit(graphicsQueue, 1, &submitInfo, inFlightFences[currentFrame]));
 
     VkPresentInfoKHR presentInfo{};
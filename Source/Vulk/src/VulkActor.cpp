@@ -1,4 +1,45 @@
 #include "Vulk/VulkActor.h"
+
+#include <algorithm>
+#include <tuple>
+
+#include "Vulk/VulkDescriptorSetBuilder.h"
 #include "Vulk/VulkScene.h"
 
 using namespace std;
+
+void VulkActorBatch::draw(VkCommandBuffer commandBuffer, uint32_t frame) const {
+    VulkModel const& model = *actor->model;
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, actor->pipeline->pipeline);
+    actor->dsInfo->bind(commandBuffer, actor->pipeline->pipelineLayout, frame);
+    model.bindInputBuffers(commandBuffer);
+    model.draw(commandBuffer, instanceCount, firstInstance);
+}
+
+vector<VulkActorBatch> VulkActorBatch::batchActors(span<shared_ptr<const VulkActor> const> actors) {
+    // everything that has to be the same for two actors to be drawn together. the sets are compared rather than the
+    // VulkDescriptorSetInfos, which are per actor, because sets bound to the same things are shared
+    auto key = [](VulkActor const& a) {
+        return tie(a.pipeline, a.model, a.dsInfo->descriptorSets, a.dsInfo->dynamicOffsets);
+    };
+    vector<shared_ptr<const VulkActor>> sorted(actors.begin(), actors.end());
+    sort(sorted.begin(), sorted.end(), [&key](auto const& a, auto const& b) {
+        return tuple_cat(key(*a), tie(a->instance)) < tuple_cat(key(*b), tie(b->instance));
+    });
+
+    vector<VulkActorBatch> batches;
+    for (auto const& actor : sorted) {
+        // a dynamic UBO means a per actor binding such as ModelXform, which the shader reads in place of the instance.
+        // actors can share one (it hangs off the VulkModel), so matching offsets don't make them drawable together
+        bool instanced = actor->dsInfo->dynamicOffsets.empty();
+        if (instanced && !batches.empty()) {
+            VulkActorBatch& last = batches.back();
+            if (key(*last.actor) == key(*actor) && last.firstInstance + last.instanceCount == actor->instance) {
+                last.instanceCount++;
+                continue;
+            }
+        }
+        batches.push_back({actor, actor->instance, 1});
+    }
+    return batches;
+}
@@ -0,0 +1,169 @@
+#include "Vulk/VulkAssetPack.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#pragma warning(push)
+#pragma warning(disable : 4702)  // unreachable code
+#include <thrift/lib/cpp2/protocol/Serializer.h>
+#pragma warning(pop)
+
+namespace fs = std::filesystem;
+
+DECLARE_FILE_LOGGER();
+
+VulkAssetPack::VulkAssetPack(fs::path packFile, fs::path mountDir)
+    : packFile(packFile), mountDir(fs::absolute(mountDir).lexically_normal()) {
+#ifdef _WIN32
+    HANDLE file = CreateFileW(
+        packFile.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    VULK_ASSERT(file != INVALID_HANDLE_VALUE, "Failed to open asset pack {}", packFile.string());
+    fileHandle = file;
+    LARGE_INTEGER fileSize;
+    VULK_ASSERT(GetFileSizeEx(file, &fileSize), "Failed to get size of asset pack {}", packFile.string());
+    size          = (size_t)fileSize.QuadPart;
+    mappingHandle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    VULK_ASSERT(mappingHandle, "Failed to map asset pack {}", packFile.string());
+    data = (char const*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+    VULK_ASSERT(data, "Failed to map asset pack {}", packFile.string());
+#else
+    fd = ::open(packFile.c_str(), O_RDONLY);
+    VULK_ASSERT(fd >= 0, "Failed to open asset pack {}", packFile.string());
+    struct stat st;
+    VULK_ASSERT(fstat(fd, &st) == 0, "Failed to get size of asset pack {}", packFile.string());
+    size      = (size_t)st.st_size;
+    void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    VULK_ASSERT(ptr != MAP_FAILED, "Failed to map asset pack {}", packFile.string());
+    data = (char const*)ptr;
+#endif
+
+    Header header;
+    VULK_ASSERT(size >= sizeof(header), "Asset pack {} is truncated", packFile.string());
+    memcpy(&header, data, sizeof(header));
+    VULK_ASSERT(memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0, "{} is not an asset pack", packFile.string());
+    VULK_ASSERT(header.version == VERSION,
+                "Asset pack {} is version {}, expected {}. rebuild it.",
+                packFile.string(),
+                header.version,
+                VERSION);
+    VULK_ASSERT(header.tocOffset + header.tocSize <= size, "Asset pack {} is truncated", packFile.string());
+
+    vulk::cpp2::AssetPackDef toc;
+    apache::thrift::CompactSerializer::deserialize(folly::StringPiece(data + header.tocOffset, header.tocSize), toc);
+    entries.reserve(toc.get_entries().size());
+    for (auto const& entry : toc.get_entries()) {
+        uint64_t offset = (uint64_t)entry.get_offset();
+        uint64_t len    = (uint64_t)entry.get_size();
+        VULK_ASSERT(offset + len <= header.tocOffset, "Asset pack {}: {} is out of bounds", packFile.string(), entry.get_path());
+        entries[entry.get_path()] = std::span<char const>(data + offset, len);
+    }
+    logger->info("Opened asset pack {}: {} files, {} bytes", packFile.string(), entries.size(), size);
+}
+
+VulkAssetPack::~VulkAssetPack() {
+#ifdef _WIN32
+    if (data) {
+        UnmapViewOfFile(data);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle) {
+        CloseHandle(fileHandle);
+    }
+#else
+    if (data) {
+        munmap((void*)data, size);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+#endif
+}
+
+std::shared_ptr<VulkAssetPack const> VulkAssetPack::open(fs::path packFile, fs::path mountDir) {
+    // constructor is private so make_shared can't be used
+    return std::shared_ptr<VulkAssetPack const>(new VulkAssetPack(packFile, mountDir));
+}
+
+std::string VulkAssetPack::toKey(fs::path const& path) const {
+    return fs::absolute(path).lexically_normal().lexically_relative(mountDir).generic_string();
+}
+
+std::span<char const> VulkAssetPack::find(fs::path const& path) const {
+    auto it = entries.find(toKey(path));
+    if (it == entries.end()) {
+        return {};
+    }
+    return it->second;
+}
+
+std::vector<fs::path> VulkAssetPack::paths() const {
+    std::vector<fs::path> out;
+    out.reserve(entries.size());
+    for (auto const& [key, blob] : entries) {
+        out.push_back(mountDir / fs::path(key));
+    }
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+void VulkAssetPack::write(fs::path srcDir, fs::path packFile) {
+    VULK_ASSERT(fs::is_directory(srcDir), "Asset pack source {} is not a directory", srcDir.string());
+    std::vector<fs::path> files;
+    for (auto const& entry : fs::recursive_directory_iterator(srcDir)) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path());
+        }
+    }
+    // sorted so the same assets always make the same pack
+    std::sort(files.begin(), files.end());
+
+    std::ofstream ofs(packFile, std::ios::binary | std::ios::trunc);
+    VULK_ASSERT(ofs.is_open(), "Failed to open {} for writing", packFile.string());
+    auto pad = [&ofs]() {
+        static char const zeros[ALIGNMENT] = {};
+        uint64_t pos                       = (uint64_t)ofs.tellp();
+        ofs.write(zeros, (std::streamsize)((ALIGNMENT - pos % ALIGNMENT) % ALIGNMENT));
+    };
+
+    Header header = {};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    ofs.write((char const*)&header, sizeof(header));
+
+    vulk::cpp2::AssetPackDef toc;
+    for (fs::path const& file : files) {
+        std::vector<char> contents = readFileIntoMem(file.string());
+        pad();
+        vulk::cpp2::AssetPackEntryDef entry;
+        entry.path_ref()   = file.lexically_relative(srcDir).generic_string();
+        entry.offset_ref() = (int64_t)ofs.tellp();
+        entry.size_ref()   = (int64_t)contents.size();
+        ofs.write(contents.data(), (std::streamsize)contents.size());
+        toc.entries_ref()->push_back(std::move(entry));
+    }
+
+    std::string tocData;
+    apache::thrift::CompactSerializer::serialize(toc, &tocData);
+    pad();
+    header.tocOffset = (uint64_t)ofs.tellp();
+    header.tocSize   = tocData.size();
+    ofs.write(tocData.data(), (std::streamsize)tocData.size());
+    ofs.seekp(0);
+    ofs.write((char const*)&header, sizeof(header));
+    VULK_ASSERT(ofs.good(), "Failed to write asset pack {}", packFile.string());
+    logger->info("Packed {} files from {} into {}", files.size(), srcDir.string(), packFile.string());
+}
@@ -0,0 +1,245 @@
+#include "Vulk/VulkCookedTexture.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+
+#ifdef _MSC_VER
+#pragma warning(push, 0)  // assume these headers know what they're doing
+#endif
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#ifdef _MSC_VER
+#pragma warning(pop)
+#endif
+
+#include "Vulk/VulkAssetPack.h"
+#include "Vulk/VulkUtil.h"
+
+namespace fs = std::filesystem;
+
+static float srgbToLinear(uint8_t c) {
+    static std::array<float, 256> const table = []() {
+        std::array<float, 256> t;
+        for (int i = 0; i < 256; ++i) {
+            float f = (float)i / 255.0f;
+            t[i]    = f <= 0.04045f ? f / 12.92f : std::pow((f + 0.055f) / 1.055f, 2.4f);
+        }
+        return t;
+    }();
+    return table[c];
+}
+
+static uint8_t toUnorm8(float f) {
+    return static_cast<uint8_t>(std::clamp(f, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static uint8_t linearToSrgb(float f) {
+    f = std::clamp(f, 0.0f, 1.0f);
+    return toUnorm8(f <= 0.0031308f ? f * 12.92f : 1.055f * std::pow(f, 1.0f / 2.4f) - 0.055f);
+}
+
+VkFormat VulkCookedTexture::formatFor(VulkTextureKind kind, bool hasAlpha) {
+    switch (kind) {
+        case VulkTextureKind::Color:
+            return hasAlpha ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC1_RGB_SRGB_BLOCK;
+        case VulkTextureKind::Normal:
+            return VK_FORMAT_BC5_UNORM_BLOCK;
+        case VulkTextureKind::Single:
+            return VK_FORMAT_BC4_UNORM_BLOCK;
+    }
+    VULK_THROW("Unknown texture kind {}", (uint32_t)kind);
+}
+
+uint32_t VulkCookedTexture::blockSize(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+            return 8;
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+            return 16;
+        default:
+            VULK_THROW("Unsupported cooked texture format {}", (uint32_t)format);
+    }
+}
+
+uint32_t VulkCookedTexture::numMipLevels(uint32_t width, uint32_t height) {
+    uint32_t levels = 1;
+    for (uint32_t size = std::max(width, height); size > 1; size /= 2) {
+        levels++;
+    }
+    return levels;
+}
+
+std::vector<VkDeviceSize> VulkCookedTexture::mipSizes() const {
+    std::vector<VkDeviceSize> sizes;
+    for (uint32_t level = 0; level < mipLevels; ++level) {
+        uint32_t w = std::max(1u, width >> level);
+        uint32_t h = std::max(1u, height >> level);
+        sizes.push_back((VkDeviceSize)((w + 3) / 4) * ((h + 3) / 4) * blockSize(format));
+    }
+    return sizes;
+}
+
+VulkDecodedImage VulkCookedTexture::downsample(VulkDecodedImage const& image, VulkTextureKind kind) {
+    VulkDecodedImage out;
+    out.width  = std::max(1u, image.width / 2);
+    out.height = std::max(1u, image.height / 2);
+    out.pixels.resize((size_t)out.width * out.height * 4);
+    for (uint32_t y = 0; y < out.height; ++y) {
+        for (uint32_t x = 0; x < out.width; ++x) {
+            float avg[4] = {};
+            for (uint32_t i = 0; i < 4; ++i) {
+                uint32_t sx      = std::min(x * 2 + i % 2, image.width - 1);
+                uint32_t sy      = std::min(y * 2 + i / 2, image.height - 1);
+                uint8_t const* p = &image.pixels[((size_t)sy * image.width + sx) * 4];
+                for (int c = 0; c < 4; ++c) {
+                    avg[c] += 0.25f * (kind == VulkTextureKind::Color && c < 3 ? srgbToLinear(p[c]) : p[c] / 255.0f);
+                }
+            }
+
+            uint8_t* q = &out.pixels[((size_t)y * out.width + x) * 4];
+            if (kind == VulkTextureKind::Normal) {
+                // averaging shortens the normal, put it back on the unit sphere
+                float n[3] = {avg[0] * 2.0f - 1.0f, avg[1] * 2.0f - 1.0f, avg[2] * 2.0f - 1.0f};
+                float len  = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+                for (int c = 0; c < 3; ++c) {
+                    avg[c] = (len > 0.0f ? n[c] / len : n[c]) * 0.5f + 0.5f;
+                }
+            }
+            for (int c = 0; c < 4; ++c) {
+                q[c] = kind == VulkTextureKind::Color && c < 3 ? linearToSrgb(avg[c]) : toUnorm8(avg[c]);
+            }
+        }
+    }
+    return out;
+}
+
+// appends level's blocks to out
+static void compressLevel(VulkDecodedImage const& level, VkFormat format, std::vector<uint8_t>& out) {
+    uint32_t blockBytes = VulkCookedTexture::blockSize(format);
+    for (uint32_t by = 0; by < level.height; by += 4) {
+        for (uint32_t bx = 0; bx < level.width; bx += 4) {
+            uint8_t rgba[16 * 4];
+            uint8_t r[16];
+            uint8_t rg[16 * 2];
+            for (uint32_t i = 0; i < 16; ++i) {
+                uint32_t x       = std::min(bx + i % 4, level.width - 1);
+                uint32_t y       = std::min(by + i / 4, level.height - 1);
+                uint8_t const* p = &level.pixels[((size_t)y * level.width + x) * 4];
+                memcpy(&rgba[i * 4], p, 4);
+                r[i]          = p[0];
+                rg[i * 2]     = p[0];
+                rg[i * 2 + 1] = p[1];
+            }
+
+            size_t offset = out.size();
+            out.resize(offset + blockBytes);
+            switch (format) {
+                case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+                    stb_compress_dxt_block(&out[offset], rgba, 0, STB_DXT_HIGHQUAL);
+                    break;
+                case VK_FORMAT_BC3_SRGB_BLOCK:
+                    stb_compress_dxt_block(&out[offset], rgba, 1, STB_DXT_HIGHQUAL);
+                    break;
+                case VK_FORMAT_BC4_UNORM_BLOCK:
+                    stb_compress_bc4_block(&out[offset], r);
+                    break;
+                case VK_FORMAT_BC5_UNORM_BLOCK:
+                    stb_compress_bc5_block(&out[offset], rg);
+                    break;
+                default:
+                    VULK_THROW("Unsupported cooked texture format {}", (uint32_t)format);
+            }
+        }
+    }
+}
+
+VulkCookedTexture VulkCookedTexture::cook(VulkDecodedImage const& image, VulkTextureKind kind) {
+    VULK_ASSERT(image.width > 0 && image.height > 0, "Can't cook an empty texture");
+    bool hasAlpha = false;
+    for (size_t i = 3; i < image.pixels.size() && !hasAlpha; i += 4) {
+        hasAlpha = image.pixels[i] != 255;
+    }
+
+    VulkCookedTexture cooked;
+    cooked.format    = formatFor(kind, hasAlpha);
+    cooked.width     = image.width;
+    cooked.height    = image.height;
+    cooked.mipLevels = numMipLevels(image.width, image.height);
+    // each level is filtered from the one above it
+    VulkDecodedImage level = image;
+    for (uint32_t i = 0; i < cooked.mipLevels; ++i) {
+        compressLevel(level, cooked.format, cooked.data);
+        if (i + 1 < cooked.mipLevels) {
+            level = downsample(level, kind);
+        }
+    }
+    return cooked;
+}
+
+VulkCookedTexture VulkCookedTexture::loadCooked(std::span<char const> data, std::string const& name) {
+    VulkCookedTextureHeader header;
+    VULK_ASSERT(data.size() >= sizeof(header), "Cooked texture {} is truncated", name);
+    memcpy(&header, data.data(), sizeof(header));
+    VULK_ASSERT(memcmp(header.magic, VulkCookedTextureHeader::MAGIC, sizeof(header.magic)) == 0,
+                "{} is not a cooked texture",
+                name);
+    VULK_ASSERT(header.version == VulkCookedTextureHeader::VERSION,
+                "Cooked texture {} is version {}, expected {}. rebuild it.",
+                name,
+                header.version,
+                VulkCookedTextureHeader::VERSION);
+
+    VulkCookedTexture cooked;
+    cooked.format    = static_cast<VkFormat>(header.format);
+    cooked.width     = header.width;
+    cooked.height    = header.height;
+    cooked.mipLevels = header.mipLevels;
+    VULK_ASSERT(cooked.width > 0 && cooked.height > 0 && cooked.mipLevels > 0 &&
+                    cooked.mipLevels <= numMipLevels(cooked.width, cooked.height),
+                "Cooked texture {} is {}x{} with {} mips",
+                name,
+                cooked.width,
+                cooked.height,
+                cooked.mipLevels);
+    VkDeviceSize dataSize = 0;
+    for (VkDeviceSize size : cooked.mipSizes()) {
+        dataSize += size;
+    }
+    VULK_ASSERT(data.size() == sizeof(header) + dataSize,
+                "Cooked texture {} is {} bytes, expected {}",
+                name,
+                data.size(),
+                sizeof(header) + dataSize);
+    cooked.data.assign(data.begin() + sizeof(header), data.end());
+    return cooked;
+}
+
+VulkCookedTexture VulkCookedTexture::loadFromAssets(VulkAssetPack const* pack, fs::path const& path) {
+    if (pack && pack->contains(path)) {
+        return loadCooked(pack->find(path), path.string());
+    }
+    std::vector<char> data = readFileIntoMem(path.string());
+    return loadCooked(data, path.string());
+}
+
+void VulkCookedTexture::writeCooked(fs::path const& path) const {
+    VulkCookedTextureHeader header;
+    memcpy(header.magic, VulkCookedTextureHeader::MAGIC, sizeof(header.magic));
+    header.version   = VulkCookedTextureHeader::VERSION;
+    header.format    = static_cast<uint32_t>(format);
+    header.width     = width;
+    header.height    = height;
+    header.mipLevels = mipLevels;
+
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    VULK_ASSERT(ofs.is_open(), "Could not open file for writing: {}", path.string());
+    ofs.write((char const*)&header, sizeof(header));
+    ofs.write((char const*)data.data(), (std::streamsize)data.size());
+    VULK_ASSERT(ofs.good(), "Failed to write cooked texture {}", path.string());
+}
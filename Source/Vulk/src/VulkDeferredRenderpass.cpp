@@ -165,8 +165,12 @@ VulkDeferredRenderpass::VulkDeferredRenderpass(Vulk& vkIn, VulkResources& resour
 
     // ------------------------------ Load Pipelines ------------------------------
 
-    deferredGeoPipeline      = resources.loadPipeline(renderPass, vk.swapChainExtent, "DeferredRenderGeo");
-    deferredLightingPipeline = resources.loadPipeline(renderPass, vk.swapChainExtent, "DeferredRenderLighting");
+    std::vector<std::shared_ptr<const VulkPipeline>> pipelines = resources.loadPipelines({
+        {"DeferredRenderGeo", renderPass, vk.swapChainExtent},
+        {"DeferredRenderLighting", renderPass, vk.swapChainExtent},
+    });
+    deferredGeoPipeline      = pipelines[0];
+    deferredLightingPipeline = pipelines[1];
 
     VulkPipeline const& pipeline      = *deferredLightingPipeline;
     deferredLightingDescriptorSetInfo = resources.createDSInfoFromPipeline(pipeline, &scene, nullptr, nullptr, this);
@@ -0,0 +1,126 @@
+#include "Vulk/VulkDescriptorAllocator.h"
+
+#include <algorithm>
+
+#include "Vulk/VulkLogger.h"
+#include "Vulk/VulkUtil.h"
+
+DECLARE_FILE_LOGGER();
+
+VulkDescriptorAllocator::VulkDescriptorAllocator(VkDevice device) : device(device) {}
+
+VulkDescriptorAllocator::~VulkDescriptorAllocator() {
+    for (auto& [counts, pools] : poolsByCounts) {
+        for (VkDescriptorPool pool : pools) {
+            vkDestroyDescriptorPool(device, pool, nullptr);
+        }
+    }
+}
+
+VulkDescriptorCounts VulkDescriptorAllocator::countsFor(std::span<VkDescriptorSetLayoutBinding const> bindings) {
+    std::map<VkDescriptorType, uint32_t> byType;
+    for (VkDescriptorSetLayoutBinding const& binding : bindings) {
+        byType[binding.descriptorType] += binding.descriptorCount;
+    }
+    return VulkDescriptorCounts(byType.begin(), byType.end());
+}
+
+VkDescriptorPool VulkDescriptorAllocator::createPool(VulkDescriptorCounts const& counts) {
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for (auto [type, count] : counts) {
+        poolSizes.push_back({type, count * SETS_PER_POOL});
+    }
+    VkDescriptorPoolCreateInfo poolInfo{};
+    poolInfo.sType         = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    poolInfo.flags         = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    poolInfo.pPoolSizes    = poolSizes.data();
+    poolInfo.maxSets       = SETS_PER_POOL;
+
+    VkDescriptorPool pool;
+    VK_CALL(vkCreateDescriptorPool(device, &poolInfo, nullptr, &pool));
+    poolsByCounts[counts].push_back(pool);
+    setsInPool[pool] = 0;
+    stats.numPools++;
+    return pool;
+}
+
+VkDescriptorSet VulkDescriptorAllocator::allocate(VkDescriptorSetLayout layout,
+                                                  VulkDescriptorCounts const& counts,
+                                                  VkDescriptorPool& poolOut) {
+    std::lock_guard<std::mutex> lock(mutex);
+    VkDescriptorSetAllocateInfo allocInfo{};
+    allocInfo.sType              = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    allocInfo.descriptorSetCount = 1;
+    allocInfo.pSetLayouts        = &layout;
+
+    VkDescriptorSet set;
+    // newest first: the older pools are the ones most likely to be full
+    std::vector<VkDescriptorPool>& pools = poolsByCounts[counts];
+    for (auto it = pools.rbegin(); it != pools.rend(); ++it) {
+        if (setsInPool[*it] == SETS_PER_POOL) {
+            continue;
+        }
+        allocInfo.descriptorPool = *it;
+        VkResult result          = vkAllocateDescriptorSets(device, &allocInfo, &set);
+        if (result == VK_SUCCESS) {
+            setsInPool[*it]++;
+            stats.numSets++;
+            poolOut = *it;
+            return set;
+        }
+        // freed sets can leave a pool too fragmented to use its free space
+        VULK_ASSERT(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL,
+                    "vkAllocateDescriptorSets failed: {}",
+                    (int)result);
+    }
+
+    allocInfo.descriptorPool = createPool(counts);
+    VK_CALL(vkAllocateDescriptorSets(device, &allocInfo, &set));
+    setsInPool[allocInfo.descriptorPool]++;
+    stats.numSets++;
+    poolOut = allocInfo.descriptorPool;
+    return set;
+}
+
+void VulkDescriptorAllocator::free(VkDescriptorSet set, VkDescriptorPool pool) {
+    std::lock_guard<std::mutex> lock(mutex);
+    VK_CALL(vkFreeDescriptorSets(device, pool, 1, &set));
+    setsInPool[pool]--;
+    stats.numSets--;
+}
+
+bool VulkDescriptorAllocator::findCached(CacheKey const& key, std::span<std::shared_ptr<const VulkDescriptorSet>> sets) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = setCache.find(key);
+    if (it == setCache.end() || it->second.size() != sets.size()) {
+        stats.cacheMisses++;
+        return false;
+    }
+    for (size_t i = 0; i < sets.size(); ++i) {
+        sets[i] = it->second[i].lock();
+        if (!sets[i]) {
+            setCache.erase(it);
+            stats.cacheMisses++;
+            return false;
+        }
+    }
+    stats.cacheHits++;
+    return true;
+}
+
+void VulkDescriptorAllocator::cache(CacheKey key, std::span<std::shared_ptr<const VulkDescriptorSet> const> sets) {
+    std::lock_guard<std::mutex> lock(mutex);
+    setCache[std::move(key)] = std::vector<std::weak_ptr<const VulkDescriptorSet>>(sets.begin(), sets.end());
+    if (setCache.size() >= nextCacheSweep) {
+        std::erase_if(setCache, [](auto const& entry) {
+            return std::any_of(entry.second.begin(), entry.second.end(), [](auto const& set) { return set.expired(); });
+        });
+        nextCacheSweep = std::max<size_t>(64, setCache.size() * 2);
+    }
+}
+
+VulkDescriptorAllocator::Stats VulkDescriptorAllocator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
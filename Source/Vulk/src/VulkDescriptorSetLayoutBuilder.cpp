@@ -18,6 +18,23 @@ VulkDescriptorSetLayoutBuilder& VulkDescriptorSetLayoutBuilder::addUniformBuffer
     return *this;
 }
 
+VulkDescriptorSetLayoutBuilder& VulkDescriptorSetLayoutBuilder::addDynamicUniformBuffer(
+    VkShaderStageFlags stageFlags,
+    vulk::cpp2::VulkShaderUBOBinding bindingIn) {
+    uint32_t binding = (uint32_t)bindingIn;
+    if (!layoutBindingsMap.contains(binding)) {
+        VkDescriptorSetLayoutBinding layoutBinding{};
+        layoutBinding.binding         = binding;
+        layoutBinding.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        layoutBinding.descriptorCount = 1;
+        layoutBinding.stageFlags      = stageFlags;
+        layoutBindingsMap[binding]    = layoutBinding;
+    } else {
+        layoutBindingsMap[binding].stageFlags |= stageFlags;
+    }
+    return *this;
+}
+
 VulkDescriptorSetLayoutBuilder& VulkDescriptorSetLayoutBuilder::addImageSampler(VkShaderStageFlags stageFlags,
                                                                                 vulk::cpp2::VulkShaderTextureBinding bindingIn) {
     uint32_t binding = (uint32_t)bindingIn;
@@ -23,6 +23,28 @@ VulkDescriptorSetUpdater& VulkDescriptorSetUpdater::addUniformBuffer(VkBuffer bu
     return *this;
 }
 
+VulkDescriptorSetUpdater& VulkDescriptorSetUpdater::addDynamicUniformBuffer(VkBuffer buf,
+                                                                            VkDeviceSize range,
+                                                                            vulk::cpp2::VulkShaderUBOBinding bindingIn) {
+    uint32_t binding          = (uint32_t)bindingIn;
+    auto uniformBufferInfo    = std::make_unique<VkDescriptorBufferInfo>();
+    uniformBufferInfo->buffer = buf;
+    uniformBufferInfo->offset = 0;
+    uniformBufferInfo->range  = range;
+
+    VkWriteDescriptorSet writeDescriptorSet{};
+    writeDescriptorSet.sType           = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet          = descriptorSet->descriptorSet;
+    writeDescriptorSet.dstBinding      = binding;
+    writeDescriptorSet.dstArrayElement = 0;
+    writeDescriptorSet.descriptorType  = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    writeDescriptorSet.descriptorCount = 1;
+    writeDescriptorSet.pBufferInfo     = uniformBufferInfo.get();
+    descriptorWrites.push_back(writeDescriptorSet);
+    bufferInfos.push_back(std::move(uniformBufferInfo));
+    return *this;
+}
+
 VulkDescriptorSetUpdater& VulkDescriptorSetUpdater::addImageSampler(std::shared_ptr<const VulkImageView> textureImageView,
                                                                     std::shared_ptr<const VulkSampler> textureSampler,
                                                                     vulk::cpp2::VulkShaderTextureBinding bindingIn) {
@@ -0,0 +1,148 @@
+#include "Vulk/VulkDrawList.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+#include "Vulk/VulkDescriptorSetBuilder.h"
+#include "Vulk/VulkUtil.h"
+
+using namespace std;
+
+VulkDrawList::Stats& VulkDrawList::Stats::operator+=(Stats const& rhs) {
+    draws += rhs.draws;
+    pipelineBinds += rhs.pipelineBinds;
+    pipelineBindsSkipped += rhs.pipelineBindsSkipped;
+    descriptorSetBinds += rhs.descriptorSetBinds;
+    descriptorSetBindsSkipped += rhs.descriptorSetBindsSkipped;
+    vertexBufferBinds += rhs.vertexBufferBinds;
+    vertexBufferBindsSkipped += rhs.vertexBufferBindsSkipped;
+    return *this;
+}
+
+uint64_t VulkDrawList::makeKey(uint32_t pass, uint32_t pipeline, uint32_t descriptorSet, uint32_t mesh, float depth) {
+    VULK_ASSERT(pass < (1u << PASS_BITS), "pass {} doesn't fit in a draw key", pass);
+    uint64_t quantizedDepth = (uint64_t)(clamp(depth, 0.0f, 1.0f) * ((1u << DEPTH_BITS) - 1));
+    uint64_t key            = pass;
+    key                     = (key << PIPELINE_BITS) | pipeline;
+    key                     = (key << SET_BITS) | descriptorSet;
+    key                     = (key << MESH_BITS) | mesh;
+    key                     = (key << DEPTH_BITS) | quantizedDepth;
+    return key;
+}
+
+vector<uint32_t> VulkDrawList::radixSort(span<uint64_t const> keys) {
+    vector<uint32_t> order(keys.size());
+    iota(order.begin(), order.end(), 0);
+    if (keys.empty()) {
+        return order;
+    }
+    uint64_t differing = 0;
+    for (uint64_t key : keys) {
+        differing |= key ^ keys[0];
+    }
+
+    vector<uint32_t> scratch(keys.size());
+    for (uint32_t shift = 0; shift < 64; shift += 8) {
+        if (((differing >> shift) & 0xff) == 0) {
+            continue;
+        }
+        array<uint32_t, 257> offsets{};
+        for (uint32_t i : order) {
+            offsets[((keys[i] >> shift) & 0xff) + 1]++;
+        }
+        partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        for (uint32_t i : order) {
+            scratch[offsets[(keys[i] >> shift) & 0xff]++] = i;
+        }
+        order.swap(scratch);
+    }
+    return order;
+}
+
+uint32_t VulkDrawList::idFor(unordered_map<void const*, uint32_t>& ids, void const* p, uint32_t bits) {
+    auto [it, inserted] = ids.try_emplace(p, (uint32_t)ids.size());
+    VULK_ASSERT(it->second < (1u << bits), "more than {} distinct things in a draw list key", 1u << bits);
+    return it->second;
+}
+
+void VulkDrawList::add(VulkActorBatch const& batch, uint32_t pass, float depth) {
+    VulkActor const& actor = *batch.actor;
+    uint32_t pipeline      = idFor(pipelineIDs, actor.pipeline.get(), PIPELINE_BITS);
+    uint32_t set           = idFor(setIDs, actor.dsInfo->descriptorSets[0].get(), SET_BITS);
+    uint32_t mesh          = idFor(meshIDs, actor.model.get(), MESH_BITS);
+    draws.push_back({makeKey(pass, pipeline, set, mesh, depth), batch});
+    order.clear();
+}
+
+void VulkDrawList::clear() {
+    draws.clear();
+    order.clear();
+}
+
+void VulkDrawList::sort() {
+    if (order.size() == draws.size()) {
+        return;
+    }
+    vector<uint64_t> keys;
+    keys.reserve(draws.size());
+    for (Draw const& draw : draws) {
+        keys.push_back(draw.key);
+    }
+    order = radixSort(keys);
+}
+
+void VulkDrawList::record(VkCommandBuffer commandBuffer, uint32_t frame) {
+    sort();
+    stats = recordRange(commandBuffer, frame, 0, draws.size());
+}
+
+VulkDrawList::Stats VulkDrawList::recordRange(VkCommandBuffer commandBuffer, uint32_t frame, size_t first, size_t count) const {
+    VULK_ASSERT(order.size() == draws.size(), "draw list has to be sorted before recording");
+    VULK_ASSERT(first + count <= order.size(), "draws {} to {} of {}", first, first + count, order.size());
+    Stats rangeStats;
+    VkPipeline boundPipeline             = VK_NULL_HANDLE;
+    VkPipelineLayout boundLayout         = VK_NULL_HANDLE;
+    VulkDescriptorSetInfo const* boundDS = nullptr;
+    VulkModel const* boundModel          = nullptr;
+    for (uint32_t i : span(order).subspan(first, count)) {
+        VulkActorBatch const& batch     = draws[i].batch;
+        VulkActor const& actor          = *batch.actor;
+        VulkPipeline const& pipeline    = *actor.pipeline;
+        VulkDescriptorSetInfo const& ds = *actor.dsInfo;
+
+        if (pipeline.pipeline != boundPipeline) {
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.pipeline);
+            boundPipeline = pipeline.pipeline;
+            rangeStats.pipelineBinds++;
+        } else {
+            rangeStats.pipelineBindsSkipped++;
+        }
+
+        // a set bound for one pipeline layout is only still bound after a switch to another if the layouts are
+        // compatible. they're made per pipeline, so a different layout means rebinding
+        bool sameSet = boundDS && pipeline.pipelineLayout == boundLayout &&
+                       boundDS->descriptorSets[frame] == ds.descriptorSets[frame] &&
+                       boundDS->dynamicOffsets == ds.dynamicOffsets;
+        if (!sameSet) {
+            ds.bind(commandBuffer, pipeline.pipelineLayout, frame);
+            boundLayout = pipeline.pipelineLayout;
+            boundDS     = &ds;
+            rangeStats.descriptorSetBinds++;
+        } else {
+            rangeStats.descriptorSetBindsSkipped++;
+        }
+
+        if (actor.model.get() != boundModel) {
+            actor.model->bindInputBuffers(commandBuffer);
+            boundModel = actor.model.get();
+            rangeStats.vertexBufferBinds++;
+        } else {
+            rangeStats.vertexBufferBindsSkipped++;
+        }
+
+        actor.model->draw(commandBuffer, batch.instanceCount, batch.firstInstance);
+        rangeStats.draws++;
+    }
+    return rangeStats;
+}
@@ -0,0 +1,46 @@
+#include "Vulk/VulkFrameUBOArena.h"
+
+#include <algorithm>
+
+#include "Vulk/VulkLogger.h"
+
+DECLARE_FILE_LOGGER();
+
+VulkFrameUBOBlock::VulkFrameUBOBlock(Vulk& vk, VkDeviceSize size) : vk(vk), size(size) {
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+        vk.createBuffer(size,
+                        VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                        bufs[i],
+                        allocs[i]);
+        VULK_ASSERT(allocs[i].mapped, "UBO arena block isn't mapped");
+    }
+}
+
+VulkFrameUBOBlock::~VulkFrameUBOBlock() {
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i) {
+        vk.destroyBuffer(bufs[i], allocs[i]);
+    }
+}
+
+VulkFrameUBOArena::VulkFrameUBOArena(Vulk& vk, VkDeviceSize blockSize) : vk(vk), blockSize(blockSize) {
+    VkPhysicalDeviceProperties properties{};
+    vkGetPhysicalDeviceProperties(vk.physicalDevice, &properties);
+    alignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+}
+
+uint32_t VulkFrameUBOArena::reserve(VkDeviceSize size, std::shared_ptr<VulkFrameUBOBlock const>& block) {
+    VULK_ASSERT(size <= blockSize, "{} byte UBO doesn't fit in a {} byte arena block", size, blockSize);
+    if (blocks.empty() || blocks.back()->used + size > blockSize) {
+        if (!blocks.empty()) {
+            logger->info("UBO arena block {} is full, adding another", blocks.size());
+        }
+        blocks.push_back(std::make_shared<VulkFrameUBOBlock>(vk, blockSize));
+    }
+    VulkFrameUBOBlock& current = *blocks.back();
+    VkDeviceSize offset        = current.used;
+    // the next slot has to start on an alignment boundary, so round this one up
+    current.used = (offset + size + alignment - 1) / alignment * alignment;
+    block        = blocks.back();
+    return (uint32_t)offset;
+}
@@ -0,0 +1,255 @@
+#include "Vulk/VulkMemoryAllocator.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+#include "Vulk/VulkLogger.h"
+
+DECLARE_FILE_LOGGER();
+
+struct VulkMemoryBlock {
+    VkDeviceMemory memory;
+    VkDeviceSize size;
+    void* mapped;
+    std::map<VkDeviceSize, VkDeviceSize> freeRanges;  // offset -> size, never adjacent
+    uint32_t numAllocations = 0;
+};
+
+namespace {
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+}  // namespace
+
+VulkMemoryAllocator::VulkMemoryAllocator(Backend backend, std::vector<VkMemoryPropertyFlags> memoryTypes, VkDeviceSize blockSize)
+    : backend(std::move(backend)), memoryTypes(std::move(memoryTypes)), blockSize(blockSize) {
+    pools.resize(this->memoryTypes.size() * 2);
+}
+
+VulkMemoryAllocator::~VulkMemoryAllocator() {
+    if (numAllocations > 0) {
+        logger->warn("VulkMemoryAllocator: destroyed with {} allocations ({} bytes) still live", numAllocations, liveBytes);
+    }
+    for (Pool& pool : pools) {
+        for (auto& block : pool.blocks) {
+            destroyBlock(*block);
+        }
+    }
+    for (auto& [memory, size] : dedicated) {
+        backend.free(memory);
+    }
+}
+
+std::unique_ptr<VulkMemoryAllocator> VulkMemoryAllocator::create(VkDevice device, VkPhysicalDevice physicalDevice) {
+    VkPhysicalDeviceMemoryProperties memProperties;
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
+    std::vector<VkMemoryPropertyFlags> memoryTypes;
+    for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++) {
+        memoryTypes.push_back(memProperties.memoryTypes[i].propertyFlags);
+    }
+
+    Backend backend;
+    backend.allocate = [device](uint32_t memoryType, VkDeviceSize size, VkDeviceMemory* memoryOut) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType           = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize  = size;
+        allocInfo.memoryTypeIndex = memoryType;
+        return vkAllocateMemory(device, &allocInfo, nullptr, memoryOut);
+    };
+    backend.free = [device](VkDeviceMemory memory) { vkFreeMemory(device, memory, nullptr); };
+    backend.map  = [device](VkDeviceMemory memory) {
+        void* data;
+        VK_CALL(vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &data));
+        return data;
+    };
+    backend.unmap = [device](VkDeviceMemory memory) { vkUnmapMemory(device, memory); };
+    return std::make_unique<VulkMemoryAllocator>(std::move(backend), std::move(memoryTypes));
+}
+
+uint32_t VulkMemoryAllocator::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags properties) const {
+    for (uint32_t i = 0; i < memoryTypes.size(); i++) {
+        if ((typeBits & (1 << i)) && (memoryTypes[i] & properties) == properties) {
+            return i;
+        }
+    }
+    VULK_THROW("VulkMemoryAllocator: no memory type in {:#x} has properties {:#x}", typeBits, properties);
+}
+
+VulkAllocation VulkMemoryAllocator::allocate(VkMemoryRequirements const& reqs,
+                                             VkMemoryPropertyFlags properties,
+                                             bool linear,
+                                             bool wantDedicated) {
+    VULK_ASSERT(reqs.size > 0, "VulkMemoryAllocator: zero size allocation");
+    uint32_t memoryType = findMemoryType(reqs.memoryTypeBits, properties);
+    std::lock_guard<std::mutex> lock(mutex);
+    if (wantDedicated || reqs.size > blockSize / 2) {
+        return allocateDedicated(memoryType, reqs.size, linear);
+    }
+
+    // best fit: the smallest free range the aligned allocation fits in
+    Pool& pool              = pools[memoryType * 2 + linear];
+    VkDeviceSize alignment  = std::max<VkDeviceSize>(reqs.alignment, 1);
+    VulkMemoryBlock* best   = nullptr;
+    VkDeviceSize bestRange  = 0;
+    VkDeviceSize bestSize   = std::numeric_limits<VkDeviceSize>::max();
+    VkDeviceSize bestOffset = 0;
+    for (auto& block : pool.blocks) {
+        for (auto [rangeOffset, rangeSize] : block->freeRanges) {
+            VkDeviceSize offset = alignUp(rangeOffset, alignment);
+            if (offset + reqs.size <= rangeOffset + rangeSize && rangeSize < bestSize) {
+                best       = block.get();
+                bestRange  = rangeOffset;
+                bestSize   = rangeSize;
+                bestOffset = offset;
+            }
+        }
+    }
+    if (!best) {
+        pool.blocks.push_back(createBlock(memoryType));
+        best       = pool.blocks.back().get();
+        bestRange  = 0;
+        bestSize   = best->size;
+        bestOffset = 0;
+    }
+
+    // whatever is left on either side, including alignment padding, stays free
+    best->freeRanges.erase(bestRange);
+    if (bestOffset > bestRange) {
+        best->freeRanges[bestRange] = bestOffset - bestRange;
+    }
+    VkDeviceSize end = bestOffset + reqs.size;
+    if (end < bestRange + bestSize) {
+        best->freeRanges[end] = bestRange + bestSize - end;
+    }
+    best->numAllocations++;
+    numAllocations++;
+    liveBytes += reqs.size;
+
+    VulkAllocation alloc;
+    alloc.memory     = best->memory;
+    alloc.offset     = bestOffset;
+    alloc.size       = reqs.size;
+    alloc.mapped     = best->mapped ? static_cast<char*>(best->mapped) + bestOffset : nullptr;
+    alloc.memoryType = memoryType;
+    alloc.linear     = linear;
+    alloc.block      = best;
+    return alloc;
+}
+
+void VulkMemoryAllocator::free(VulkAllocation& alloc) {
+    if (!alloc) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    numAllocations--;
+    liveBytes -= alloc.size;
+
+    if (!alloc.block) {
+        if (alloc.mapped) {
+            backend.unmap(alloc.memory);
+        }
+        backend.free(alloc.memory);
+        dedicated.erase(alloc.memory);
+        alloc = {};
+        return;
+    }
+
+    // put the range back, merging it with the free ranges either side
+    VulkMemoryBlock& block = *alloc.block;
+    VkDeviceSize offset    = alloc.offset;
+    VkDeviceSize size      = alloc.size;
+    auto next              = block.freeRanges.lower_bound(offset);
+    if (next != block.freeRanges.end() && offset + size == next->first) {
+        size += next->second;
+        next = block.freeRanges.erase(next);
+    }
+    auto prev = next == block.freeRanges.begin() ? block.freeRanges.end() : std::prev(next);
+    if (prev != block.freeRanges.end() && prev->first + prev->second == offset) {
+        prev->second += size;
+    } else {
+        block.freeRanges[offset] = size;
+    }
+    block.numAllocations--;
+
+    // keep one empty block per pool for the next allocation, release any others
+    if (block.numAllocations == 0) {
+        auto& blocks           = pools[alloc.memoryType * 2 + alloc.linear].blocks;
+        auto isOtherEmptyBlock = [&block](auto const& b) { return b.get() != &block && b->numAllocations == 0; };
+        if (std::any_of(blocks.begin(), blocks.end(), isOtherEmptyBlock)) {
+            destroyBlock(block);
+            std::erase_if(blocks, [&block](auto const& b) { return b.get() == &block; });
+        }
+    }
+    alloc = {};
+}
+
+VulkMemoryStats VulkMemoryAllocator::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    VulkMemoryStats stats;
+    stats.numAllocations = numAllocations;
+    stats.liveBytes      = liveBytes;
+    for (Pool const& pool : pools) {
+        for (auto const& block : pool.blocks) {
+            stats.numBlocks++;
+            stats.reservedBytes += block->size;
+            VkDeviceSize blockFree = 0, blockLargest = 0;
+            for (auto [offset, size] : block->freeRanges) {
+                blockFree    += size;
+                blockLargest  = std::max(blockLargest, size);
+            }
+            stats.freeBytes       += blockFree;
+            stats.fragmentedBytes += blockFree - blockLargest;
+            stats.largestFree      = std::max(stats.largestFree, blockLargest);
+        }
+    }
+    for (auto [memory, size] : dedicated) {
+        stats.numDedicated++;
+        stats.reservedBytes += size;
+    }
+    return stats;
+}
+
+VulkAllocation VulkMemoryAllocator::allocateDedicated(uint32_t memoryType, VkDeviceSize size, bool linear) {
+    VulkAllocation alloc;
+    VkResult res = backend.allocate(memoryType, size, &alloc.memory);
+    VULK_ASSERT(res == VK_SUCCESS,
+                "VulkMemoryAllocator: failed to allocate {} bytes of memory type {}: {}",
+                size,
+                memoryType,
+                (int)res);
+    if (memoryTypes[memoryType] & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        alloc.mapped = backend.map(alloc.memory);
+    }
+    alloc.size              = size;
+    alloc.memoryType        = memoryType;
+    alloc.linear            = linear;
+    dedicated[alloc.memory] = size;
+    numAllocations++;
+    liveBytes += size;
+    logger->trace("VulkMemoryAllocator: dedicated allocation of {} bytes, memory type {}", size, memoryType);
+    return alloc;
+}
+
+std::unique_ptr<VulkMemoryBlock> VulkMemoryAllocator::createBlock(uint32_t memoryType) {
+    VkDeviceMemory memory;
+    VkResult res = backend.allocate(memoryType, blockSize, &memory);
+    VULK_ASSERT(res == VK_SUCCESS,
+                "VulkMemoryAllocator: failed to allocate a {} byte block of memory type {}: {}",
+                blockSize,
+                memoryType,
+                (int)res);
+    void* mapped = nullptr;
+    if (memoryTypes[memoryType] & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+        mapped = backend.map(memory);
+    }
+    logger->trace("VulkMemoryAllocator: new {} byte block, memory type {}", blockSize, memoryType);
+    return std::make_unique<VulkMemoryBlock>(VulkMemoryBlock{memory, blockSize, mapped, {{0, blockSize}}});
+}
+
+void VulkMemoryAllocator::destroyBlock(VulkMemoryBlock& block) {
+    if (block.mapped) {
+        backend.unmap(block.memory);
+    }
+    backend.free(block.memory);
+}
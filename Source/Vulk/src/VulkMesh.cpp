@@ -3,6 +3,8 @@
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <assimp/Importer.hpp>
+#include <fstream>
+#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <vector>
 
@@ -10,46 +12,80 @@ glm::vec3 toVec3(const aiVector3D& aiVec) {
     return glm::vec3(aiVec.x, aiVec.y, aiVec.z);
 }
 
-void loadModel(char const* model_path, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
-    Assimp::Importer importer;
-    unsigned int flags   = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
-    const aiScene* scene = importer.ReadFile(model_path, flags);
+static unsigned int const importFlags =
+    aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
 
-    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-        std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
-        VULK_THROW("Error loading model");
-    }
+static glm::mat4 toMat4(aiMatrix4x4 const& m) {
+    return glm::transpose(glm::make_mat4(&m.a1));  // assimp is row major
+}
+
+// appends every mesh instance under node as a submesh, transformed into the model's space
+static void loadNode(const aiScene* scene, const aiNode* node, glm::mat4 const& parentXform, VulkMesh& model) {
+    glm::mat4 xform       = parentXform * toMat4(node->mTransformation);
+    glm::mat3 normalXform = glm::transpose(glm::inverse(glm::mat3(xform)));
+    bool isIdentity       = xform == glm::mat4(1.0f);
+    auto transformDir     = [](glm::mat3 const& m, glm::vec3 v) {
+        v = m * v;
+        return glm::length(v) > 0.0f ? glm::normalize(v) : v;
+    };
 
-    // Assuming the model consists of only one mesh. You might need to loop through scene->mNumMeshes for multiple meshes.
-    aiMesh* mesh = scene->mMeshes[0];
-    vertices.reserve(mesh->mNumVertices);
-
-    for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
-        Vertex vertex;
-        vertex.pos     = toVec3(mesh->mVertices[i]);
-        vertex.normal  = toVec3(mesh->mNormals[i]);
-        vertex.tangent = toVec3(mesh->mTangents[i]);
-
-        if (mesh->mTextureCoords[0]) {
-            // Assimp allows up to 8 texture coordinate sets; we're using the first set here.
-            vertex.uv.x = mesh->mTextureCoords[0][i].x;
-            vertex.uv.y = mesh->mTextureCoords[0][i].y;
-            // vertex.uv.z = mesh->mTextureCoords[0][i].z;
-        } else {
-            vertex.uv = glm::vec2(0.0f, 0.0f);
+    for (unsigned int m = 0; m < node->mNumMeshes; m++) {
+        aiMesh const* mesh = scene->mMeshes[node->mMeshes[m]];
+        VulkMeshRef ref;
+        ref.name        = mesh->mName.length > 0 ? mesh->mName.C_Str() : node->mName.C_Str();
+        ref.firstVertex = static_cast<uint32_t>(model.vertices.size());
+        ref.firstIndex  = static_cast<uint32_t>(model.indices.size());
+        model.vertices.reserve(model.vertices.size() + mesh->mNumVertices);
+
+        for (unsigned int i = 0; i < mesh->mNumVertices; i++) {
+            Vertex vertex;
+            vertex.pos     = toVec3(mesh->mVertices[i]);
+            vertex.normal  = mesh->mNormals ? toVec3(mesh->mNormals[i]) : glm::vec3(0.0f);
+            vertex.tangent = mesh->mTangents ? toVec3(mesh->mTangents[i]) : glm::vec3(0.0f);  // no tangents without uvs
+            if (!isIdentity) {
+                vertex.pos     = glm::vec3(xform * glm::vec4(vertex.pos, 1.0f));
+                vertex.normal  = transformDir(normalXform, vertex.normal);
+                vertex.tangent = transformDir(glm::mat3(xform), vertex.tangent);
+            }
+
+            if (mesh->mTextureCoords[0]) {
+                // Assimp allows up to 8 texture coordinate sets; we're using the first set here.
+                vertex.uv.x = mesh->mTextureCoords[0][i].x;
+                vertex.uv.y = mesh->mTextureCoords[0][i].y;
+                // vertex.uv.z = mesh->mTextureCoords[0][i].z;
+            } else {
+                vertex.uv = glm::vec2(0.0f, 0.0f);
+            }
+
+            model.vertices.push_back(vertex);
         }
 
-        vertices.push_back(vertex);
+        for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+            aiFace const& face = mesh->mFaces[i];
+            if (face.mNumIndices != 3) {
+                continue;  // points and lines, which aiProcess_Triangulate leaves alone
+            }
+            for (unsigned int j = 0; j < face.mNumIndices; j++) {
+                model.indices.push_back(ref.firstVertex + face.mIndices[j]);
+            }
+        }
+        ref.indexCount = static_cast<uint32_t>(model.indices.size()) - ref.firstIndex;
+        model.submeshes.push_back(ref);
     }
 
-    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
-        for (unsigned int j = 0; j < face.mNumIndices; j++) {
-            indices.push_back(face.mIndices[j]);
-        }
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        loadNode(scene, node->mChildren[i], xform, model);
     }
 }
 
+void loadModel(Assimp::Importer& importer, const aiScene* scene, VulkMesh& model) {
+    if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
+        std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        VULK_THROW("Error loading model");
+    }
+    loadNode(scene, scene->mRootNode, glm::mat4(1.0f), model);
+}
+
 namespace std {
 template <>
 struct hash<Vertex> {
@@ -62,16 +98,33 @@ struct hash<Vertex> {
 }  // namespace std
 
 VulkMeshRef VulkMesh::appendMesh(VulkMesh const& mesh) {
+    if (submeshes.empty() && !indices.empty()) {
+        submeshes = getDrawRanges();
+    }
     uint32_t vertexOffset = static_cast<uint32_t>(vertices.size());
     vertices.insert(vertices.end(), mesh.vertices.begin(), mesh.vertices.end());
     uint32_t indexOffset = static_cast<uint32_t>(indices.size());
     for (uint32_t index : mesh.indices) {
         indices.push_back(index + vertexOffset);
     }
+    for (VulkMeshRef ref : mesh.getDrawRanges()) {
+        if (ref.indexCount > 0) {
+            ref.firstVertex += vertexOffset;
+            ref.firstIndex += indexOffset;
+            submeshes.push_back(ref);
+        }
+    }
 
     return VulkMeshRef{mesh.name, vertexOffset, indexOffset, static_cast<uint32_t>(mesh.indices.size())};
 }
 
+std::vector<VulkMeshRef> VulkMesh::getDrawRanges() const {
+    if (submeshes.empty()) {
+        return {VulkMeshRef{name, 0, 0, static_cast<uint32_t>(indices.size())}};
+    }
+    return submeshes;
+}
+
 void VulkMesh::xform(glm::mat4 const& xform) {
     for (Vertex& v : vertices) {
         v.pos    = glm::vec3(xform * glm::vec4(v.pos, 1.0f));
@@ -82,9 +135,130 @@ void VulkMesh::xform(glm::mat4 const& xform) {
 
 VulkMesh VulkMesh::loadFromFile(char const* filename, std::string name) {
     VulkMesh model;
-    loadModel(filename, model.vertices, model.indices);
+    Assimp::Importer importer;
+    loadModel(importer, importer.ReadFile(filename, importFlags), model);
     model.name = name;
     assert(model.vertices.size() > 0);
     assert(model.indices.size() > 0);
     return model;
 }
+
+VulkMesh VulkMesh::loadFromMemory(std::span<char const> data, char const* formatHint, std::string name) {
+    VulkMesh model;
+    Assimp::Importer importer;
+    const aiScene* scene = importer.ReadFileFromMemory(data.data(), data.size(), importFlags, formatHint);
+    loadModel(importer, scene, model);
+    model.name = name;
+    assert(model.vertices.size() > 0);
+    assert(model.indices.size() > 0);
+    return model;
+}
+
+VulkMesh VulkMesh::loadFromAssets(VulkAssetPack const* pack, std::filesystem::path const& path, std::string name) {
+    if (path.extension() == COOKED_EXT) {
+        if (pack && pack->contains(path)) {
+            return loadCooked(pack->find(path), name);
+        }
+        std::vector<char> data = readFileIntoMem(path.string());
+        return loadCooked(data, name);
+    }
+    if (pack && pack->contains(path)) {
+        std::string ext = path.extension().string();
+        return loadFromMemory(pack->find(path), ext.empty() ? "" : ext.c_str() + 1, name);
+    }
+    return loadFromPath(path, name);
+}
+
+VulkMesh VulkMesh::loadCooked(std::span<char const> data, std::string name) {
+    VulkCookedMeshHeader header;
+    VULK_ASSERT(data.size() >= sizeof(header), "Cooked mesh {} is truncated", name);
+    memcpy(&header, data.data(), sizeof(header));
+    VULK_ASSERT(memcmp(header.magic, VulkCookedMeshHeader::MAGIC, sizeof(header.magic)) == 0, "{} is not a cooked mesh", name);
+    VULK_ASSERT(header.version == VulkCookedMeshHeader::VERSION,
+                "Cooked mesh {} is version {}, expected {}. rebuild it.",
+                name,
+                header.version,
+                VulkCookedMeshHeader::VERSION);
+    size_t numVertices = header.numVertices;
+    size_t streamsSize = sizeof(header) + numVertices * (3 * sizeof(glm::vec3) + sizeof(glm::vec2)) +
+                         header.numIndices * sizeof(uint32_t);
+    VULK_ASSERT(data.size() >= streamsSize, "Cooked mesh {} is {} bytes, expected at least {}", name, data.size(), streamsSize);
+
+    VulkMesh model;
+    model.name = name;
+    model.vertices.resize(numVertices);
+    model.indices.resize(header.numIndices);
+    char const* src = data.data() + sizeof(header);
+    auto readStream = [&](auto member) {
+        for (Vertex& v : model.vertices) {
+            memcpy(&(v.*member), src, sizeof(v.*member));
+            src += sizeof(v.*member);
+        }
+    };
+    readStream(&Vertex::pos);
+    readStream(&Vertex::normal);
+    readStream(&Vertex::tangent);
+    readStream(&Vertex::uv);
+    memcpy(model.indices.data(), src, model.indices.size() * sizeof(uint32_t));
+    src += model.indices.size() * sizeof(uint32_t);
+
+    char const* end = data.data() + data.size();
+    auto readU32    = [&]() {
+        VULK_ASSERT(end - src >= (ptrdiff_t)sizeof(uint32_t), "Cooked mesh {} is truncated", name);
+        uint32_t value;
+        memcpy(&value, src, sizeof(value));
+        src += sizeof(value);
+        return value;
+    };
+    model.submeshes.resize(header.numSubmeshes);
+    for (VulkMeshRef& submesh : model.submeshes) {
+        submesh.firstVertex = readU32();
+        submesh.firstIndex  = readU32();
+        submesh.indexCount  = readU32();
+        uint32_t nameLength = readU32();
+        VULK_ASSERT(end - src >= (ptrdiff_t)nameLength, "Cooked mesh {} is truncated", name);
+        VULK_ASSERT((uint64_t)submesh.firstIndex + submesh.indexCount <= header.numIndices,
+                    "Cooked mesh {}: submesh out of range",
+                    name);
+        submesh.name.assign(src, nameLength);
+        src += nameLength;
+    }
+    VULK_ASSERT(src == end, "Cooked mesh {} has {} extra bytes", name, end - src);
+    return model;
+}
+
+void VulkMesh::writeCooked(std::filesystem::path const& path) const {
+    VulkCookedMeshHeader header;
+    memcpy(header.magic, VulkCookedMeshHeader::MAGIC, sizeof(header.magic));
+    header.version      = VulkCookedMeshHeader::VERSION;
+    header.numVertices  = static_cast<uint32_t>(vertices.size());
+    header.numIndices   = static_cast<uint32_t>(indices.size());
+    header.numSubmeshes = static_cast<uint32_t>(submeshes.size());
+    header.boundsMin    = vertices.empty() ? glm::vec3(0.0f) : vertices[0].pos;
+    header.boundsMax    = header.boundsMin;
+    for (Vertex const& v : vertices) {
+        header.boundsMin = glm::min(header.boundsMin, v.pos);
+        header.boundsMax = glm::max(header.boundsMax, v.pos);
+    }
+
+    std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+    VULK_ASSERT(ofs.is_open(), "Could not open file for writing: {}", path.string());
+    ofs.write((char const*)&header, sizeof(header));
+    auto writeStream = [&](auto member) {
+        for (Vertex const& v : vertices) {
+            ofs.write((char const*)&(v.*member), sizeof(v.*member));
+        }
+    };
+    writeStream(&Vertex::pos);
+    writeStream(&Vertex::normal);
+    writeStream(&Vertex::tangent);
+    writeStream(&Vertex::uv);
+    ofs.write((char const*)indices.data(), (std::streamsize)(indices.size() * sizeof(uint32_t)));
+    for (VulkMeshRef const& submesh : submeshes) {
+        uint32_t fields[4] = {
+            submesh.firstVertex, submesh.firstIndex, submesh.indexCount, static_cast<uint32_t>(submesh.name.size())};
+        ofs.write((char const*)fields, sizeof(fields));
+        ofs.write(submesh.name.data(), (std::streamsize)submesh.name.size());
+    }
+    VULK_ASSERT(ofs.good(), "Failed to write cooked mesh {}", path.string());
+}
@@ -0,0 +1,363 @@
+#include "Vulk/VulkMeshOptimizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "Vulk/VulkHash.h"
+
+namespace {
+struct VertexBitsHash {
+    size_t operator()(Vertex const& v) const {
+        return (size_t)VulkHasher().addValue(v).get();
+    }
+};
+struct VertexBitsEqual {
+    bool operator()(Vertex const& a, Vertex const& b) const {
+        return memcmp(&a, &b, sizeof(Vertex)) == 0;
+    }
+};
+static_assert(sizeof(Vertex) == 11 * sizeof(float), "Vertex has padding, bitwise compares won't work");
+
+// FIFO post-transform cache using timestamps: a vertex is in the cache if fewer than
+// cacheSize vertices have been transformed since it was
+class VertexCacheSim {
+   public:
+    VertexCacheSim(size_t numVertices, uint32_t cacheSize)
+        : cacheSize(cacheSize), time(cacheSize + 1), stamps(numVertices, 0) {}
+
+    bool contains(uint32_t v) const {
+        return time - stamps[v] <= cacheSize;
+    }
+    // true if it was a miss
+    bool use(uint32_t v) {
+        if (contains(v)) {
+            return false;
+        }
+        stamps[v] = time++;
+        return true;
+    }
+
+   private:
+    uint32_t cacheSize;
+    uint32_t time;
+    std::vector<uint32_t> stamps;
+};
+
+constexpr uint32_t UNUSED = ~0u;
+
+uint32_t countCacheMisses(std::span<uint32_t const> indices, size_t numVertices, uint32_t cacheSize) {
+    VertexCacheSim cache(numVertices, cacheSize);
+    uint32_t misses = 0;
+    for (uint32_t index : indices) {
+        misses += cache.use(index) ? 1 : 0;
+    }
+    return misses;
+}
+
+// calls fn(indices, globalIds) for each draw range of the mesh with the range's indices
+// renumbered 0..n-1 in order of first use and globalIds mapping them back, so the passes that
+// reorder triangles stay within their submesh and cost O(range) rather than O(mesh)
+template <typename Fn>
+void forEachRange(VulkMesh& mesh, Fn&& fn) {
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;  // first index, index count
+    if (mesh.submeshes.empty()) {
+        ranges.push_back({0, (uint32_t)mesh.indices.size()});
+    }
+    for (VulkMeshRef const& submesh : mesh.submeshes) {
+        VULK_ASSERT((size_t)submesh.firstIndex + submesh.indexCount <= mesh.indices.size(),
+                    "{}: submesh {} is out of range",
+                    mesh.name,
+                    submesh.name);
+        ranges.push_back({submesh.firstIndex, submesh.indexCount});
+    }
+
+    std::vector<uint32_t> localIds(mesh.vertices.size(), UNUSED);
+    std::vector<uint32_t> globalIds;
+    for (auto [firstIndex, indexCount] : ranges) {
+        std::span<uint32_t> indices(mesh.indices.data() + firstIndex, indexCount - indexCount % 3);
+        globalIds.clear();
+        for (uint32_t& index : indices) {
+            if (localIds[index] == UNUSED) {
+                localIds[index] = (uint32_t)globalIds.size();
+                globalIds.push_back(index);
+            }
+            index = localIds[index];
+        }
+        fn(indices, globalIds);
+        for (uint32_t& index : indices) {
+            index = globalIds[index];
+        }
+        for (uint32_t globalId : globalIds) {
+            localIds[globalId] = UNUSED;
+        }
+    }
+}
+
+// the lowest vertex each submesh uses, after the vertices have been renumbered
+void updateFirstVertices(VulkMesh& mesh) {
+    for (VulkMeshRef& submesh : mesh.submeshes) {
+        auto first          = mesh.indices.begin() + submesh.firstIndex;
+        auto last           = first + submesh.indexCount;
+        submesh.firstVertex = first == last ? 0 : *std::min_element(first, last);
+    }
+}
+
+// Tipsify: fan around the most recently used vertex that will still be in the cache, with
+// a stack of recently used vertices to pick up from at dead ends
+void optimizeRangeForVertexCache(std::span<uint32_t> indices, uint32_t numVertices, uint32_t cacheSize) {
+    uint32_t numTriangles = (uint32_t)(indices.size() / 3);
+    if (numTriangles == 0) {
+        return;
+    }
+
+    // vertex -> triangles using it, as offsets into one array
+    std::vector<uint32_t> liveTriangles(numVertices, 0);
+    for (uint32_t index : indices) {
+        liveTriangles[index]++;
+    }
+    std::vector<uint32_t> adjacencyOffsets(numVertices + 1, 0);
+    std::partial_sum(liveTriangles.begin(), liveTriangles.end(), adjacencyOffsets.begin() + 1);
+    std::vector<uint32_t> adjacency(indices.size());
+    std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+    for (uint32_t t = 0; t < numTriangles; ++t) {
+        for (uint32_t c = 0; c < 3; ++c) {
+            adjacency[fill[indices[t * 3 + c]]++] = t;
+        }
+    }
+
+    std::vector<uint32_t> cacheStamps(numVertices, 0);
+    std::vector<bool> emitted(numTriangles, false);
+    std::vector<uint32_t> deadEnds;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> out;
+    out.reserve(indices.size());
+    uint32_t time   = cacheSize + 1;
+    uint32_t cursor = 0;
+
+    // a vertex with live triangles that was recently used, falling back to the next vertex
+    // with live triangles in input order
+    auto skipDeadEnd = [&]() -> int64_t {
+        while (!deadEnds.empty()) {
+            uint32_t v = deadEnds.back();
+            deadEnds.pop_back();
+            if (liveTriangles[v] > 0) {
+                return v;
+            }
+        }
+        for (; cursor < numVertices; ++cursor) {
+            if (liveTriangles[cursor] > 0) {
+                return cursor;
+            }
+        }
+        return -1;
+    };
+
+    for (int64_t fanning = skipDeadEnd(); fanning >= 0;) {
+        candidates.clear();
+        for (uint32_t a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a) {
+            uint32_t t = adjacency[a];
+            if (emitted[t]) {
+                continue;
+            }
+            emitted[t] = true;
+            for (uint32_t c = 0; c < 3; ++c) {
+                uint32_t v = indices[t * 3 + c];
+                out.push_back(v);
+                deadEnds.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if (time - cacheStamps[v] > cacheSize) {
+                    cacheStamps[v] = time++;
+                }
+            }
+        }
+
+        // prefer the candidate that has been in the cache longest but will still be in it
+        // after its remaining triangles are emitted
+        int64_t next      = -1;
+        int64_t bestScore = -1;
+        for (uint32_t v : candidates) {
+            if (liveTriangles[v] == 0) {
+                continue;
+            }
+            int64_t score = 0;
+            if (time - cacheStamps[v] + 2 * liveTriangles[v] <= cacheSize) {
+                score = time - cacheStamps[v];
+            }
+            if (score > bestScore) {
+                bestScore = score;
+                next      = v;
+            }
+        }
+        fanning = next >= 0 ? next : skipDeadEnd();
+    }
+    VULK_ASSERT(out.size() == indices.size(), "optimizeVertexCache dropped triangles");
+    std::copy(out.begin(), out.end(), indices.begin());
+}
+
+// sorts the clusters of an already cache optimized range so outward facing ones draw first
+void optimizeRangeForOverdraw(std::span<uint32_t> indices,
+                              std::vector<glm::vec3> const& positions,
+                              float threshold,
+                              uint32_t cacheSize) {
+    size_t numTriangles = indices.size() / 3;
+    if (numTriangles == 0) {
+        return;
+    }
+    uint32_t missesBefore = countCacheMisses(indices, positions.size(), cacheSize);
+
+    // split where the cache pass started over, i.e. a triangle where all three vertices miss.
+    // moving those around has the least effect on the cache.
+    std::vector<size_t> clusterStarts;
+    VertexCacheSim cache(positions.size(), cacheSize);
+    for (size_t t = 0; t < numTriangles; ++t) {
+        uint32_t misses = 0;
+        for (size_t c = 0; c < 3; ++c) {
+            misses += cache.use(indices[t * 3 + c]) ? 1 : 0;
+        }
+        if (misses == 3 || t == 0) {
+            clusterStarts.push_back(t);
+        }
+    }
+    clusterStarts.push_back(numTriangles);
+    size_t numClusters = clusterStarts.size() - 1;
+    if (numClusters < 2) {
+        return;
+    }
+
+    struct Cluster {
+        size_t first;
+        size_t last;
+        glm::vec3 centroid;  // area weighted
+        glm::vec3 normal;    // area weighted, not normalized
+    };
+    std::vector<Cluster> clusters(numClusters);
+    glm::vec3 meshCentroid(0.0f);
+    float meshArea = 0.0f;
+    for (size_t i = 0; i < numClusters; ++i) {
+        Cluster& cluster = clusters[i];
+        cluster          = {clusterStarts[i], clusterStarts[i + 1], glm::vec3(0.0f), glm::vec3(0.0f)};
+        float area       = 0.0f;
+        for (size_t t = cluster.first; t < cluster.last; ++t) {
+            glm::vec3 p0  = positions[indices[t * 3 + 0]];
+            glm::vec3 p1  = positions[indices[t * 3 + 1]];
+            glm::vec3 p2  = positions[indices[t * 3 + 2]];
+            glm::vec3 n   = glm::cross(p1 - p0, p2 - p0);
+            float triArea = glm::length(n);
+
+            cluster.normal += n;
+            cluster.centroid += (p0 + p1 + p2) * (triArea / 3.0f);
+            area += triArea;
+        }
+        meshCentroid += cluster.centroid;
+        meshArea += area;
+        if (area > 0.0f) {
+            cluster.centroid /= area;
+        }
+    }
+    if (meshArea > 0.0f) {
+        meshCentroid /= meshArea;
+    }
+
+    // clusters on the outside facing out are the most likely to occlude the rest, draw them first
+    auto occlusion = [&meshCentroid](Cluster const& cluster) {
+        float len = glm::length(cluster.normal);
+        return len > 0.0f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / len) : 0.0f;
+    };
+    std::stable_sort(clusters.begin(), clusters.end(), [&occlusion](Cluster const& a, Cluster const& b) {
+        return occlusion(a) > occlusion(b);
+    });
+
+    std::vector<uint32_t> out;
+    out.reserve(indices.size());
+    for (Cluster const& cluster : clusters) {
+        out.insert(out.end(), indices.begin() + cluster.first * 3, indices.begin() + cluster.last * 3);
+    }
+    if ((float)countCacheMisses(out, positions.size(), cacheSize) <= (float)missesBefore * threshold) {
+        std::copy(out.begin(), out.end(), indices.begin());
+    }
+}
+
+}  // namespace
+
+uint32_t VulkMeshOptimizer::deduplicateVertices(VulkMesh& mesh) {
+    std::unordered_map<Vertex, uint32_t, VertexBitsHash, VertexBitsEqual> unique;
+    unique.reserve(mesh.vertices.size());
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> remap(mesh.vertices.size());
+    for (size_t i = 0; i < mesh.vertices.size(); ++i) {
+        auto [it, added] = unique.try_emplace(mesh.vertices[i], (uint32_t)vertices.size());
+        if (added) {
+            vertices.push_back(mesh.vertices[i]);
+        }
+        remap[i] = it->second;
+    }
+    for (uint32_t& index : mesh.indices) {
+        index = remap[index];
+    }
+    uint32_t removed = (uint32_t)(mesh.vertices.size() - vertices.size());
+    mesh.vertices    = std::move(vertices);
+    updateFirstVertices(mesh);
+    return removed;
+}
+
+void VulkMeshOptimizer::optimizeVertexCache(VulkMesh& mesh, uint32_t cacheSize) {
+    forEachRange(mesh, [cacheSize](std::span<uint32_t> indices, std::vector<uint32_t> const& globalIds) {
+        optimizeRangeForVertexCache(indices, (uint32_t)globalIds.size(), cacheSize);
+    });
+}
+
+void VulkMeshOptimizer::optimizeOverdraw(VulkMesh& mesh, float threshold, uint32_t cacheSize) {
+    std::vector<glm::vec3> positions;
+    forEachRange(mesh, [&](std::span<uint32_t> indices, std::vector<uint32_t> const& globalIds) {
+        positions.clear();
+        for (uint32_t globalId : globalIds) {
+            positions.push_back(mesh.vertices[globalId].pos);
+        }
+        optimizeRangeForOverdraw(indices, positions, threshold, cacheSize);
+    });
+}
+
+void VulkMeshOptimizer::optimizeVertexFetch(VulkMesh& mesh) {
+    std::vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+    std::vector<Vertex> vertices;
+    vertices.reserve(mesh.vertices.size());
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = (uint32_t)vertices.size();
+            vertices.push_back(mesh.vertices[index]);
+        }
+        index = remap[index];
+    }
+    mesh.vertices = std::move(vertices);
+    updateFirstVertices(mesh);
+}
+
+void VulkMeshOptimizer::optimize(VulkMesh& mesh) {
+    deduplicateVertices(mesh);
+    optimizeVertexCache(mesh);
+    optimizeOverdraw(mesh);
+    optimizeVertexFetch(mesh);
+}
+
+VulkVertexCacheStats VulkMeshOptimizer::analyzeVertexCache(VulkMesh const& mesh, uint32_t cacheSize) {
+    VulkVertexCacheStats stats;
+    stats.numTriangles = (uint32_t)(mesh.indices.size() / 3);
+    std::vector<bool> referenced(mesh.vertices.size(), false);
+    VertexCacheSim cache(mesh.vertices.size(), cacheSize);
+    for (uint32_t index : mesh.indices) {
+        VULK_ASSERT(index < mesh.vertices.size(), "{}: index {} out of range", mesh.name, index);
+        if (!referenced[index]) {
+            referenced[index] = true;
+            stats.numVertices++;
+        }
+        stats.numTransformed += cache.use(index) ? 1 : 0;
+    }
+    stats.acmr = stats.numTriangles ? (float)stats.numTransformed / (float)stats.numTriangles : 0.0f;
+    stats.atvr = stats.numVertices ? (float)stats.numTransformed / (float)stats.numVertices : 0.0f;
+    return stats;
+}
@@ -0,0 +1,126 @@
+#include "Vulk/VulkParallelRecorder.h"
+
+#include <algorithm>
+#include <exception>
+#include <future>
+
+#include "Vulk/VulkUtil.h"
+
+using namespace std;
+
+// numThreads - 1 workers, the calling thread records a chunk too
+VulkParallelRecorder::VulkParallelRecorder(Vulk& vk, uint32_t numThreads)
+    : vk(vk), workers(max(numThreads, 2u) - 1) {
+    resetFrameCount.fill(UINT32_MAX);
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = vk.indices.graphicsFamily.value();
+    for (auto& frameChunks : chunks) {
+        frameChunks.resize(workers.numThreads() + 1);
+        for (Chunk& chunk : frameChunks) {
+            VK_CALL(vkCreateCommandPool(vk.device, &poolInfo, nullptr, &chunk.pool));
+        }
+    }
+}
+
+VulkParallelRecorder::~VulkParallelRecorder() {
+    for (auto& frameChunks : chunks) {
+        for (Chunk& chunk : frameChunks) {
+            // destroying the pool frees its buffers
+            vkDestroyCommandPool(vk.device, chunk.pool, nullptr);
+        }
+    }
+}
+
+VkCommandBuffer VulkParallelRecorder::nextBuffer(Chunk& chunk) {
+    if (chunk.numUsed == chunk.bufs.size()) {
+        VkCommandBufferAllocateInfo allocInfo{};
+        allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool        = chunk.pool;
+        allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+        allocInfo.commandBufferCount = 1;
+        VkCommandBuffer buf;
+        VK_CALL(vkAllocateCommandBuffers(vk.device, &allocInfo, &buf));
+        chunk.bufs.push_back(buf);
+    }
+    return chunk.bufs[chunk.numUsed++];
+}
+
+VulkDrawList::Stats VulkParallelRecorder::record(VkCommandBuffer commandBuffer,
+                                                 VulkDrawList& list,
+                                                 VkRenderPass renderPass,
+                                                 uint32_t subpass,
+                                                 VkFramebuffer framebuffer,
+                                                 VkExtent2D extent) {
+    uint32_t frame                  = vk.currentFrame;
+    std::vector<Chunk>& frameChunks = chunks[frame];
+    if (resetFrameCount[frame] != vk.frameCount) {
+        for (Chunk& chunk : frameChunks) {
+            VK_CALL(vkResetCommandPool(vk.device, chunk.pool, 0));
+            chunk.numUsed = 0;
+        }
+        resetFrameCount[frame] = vk.frameCount;
+    }
+
+    list.sort();
+    size_t numDraws  = list.size();
+    size_t numChunks = clamp<size_t>(numDraws / MIN_DRAWS_PER_CHUNK, 1, frameChunks.size());
+    size_t chunkSize = (numDraws + numChunks - 1) / numChunks;
+
+    // allocated up front so the workers only record
+    std::vector<VkCommandBuffer> bufs;
+    for (size_t i = 0; i < numChunks; ++i) {
+        bufs.push_back(nextBuffer(frameChunks[i]));
+    }
+
+    auto recordChunk = [&, frame](size_t i) {
+        VkCommandBufferInheritanceInfo inheritance{};
+        inheritance.sType       = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritance.renderPass  = renderPass;
+        inheritance.subpass     = subpass;
+        inheritance.framebuffer = framebuffer;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags            = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT |
+                                     VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+        beginInfo.pInheritanceInfo = &inheritance;
+        VK_CALL(vkBeginCommandBuffer(bufs[i], &beginInfo));
+
+        VkViewport viewport{0.0f, 0.0f, (float)extent.width, (float)extent.height, 0.0f, 1.0f};
+        VkRect2D scissor{{0, 0}, extent};
+        vkCmdSetViewport(bufs[i], 0, 1, &viewport);
+        vkCmdSetScissor(bufs[i], 0, 1, &scissor);
+
+        size_t first              = min(i * chunkSize, numDraws);
+        VulkDrawList::Stats stats = list.recordRange(bufs[i], frame, first, min(chunkSize, numDraws - first));
+        VK_CALL(vkEndCommandBuffer(bufs[i]));
+        return stats;
+    };
+
+    std::vector<std::future<VulkDrawList::Stats>> futures;
+    for (size_t i = 1; i < numChunks; ++i) {
+        futures.push_back(workers.submit([&recordChunk, i]() { return recordChunk(i); }));
+    }
+    // the workers use what's on this stack, so they have to be done before anything is thrown out of here
+    VulkDrawList::Stats stats;
+    exception_ptr error;
+    try {
+        stats = recordChunk(0);
+    } catch (...) {
+        error = current_exception();
+    }
+    for (auto& future : futures) {
+        future.wait();
+    }
+    if (error) {
+        rethrow_exception(error);
+    }
+    for (auto& future : futures) {
+        stats += future.get();
+    }
+
+    vkCmdExecuteCommands(commandBuffer, (uint32_t)bufs.size(), bufs.data());
+    return stats;
+}
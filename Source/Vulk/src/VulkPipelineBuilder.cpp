@@ -99,44 +99,11 @@ VulkPipelineBuilder& VulkPipelineBuilder::setDepthCompareOp(VkCompareOp compareO
     return *this;
 }
 
-VulkPipelineBuilder& VulkPipelineBuilder::addVertexInput(vulk::cpp2::VulkShaderLocation locationIn) {
-    VULK_ASSERT(vertInputs.find(locationIn) == vertInputs.end(), "Vertex input location already exists");
-    uint32_t location = static_cast<uint32_t>(locationIn);
-    VkFormat format;
-    uint32_t stride;
-
-    switch (locationIn) {
-        case vulk::cpp2::VulkShaderLocation::Pos:
-        case vulk::cpp2::VulkShaderLocation::Normal:
-        case vulk::cpp2::VulkShaderLocation::Tangent:
-            format = VK_FORMAT_R32G32B32_SFLOAT;
-            stride = sizeof(glm::vec3);
-            break;
-        case vulk::cpp2::VulkShaderLocation::TexCoord:
-            format = VK_FORMAT_R32G32_SFLOAT;
-            stride = sizeof(glm::vec2);
-            break;
-        default:
-            VULK_THROW("Unknown vertex input location");
-    };
-
-    VkVertexInputBindingDescription binding = {};
-    binding.binding                         = location;  // We'll have a single vertex buffer, so we use binding point 0
-    binding.stride                          = stride;    // Size of a single Vertex object
-    binding.inputRate                       = VK_VERTEX_INPUT_RATE_VERTEX;  // Move to the next data entry after each vertex
-
-    VkVertexInputAttributeDescription attribute{};
-    attribute.binding  = location;
-    attribute.location = location;
-    attribute.format   = format;
-    attribute.offset   = 0;
-
-    VertInput input = {
-        .binding   = binding,
-        .attribute = attribute,
-    };
-    vertInputs[locationIn] = input;
-
+VulkPipelineBuilder& VulkPipelineBuilder::addVertexInput(vulk::cpp2::VulkShaderLocation location) {
+    VULK_ASSERT(std::find(vertInputs.begin(), vertInputs.end(), location) == vertInputs.end(),
+                "Vertex input location already exists");
+    VulkVertexLayout::formatFor(vertexLayout, location);  // throws if it isn't something a mesh provides
+    vertInputs.push_back(location);
     return *this;
 }
 
@@ -164,12 +131,9 @@ void VulkPipelineBuilder::build(VkRenderPass renderPass,
                                 VkPipeline* graphicsPipeline) {
     assert(viewport.maxDepth > 0.f);
 
-    std::vector<VkVertexInputBindingDescription> bindingDescriptions;
-    std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
-    for (auto& input : vertInputs) {
-        bindingDescriptions.push_back(input.second.binding);
-        attributeDescriptions.push_back(input.second.attribute);
-    }
+    VulkVertexLayout layout(vertexLayout, vertInputs);
+    std::vector<VkVertexInputBindingDescription> bindingDescriptions     = layout.bindingDescriptions();
+    std::vector<VkVertexInputAttributeDescription> attributeDescriptions = layout.attributeDescriptions();
 
     VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
     vertexInputInfo.sType                                = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
@@ -214,7 +178,17 @@ void VulkPipelineBuilder::build(VkRenderPass renderPass,
     pipelineInfo.subpass             = subpass;
     pipelineInfo.basePipelineHandle  = VK_NULL_HANDLE;
 
-    VK_CALL(vkCreateGraphicsPipelines(vk.device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, graphicsPipeline));
+    // tells us whether the pipeline came out of vk.pipelineCache
+    VkPipelineCreationFeedback pipelineFeedback{};
+    VkPipelineCreationFeedbackCreateInfo feedbackInfo{};
+    feedbackInfo.sType                     = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO;
+    feedbackInfo.pPipelineCreationFeedback = &pipelineFeedback;
+    if (vk.pipelineCache->hasCreationFeedback()) {
+        pipelineInfo.pNext = &feedbackInfo;
+    }
+
+    VK_CALL(vkCreateGraphicsPipelines(vk.device, vk.pipelineCache->get(), 1, &pipelineInfo, nullptr, graphicsPipeline));
+    vk.pipelineCache->recordFeedback(pipelineFeedback);
 }
 
 std::shared_ptr<const VulkPipeline> VulkPipelineBuilder::build(
@@ -0,0 +1,184 @@
+#include "Vulk/VulkPipelineCache.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include "Vulk/VulkHash.h"
+#include "Vulk/VulkLogger.h"
+#include "Vulk/VulkUtil.h"
+
+namespace fs = std::filesystem;
+
+DECLARE_FILE_LOGGER();
+
+VulkPipelineCache::VulkPipelineCache(VkDevice device, VkPhysicalDevice physicalDevice, fs::path path)
+    : device(device), path(std::move(path)) {
+    vkGetPhysicalDeviceProperties(physicalDevice, &props);
+    creationFeedback = props.apiVersion >= VK_API_VERSION_1_3;
+
+    std::vector<char> file;
+    std::span<char const> data;
+    std::ifstream ifs(this->path, std::ios::binary | std::ios::ate);
+    if (ifs.is_open()) {
+        file.resize((size_t)ifs.tellg());
+        ifs.seekg(0);
+        std::string reason;
+        if (!ifs.read(file.data(), file.size())) {
+            logger->warn("Ignoring pipeline cache {}: couldn't read it", this->path.string());
+        } else if (!deserialize(file, props, data, reason)) {
+            logger->info("Ignoring pipeline cache {}: {}", this->path.string(), reason);
+            data = {};
+        }
+    } else {
+        logger->info("No pipeline cache at {}, starting empty", this->path.string());
+    }
+
+    VkPipelineCacheCreateInfo createInfo{};
+    createInfo.sType           = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    createInfo.initialDataSize = data.size();
+    createInfo.pInitialData    = data.data();
+    if (vkCreatePipelineCache(device, &createInfo, nullptr, &cache) != VK_SUCCESS && !data.empty()) {
+        // the driver is allowed to reject data it doesn't like, even if we thought it was fine
+        logger->warn("Driver rejected pipeline cache {}, starting empty", this->path.string());
+        createInfo.initialDataSize = 0;
+        createInfo.pInitialData    = nullptr;
+        VK_CALL(vkCreatePipelineCache(device, &createInfo, nullptr, &cache));
+        data = {};
+    }
+    loadedSize = data.size();
+    if (loadedSize) {
+        logger->info("Loaded {} bytes of pipeline cache from {}", loadedSize, this->path.string());
+    }
+}
+
+VulkPipelineCache::~VulkPipelineCache() {
+    vkDestroyPipelineCache(device, cache, nullptr);
+}
+
+void VulkPipelineCache::save() {
+    size_t size = 0;
+    VK_CALL(vkGetPipelineCacheData(device, cache, &size, nullptr));
+    std::vector<char> data(size);
+    VK_CALL(vkGetPipelineCacheData(device, cache, &size, data.data()));
+    data.resize(size);
+    std::vector<char> file = serialize(props, data);
+
+    fs::path tmpPath = path;
+    tmpPath += fmt::format(".{}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+    try {
+        {
+            std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+            VULK_ASSERT(ofs.is_open(), "Could not open {} for writing", tmpPath.string());
+            ofs.write(file.data(), file.size());
+            VULK_ASSERT(ofs.good(), "Failed writing {}", tmpPath.string());
+        }
+        fs::rename(tmpPath, path);
+        logger->info("Saved {} bytes of pipeline cache to {} (loaded {})", size, path.string(), loadedSize);
+    } catch (std::exception& e) {
+        logger->warn("Not saving pipeline cache: {}", e.what());
+        std::error_code ec;
+        fs::remove(tmpPath, ec);
+    }
+}
+
+void VulkPipelineCache::recordFeedback(VkPipelineCreationFeedback const& feedback) {
+    if (!(feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT)) {
+        return;
+    }
+    if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT) {
+        hits++;
+        hitNanos += feedback.duration;
+    } else {
+        misses++;
+        missNanos += feedback.duration;
+    }
+}
+
+void VulkPipelineCache::logStats() const {
+    if (!creationFeedback) {
+        logger->info("Pipeline cache: no creation feedback on this device, hits and misses weren't counted");
+        return;
+    }
+    logger->info("Pipeline cache: {} hits ({:.1f}ms), {} misses ({:.1f}ms)",
+                 hits.load(),
+                 (double)hitNanos.load() / 1e6,
+                 misses.load(),
+                 (double)missNanos.load() / 1e6);
+}
+
+std::vector<char> VulkPipelineCache::serialize(VkPhysicalDeviceProperties const& props, std::span<char const> data) {
+    VulkPipelineCacheFileHeader header{};
+    memcpy(header.magic, VulkPipelineCacheFileHeader::MAGIC, sizeof(header.magic));
+    header.version       = VulkPipelineCacheFileHeader::VERSION;
+    header.vendorID      = props.vendorID;
+    header.deviceID      = props.deviceID;
+    header.driverVersion = props.driverVersion;
+    memcpy(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE);
+    header.dataSize = (uint32_t)data.size();
+    header.dataHash = VulkHasher().add(data.data(), data.size()).get();
+
+    std::vector<char> file(sizeof(header) + data.size());
+    memcpy(file.data(), &header, sizeof(header));
+    std::copy(data.begin(), data.end(), file.begin() + sizeof(header));
+    return file;
+}
+
+bool VulkPipelineCache::deserialize(std::span<char const> file,
+                                    VkPhysicalDeviceProperties const& props,
+                                    std::span<char const>& data,
+                                    std::string& reason) {
+    VulkPipelineCacheFileHeader header;
+    if (file.size() < sizeof(header)) {
+        reason = "truncated";
+        return false;
+    }
+    memcpy(&header, file.data(), sizeof(header));
+    if (memcmp(header.magic, VulkPipelineCacheFileHeader::MAGIC, sizeof(header.magic)) != 0) {
+        reason = "not a pipeline cache";
+        return false;
+    }
+    if (header.version != VulkPipelineCacheFileHeader::VERSION) {
+        reason = fmt::format("version {}, expected {}", header.version, VulkPipelineCacheFileHeader::VERSION);
+        return false;
+    }
+    if (header.vendorID != props.vendorID || header.deviceID != props.deviceID) {
+        reason = fmt::format("made on device {:x}:{:x}, this is {:x}:{:x}",
+                             header.vendorID,
+                             header.deviceID,
+                             props.vendorID,
+                             props.deviceID);
+        return false;
+    }
+    if (header.driverVersion != props.driverVersion) {
+        reason = fmt::format("made by driver version {:x}, this is {:x}", header.driverVersion, props.driverVersion);
+        return false;
+    }
+    if (memcmp(header.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        reason = "pipeline cache UUID changed";
+        return false;
+    }
+    data = file.subspan(sizeof(header));
+    if (data.size() != header.dataSize || VulkHasher().add(data.data(), data.size()).get() != header.dataHash) {
+        reason = "data is corrupt";
+        return false;
+    }
+
+    // the driver checks its own header too, but not every driver does it carefully
+    VkPipelineCacheHeaderVersionOne driverHeader;
+    if (data.size() < sizeof(driverHeader)) {
+        reason = "driver data is truncated";
+        return false;
+    }
+    memcpy(&driverHeader, data.data(), sizeof(driverHeader));
+    if (driverHeader.headerSize < sizeof(driverHeader) || driverHeader.headerSize > data.size() ||
+        driverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE || driverHeader.vendorID != props.vendorID ||
+        driverHeader.deviceID != props.deviceID ||
+        memcmp(driverHeader.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) != 0) {
+        reason = "driver header doesn't match this device";
+        return false;
+    }
+    return true;
+}
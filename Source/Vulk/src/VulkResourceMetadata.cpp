@@ -18,14 +18,26 @@ static std::shared_ptr<spdlog::logger> logger = VulkLogger::CreateLogger("VulkRe
 
 #pragma warning(disable : 4244)  // double to float
 
-MaterialDef loadMaterialDef(const fs::path& file) {
-    if (!fs::exists(file)) {
+// materials and the textures they reference are found in the pack if there is one
+static bool assetExists(VulkAssetPack const* pack, fs::path const& path) {
+    return (pack && pack->contains(path)) || fs::exists(path);
+}
+
+MaterialDef loadMaterialDef(const fs::path& file, VulkAssetPack const* pack) {
+    if (!assetExists(pack, file)) {
         VULK_THROW("Material file does not exist: {}", file.string());
     }
 
-    std::ifstream mtlFile(file);
-    if (!mtlFile.is_open()) {
-        VULK_THROW("Failed to open material file: {}", file.string());
+    std::istringstream mtlFile;
+    if (pack && pack->contains(file)) {
+        std::span<char const> data = pack->find(file);
+        mtlFile.str(std::string(data.begin(), data.end()));
+    } else {
+        std::ifstream ifs(file);
+        if (!ifs.is_open()) {
+            VULK_THROW("Failed to open material file: {}", file.string());
+        }
+        mtlFile.str(std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>()));
     }
 
     // Ka: Ambient reflectivity
@@ -69,7 +81,7 @@ MaterialDef loadMaterialDef(const fs::path& file) {
 
         auto processPath = [&](const std::string& relativePath) -> std::string {
             fs::path absPath = fs::absolute(basePath / relativePath);
-            if (!fs::exists(absPath)) {
+            if (!assetExists(pack, absPath)) {
                 VULK_THROW("Referenced file does not exist: {}", absPath.string());
             }
             return absPath.string();
@@ -288,10 +300,9 @@ SceneDef SceneDef::fromDef(
     return s;
 }
 
-void findAndProcessMetadata(const fs::path path, Metadata& metadata) {
-    logger->info("Finding and processing metadata in {}", std::filesystem::absolute(path).string());
-    assert(fs::exists(path) && fs::is_directory(path));
-    metadata.assetsDir = path;
+// files are either everything under the assets dir or everything in the pack
+static void processMetadata(std::vector<fs::path> const& files, Metadata& metadata) {
+    fs::path const& path = metadata.assetsDir;
 
     // The metadata is stored in JSON files with the following extensions
     // other extensions need special handling or no handling (e.g. .mtl files are handled by
@@ -301,49 +312,60 @@ void findAndProcessMetadata(const fs::path path, Metadata& metadata) {
         string filePath;
     };
     unordered_map<string, unordered_map<string, LoadInfo>> loadInfos;
+    unordered_map<string, string> cookedMeshes;
 
     // for non leaf resources:
     // we gather everything up first because we load and fixup defs at the same time
     // vs. loading all the defs and then doing a fixup pass so each resource
     // is complete when it is loaded.
-    for (const auto& entry : fs::recursive_directory_iterator(path)) {
-        if (!entry.is_regular_file()) {
-            continue;
-        }
-        string stem = entry.path().stem().string();
-        string ext  = entry.path().stem().extension().string() +
-                     entry.path().extension().string();  // get 'bar' from foo.bar and 'bar.bin' from foo.bar.bin
+    for (const fs::path& file : files) {
+        string stem = file.stem().string();
+        string ext  = file.stem().extension().string() +
+                     file.extension().string();  // get 'bar' from foo.bar and 'bar.bin' from foo.bar.bin
         if (fixupExts.contains(ext)) {
             LoadInfo loadInfo;
-            loadInfo.filePath                 = entry.path().string();
+            loadInfo.filePath                 = file.string();
             loadInfos[ext][loadInfo.filePath] = loadInfo;
         } else if (ext == ".vertspv") {
             assert(!metadata.vertShaders.contains(stem));
             metadata.vertShaders[stem]             = make_shared<vulk::cpp2::ShaderDef>();
             metadata.vertShaders[stem]->name_ref() = stem;
-            metadata.vertShaders[stem]->path_ref() = entry.path().string();
+            metadata.vertShaders[stem]->path_ref() = file.string();
         } else if (ext == ".geomspv") {
             assert(!metadata.geometryShaders.contains(stem));
             metadata.geometryShaders[stem]             = make_shared<vulk::cpp2::ShaderDef>();
             metadata.geometryShaders[stem]->name_ref() = stem;
-            metadata.geometryShaders[stem]->path_ref() = entry.path().string();
+            metadata.geometryShaders[stem]->path_ref() = file.string();
 
         } else if (ext == ".fragspv") {
             assert(!metadata.fragmentShaders.contains(stem));
             metadata.fragmentShaders[stem]             = make_shared<vulk::cpp2::ShaderDef>();
             metadata.fragmentShaders[stem]->name_ref() = stem;
-            metadata.fragmentShaders[stem]->path_ref() = entry.path().string();
+            metadata.fragmentShaders[stem]->path_ref() = file.string();
         } else if (ext == ".mtl") {
             assert(!metadata.materials.contains(stem));
-            auto material                      = make_shared<MaterialDef>(loadMaterialDef(entry.path().string()));
+            auto material                      = make_shared<MaterialDef>(loadMaterialDef(file, metadata.pack.get()));
             metadata.materials[material->name] = material;
         } else if (ext == ".obj") {
             if (metadata.meshes.contains(stem)) {
                 cerr << "Mesh already exists: " << stem << endl;
             }
             assert(!metadata.meshes.contains(stem));
-            ModelMeshDef mmd{entry.path().string()};
+            ModelMeshDef mmd{file.string()};
             metadata.meshes[stem] = make_shared<MeshDef>(stem, mmd);
+        } else if (ext == VulkMesh::COOKED_EXT) {
+            assert(!cookedMeshes.contains(stem));
+            cookedMeshes[stem] = file.string();
+        }
+    }
+
+    // cooked meshes replace the source model they were cooked from, which may not have been shipped
+    for (auto const& [name, cookedPath] : cookedMeshes) {
+        if (!metadata.meshes.contains(name)) {
+            metadata.meshes[name] = make_shared<MeshDef>(name, ModelMeshDef{cookedPath, cookedPath});
+        } else if (metadata.meshes[name]->type == vulk::cpp2::MeshDefType::Model) {
+            string srcPath        = metadata.meshes[name]->getModelMeshDef()->path;
+            metadata.meshes[name] = make_shared<MeshDef>(name, ModelMeshDef{srcPath, cookedPath});
         }
     }
 
@@ -352,14 +374,14 @@ void findAndProcessMetadata(const fs::path path, Metadata& metadata) {
 
     for (auto const& [name, loadInfo] : loadInfos[".pipeline"]) {
         auto pipeline = make_shared<PipelineDef>();
-        readDefFromFile(loadInfo.filePath, pipeline->def);
+        readDefFromAssets(metadata.pack.get(), loadInfo.filePath, pipeline->def);
         metadata.pipelines[pipeline->def.get_name()] = pipeline;
         pipeline->fixup(metadata.vertShaders, metadata.geometryShaders, metadata.fragmentShaders);
     }
 
     for (auto const& [name, loadInfo] : loadInfos[".model"]) {
         vulk::cpp2::ModelDef def;
-        readDefFromFile(loadInfo.filePath, def);
+        readDefFromAssets(metadata.pack.get(), loadInfo.filePath, def);
         auto modelDef = make_shared<ModelDef>(ModelDef::fromDef(def, metadata.meshes, metadata.materials));
         assert(!metadata.models.contains(modelDef->name));
         metadata.models[modelDef->name] = modelDef;
@@ -367,7 +389,7 @@ void findAndProcessMetadata(const fs::path path, Metadata& metadata) {
 
     for (auto const& [name, loadInfo] : loadInfos[".scene"]) {
         vulk::cpp2::SceneDef def;
-        readDefFromFile(loadInfo.filePath, def);
+        readDefFromAssets(metadata.pack.get(), loadInfo.filePath, def);
         auto sceneDef =
             make_shared<SceneDef>(SceneDef::fromDef(def, metadata.pipelines, metadata.models, metadata.meshes, metadata.materials)
             );
@@ -381,6 +403,27 @@ void findAndProcessMetadata(const fs::path path, Metadata& metadata) {
     }
 }
 
+void findAndProcessMetadata(const fs::path path, Metadata& metadata) {
+    logger->info("Finding and processing metadata in {}", std::filesystem::absolute(path).string());
+    assert(fs::exists(path) && fs::is_directory(path));
+    metadata.assetsDir = path;
+
+    std::vector<fs::path> files;
+    for (const auto& entry : fs::recursive_directory_iterator(path)) {
+        if (entry.is_regular_file()) {
+            files.push_back(entry.path());
+        }
+    }
+    processMetadata(files, metadata);
+}
+
+void findAndProcessMetadata(std::shared_ptr<VulkAssetPack const> pack, Metadata& metadata) {
+    logger->info("Processing metadata in asset pack {}", pack->packFile.string());
+    metadata.assetsDir = pack->mountDir;
+    metadata.pack      = pack;
+    processMetadata(pack->paths(), metadata);
+}
+
 std::filesystem::path getResourcesDir() {
     static vulk::cpp2::ResourceConfig config;
     static once_flag flag;
@@ -403,9 +446,14 @@ std::shared_ptr<const Metadata> getMetadata() {
     static std::shared_ptr<Metadata> metadata;
     static once_flag flag;
     call_once(flag, [&]() {
-        fs::path path = getResourcesDir();
-        metadata      = make_shared<Metadata>();
-        findAndProcessMetadata(path, *metadata);
+        fs::path path     = getResourcesDir();
+        fs::path packFile = VulkAssetPack::packFileFor(path);
+        metadata          = make_shared<Metadata>();
+        if (fs::exists(packFile)) {
+            findAndProcessMetadata(VulkAssetPack::open(packFile, path), *metadata);
+        } else {
+            findAndProcessMetadata(path, *metadata);
+        }
     });
 
     return metadata;
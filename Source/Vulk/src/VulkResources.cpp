@@ -1,7 +1,9 @@
 #include "Vulk/VulkResources.h"
 
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
+#include <numeric>
 #include <string>
 #include <unordered_map>
 
@@ -19,67 +21,81 @@ namespace fs = filesystem;
 
 DECLARE_FILE_LOGGER();
 
-VulkResources::VulkResources(Vulk& vk) : vk(vk), metadata(getMetadata()) {
+VulkResources::VulkResources(Vulk& vk)
+    : vk(vk), metadata(getMetadata()), textureCache(VulkTextureCache::cacheDirFor(metadata->assetsDir)) {
     textureSampler   = VulkSampler::createImageSampler(vk);
     shadowMapSampler = VulkSampler::createShadowSampler(vk);
 }
 
-VulkResources::VulkResources(Vulk& vk, std::shared_ptr<Metadata> metadata) : vk(vk), metadata(metadata) {
+VulkResources::VulkResources(Vulk& vk, std::shared_ptr<Metadata> metadata)
+    : vk(vk), metadata(metadata), textureCache(VulkTextureCache::cacheDirFor(metadata->assetsDir)) {
     textureSampler   = VulkSampler::createImageSampler(vk);
     shadowMapSampler = VulkSampler::createShadowSampler(vk);
 }
 
 std::shared_ptr<VulkResources> VulkResources::loadFromProject(Vulk& vk, std::filesystem::path projectFile) {
     std::shared_ptr<Metadata> metadata = std::make_shared<Metadata>();
-    findAndProcessMetadata(projectFile.parent_path() / "Assets", *metadata);
+    fs::path assetsDir                 = projectFile.parent_path() / "Assets";
+    fs::path packFile                  = VulkAssetPack::packFileFor(assetsDir);
+    if (fs::exists(packFile)) {
+        findAndProcessMetadata(VulkAssetPack::open(packFile, assetsDir), *metadata);
+    } else {
+        findAndProcessMetadata(assetsDir, *metadata);
+    }
     return std::make_shared<VulkResources>(vk, metadata);
 }
 
 std::shared_ptr<const VulkShaderModule> VulkResources::createShaderModule(ShaderType type, string const& name) const {
     fs::path subdir;
     char const* suffix;
-    std::unordered_map<std::string, std::shared_ptr<const VulkShaderModule>>* shaders_map;
     switch (type) {
         case Vert:
-            subdir      = "Vert";
-            suffix      = ".vertspv";
-            shaders_map = &vertShaders;
+            subdir = "Vert";
+            suffix = ".vertspv";
             break;
         case Geom:
-            subdir      = "Geom";
-            suffix      = ".geomspv";
-            shaders_map = &geomShaders;
+            subdir = "Geom";
+            suffix = ".geomspv";
             break;
         case Frag:
-            subdir      = "Frag";
-            suffix      = ".fragspv";
-            shaders_map = &fragShaders;
+            subdir = "Frag";
+            suffix = ".fragspv";
             break;
         default:
             VULK_THROW("Invalid shader type");
     };
 
-    fs::path path               = metadata->assetsDir / "Shaders" / subdir / (name + suffix);
-    auto shaderCode             = readFileIntoMem(path.string());
-    VkShaderModule shaderModule = vk.createShaderModule(shaderCode);
-    auto sm                     = make_shared<VulkShaderModule>(vk, shaderModule);
-    shaders_map->insert({name, sm});
-    return sm;
+    fs::path path = metadata->assetsDir / "Shaders" / subdir / (name + suffix);
+    VkShaderModule shaderModule;
+    if (metadata->pack && metadata->pack->contains(path)) {
+        shaderModule = vk.createShaderModule(metadata->pack->find(path));
+    } else {
+        shaderModule = vk.createShaderModule(readFileIntoMem(path.string()));
+    }
+    return make_shared<VulkShaderModule>(vk, shaderModule);
+}
+
+// shaders are quick to make, so they're made by whoever asks for them first. they're usually
+// asked for from the pipeline loads running on the workers anyway
+std::shared_ptr<const VulkShaderModule> VulkResources::getShader(ShaderType type, string const& name) const {
+    VulkAsyncCache<const VulkShaderModule>& shaders = type == Vert ? vertShaders : type == Geom ? geomShaders : fragShaders;
+    auto load                                       = [this, type, name]() { return createShaderModule(type, name); };
+    return shaders.getOrLoad(name, [&]() { return std::async(std::launch::deferred, load); }).get();
 }
 
-std::shared_ptr<const VulkModel> VulkResources::getModel(ModelDef const& modelDef, PipelineDef const& pipelineDef) {
+VulkFuture<const VulkModel> VulkResources::getModelAsync(ModelDef const& modelDef, PipelineDef const& pipelineDef) {
     string key = modelDef.name + ":" + pipelineDef.def.name().value();
-    if (pipelineModels.contains(key)) {
-        return pipelineModels.at(key);
-    }
-    shared_ptr<const VulkMaterialTextures> textures = getMaterialTextures(modelDef.material->name);
-    auto p                                          = make_shared<VulkModel>(vk,
-                                    getMesh(*modelDef.mesh),
-                                    textures,
-                                    getMaterial(modelDef.material->name),
-                                    pipelineDef.def.get_vertInputs());
-    pipelineModels[key]                             = p;
-    return p;
+    return pipelineModels.getOrLoad(key, [&]() {
+        // start what the model is made from first, the model's task waits for them
+        VulkFuture<const VulkMesh> mesh                                     = getMeshAsync(*modelDef.mesh);
+        VulkFuture<const VulkMaterialTextures> textures                     = getMaterialTexturesAsync(modelDef.material->name);
+        VulkFuture<const VulkUniformBuffer<VulkMaterialConstants>> material = getMaterialAsync(modelDef.material->name);
+        std::vector<vulk::cpp2::VulkShaderLocation> inputs                  = pipelineDef.def.get_vertInputs();
+        vulk::cpp2::VulkVertexLayoutType layout                             = pipelineDef.def.get_vertexLayout();
+        return workers.submit([this, mesh, textures, material, inputs, layout]() -> shared_ptr<const VulkModel> {
+            return make_shared<VulkModel>(vk, mesh.get(), textures.get(), material.get(), inputs, layout);
+        });
+    });
 }
 
 // these map to the same values
@@ -104,7 +120,12 @@ std::shared_ptr<const VulkDescriptorSetLayout> VulkResources::buildDescriptorSet
     for (auto& [stage, bindings] : dsdef.get_uniformBuffers()) {
         for (auto& binding : bindings) {
             vulk::cpp2::VulkShaderUBOBinding const& bindingRef = binding;
-            dslb.addUniformBuffer(stage, bindingRef);
+            // per actor UBOs come out of the scene's arena, see createDSInfoFromPipeline
+            if (bindingRef == vulk::cpp2::VulkShaderUBOBinding::ModelXform) {
+                dslb.addDynamicUniformBuffer(stage, bindingRef);
+            } else {
+                dslb.addUniformBuffer(stage, bindingRef);
+            }
         }
     }
     for (auto& [stage, bindings] : dsdef.get_storageBuffers()) {
@@ -126,13 +147,38 @@ std::shared_ptr<const VulkDescriptorSetLayout> VulkResources::buildDescriptorSet
     return dslb.build();
 }
 
-std::shared_ptr<const VulkPipeline> VulkResources::loadPipeline(VkRenderPass renderPass,
+VulkFuture<const VulkPipeline> VulkResources::loadPipelineAsync(VkRenderPass renderPass,
                                                                 VkExtent2D extent,
                                                                 std::string const& name) {
-    if (pipelines.contains(name)) {
-        return pipelines[name];
+    return pipelines.getOrLoad(name, [&]() {
+        return workers.submit([this, renderPass, extent, name]() { return createPipeline(renderPass, extent, name); });
+    });
+}
+
+std::vector<VulkFuture<const VulkPipeline>> VulkResources::loadPipelinesAsync(std::vector<VulkPipelineLoad> const& loads) {
+    std::vector<VulkFuture<const VulkPipeline>> futures;
+    futures.reserve(loads.size());
+    for (VulkPipelineLoad const& load : loads) {
+        futures.push_back(loadPipelineAsync(load.renderPass, load.extent, load.name));
     }
+    return futures;
+}
 
+std::vector<std::shared_ptr<const VulkPipeline>> VulkResources::loadPipelines(std::vector<VulkPipelineLoad> const& loads) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::shared_ptr<const VulkPipeline>> loaded;
+    loaded.reserve(loads.size());
+    for (VulkFuture<const VulkPipeline>& future : loadPipelinesAsync(loads)) {
+        loaded.push_back(future.get());
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    logger->info("Loaded {} pipelines in {}ms", loaded.size(), elapsed.count());
+    return loaded;
+}
+
+std::shared_ptr<const VulkPipeline> VulkResources::createPipeline(VkRenderPass renderPass,
+                                                                  VkExtent2D extent,
+                                                                  std::string const& name) {
     // make the pipeline itself
     std::shared_ptr<const PipelineDef> def = metadata->pipelines.at(name);
     VulkPipelineBuilder pb(vk, def);
@@ -174,15 +220,14 @@ std::shared_ptr<const VulkPipeline> VulkResources::loadPipeline(VkRenderPass ren
     if (def->geomShader)
         pb.addGeometryShaderStage(getGeometryShader(def->geomShader->get_name()));
 
+    pb.setVertexLayout(def->def.get_vertexLayout());
     for (auto input : def->def.get_vertInputs()) {
         pb.addVertexInput(input);
     }
 
     std::shared_ptr<const VulkDescriptorSetLayout> descriptorSetLayout = buildDescriptorSetLayoutFromPipeline(name);
-    // build, save and return the pipeline
-    auto p          = pb.build(renderPass, descriptorSetLayout);
-    pipelines[name] = p;
-    return p;
+    // build and return the pipeline
+    return pb.build(renderPass, descriptorSetLayout);
 }
 
 /**
@@ -218,9 +263,10 @@ shared_ptr<const VulkDescriptorSetInfo> VulkResources::createDSInfoFromPipeline(
                     dsBuilder.addFrameUBOs(scene->sceneUBOs.eyePos, stage, binding);
                     break;
                 case vulk::cpp2::VulkShaderUBOBinding::ModelXform:
-                    if (!model->xformUBOs)
-                        model->xformUBOs = make_shared<VulkFrameUBOs<glm::mat4>>(vk, actorDef->xform);
-                    dsBuilder.addFrameUBOs(*model->xformUBOs, stage, binding);
+                    if (!model->xformUBO)
+                        model->xformUBO = make_shared<VulkFrameUBOSlot<glm::mat4>>(
+                            scene->sceneUBOs.actorUBOs->allocate(actorDef->xform));
+                    dsBuilder.addDynamicFrameUBO(*model->xformUBO, stage, binding);
                     break;
                 case vulk::cpp2::VulkShaderUBOBinding::DebugNormals:
                     if (scene->debugNormalsUBO == nullptr) {
@@ -259,19 +305,20 @@ shared_ptr<const VulkDescriptorSetInfo> VulkResources::createDSInfoFromPipeline(
             static_assert((int)TEnumTraits<::vulk::cpp2::VulkShaderUBOBinding>::max() == 27);
         }
     }
-    // for (auto &[stage, ssbos] : dsDef.storageBuffers)
-    // {
-    //     for (vulk::cpp2::VulkShaderSSBOBinding binding : ssbos)
-    //     {
-    //         switch (binding)
-    //         {
-    //         case vulk::cpp2::VulkShaderSSBOBinding::type_MaxBindingID:
-    //         default:
-    //             VULK_THROW("Invalid SSBO binding");
-    //         }
-    //     }
-    // }
-    static_assert((int)vulk::cpp2::VulkShaderSSBOBinding::MaxBindingID == 0);
+    for (auto& [stageFlags, ssbos] : dsDef.get_storageBuffers()) {
+        VkShaderStageFlagBits stage = (VkShaderStageFlagBits)stageFlags;
+        for (vulk::cpp2::VulkShaderSSBOBinding binding : ssbos) {
+            switch (binding) {
+                case vulk::cpp2::VulkShaderSSBOBinding::Instances:
+                    VULK_ASSERT(scene && scene->instances, "{} needs a scene's instances", pipeline.def->def.get_name());
+                    dsBuilder.addFrameSSBOs(*scene->instances, stage, binding);
+                    break;
+                default:
+                    VULK_THROW("Invalid SSBO binding");
+            }
+        }
+    }
+    static_assert((int)TEnumTraits<::vulk::cpp2::VulkShaderSSBOBinding>::max() == 28);
     for (auto& [stage, samplers] : dsDef.get_imageSamplers()) {
         for (vulk::cpp2::VulkShaderTextureBinding binding : samplers) {
             switch (binding) {
@@ -324,89 +371,169 @@ shared_ptr<const VulkDescriptorSetInfo> VulkResources::createDSInfoFromPipeline(
     return dsBuilder.build();
 }
 
-// TODO: hypothetically the same descriptor set could get used for multiple actors
-// we'll get to that eventually, maybe, it's not really a big deal as DSs are cheap
-// or so I've been told.
+// actors whose sets are bound to the same things share them, see VulkDescriptorAllocator. with the transforms being
+// dynamic offsets that's most of the shadow map and pick actors
 shared_ptr<const VulkActor> VulkResources::createActorFromPipeline(ActorDef const& actorDef,
                                                                    shared_ptr<const VulkPipeline> pipeline,
                                                                    VulkScene const* scene,
                                                                    vulk::VulkDeferredRenderpass const* deferredRenderpass) {
     logger->info("Creating actor from def {}, pipeline def {}", actorDef.def.get_name(), pipeline->def->def.get_name());
-    shared_ptr<const VulkModel> model = getModel(*actorDef.model, *pipeline->def);
+    shared_ptr<const VulkModel> model = getModelAsync(*actorDef.model, *pipeline->def).get();
     shared_ptr<const VulkDescriptorSetInfo> info =
         createDSInfoFromPipeline(*pipeline, scene, model.get(), &actorDef, deferredRenderpass);
-    return make_shared<VulkActor>(vk, model, info, pipeline);
+    uint32_t instance = scene ? scene->actorInstances.at(&actorDef) : 0;
+    return make_shared<VulkActor>(vk, model, info, pipeline, instance);
 }
 
-std::shared_ptr<VulkScene> VulkResources::loadScene(
-    std::string name,
-    std::array<std::shared_ptr<VulkDepthView>, MAX_FRAMES_IN_FLIGHT> shadowMapViews) const {
-    if (scenes.contains(name)) {
-        logger->info("Returning cached scene {}", name);
-        return scenes[name];
-    }
-    logger->info("Loading scene {}", name);
-    SceneDef& sceneDef          = *metadata->scenes.at(name);
-    shared_ptr<VulkScene> scene = make_shared<VulkScene>(vk, metadata->scenes.at(name));
-
-    scene->shadowMapViews = shadowMapViews;
-    scene->camera         = sceneDef.camera;
-    VULK_ASSERT(sceneDef.pointLights.size() <= (int)vulk::cpp2::VulkLights::NumLights);
-    for (size_t i = 0; i < sceneDef.pointLights.size(); i++) {
-        scene->sceneUBOs.lightsUBO.mappedUBO->lights[i] = *sceneDef.pointLights[i];
-    }
+VulkFuture<VulkScene> VulkResources::loadSceneAsync(
+    std::string const& name,
+    std::array<std::shared_ptr<VulkDepthView>, MAX_FRAMES_IN_FLIGHT> shadowMapViews) {
+    return scenes.getOrLoad(name, [&]() {
+        logger->info("Loading scene {}", name);
+        shared_ptr<SceneDef> sceneDef = metadata->scenes.at(name);
+
+        // get every actor's mesh and textures loading at once
+        std::vector<VulkFuture<const VulkMesh>> meshFutures;
+        std::vector<VulkFuture<const VulkMaterialTextures>> textureFutures;
+        for (auto& actorDef : sceneDef->actors) {
+            meshFutures.push_back(getMeshAsync(*actorDef->model->mesh));
+            textureFutures.push_back(getMaterialTexturesAsync(actorDef->model->material->name));
+        }
 
-    // for (auto& actorDef : sceneDef.actors) {
-    //     auto pipeline = loadPipeline(renderPass, vk.swapChainExtent, actorDef->pipeline.def.get_name());
-    //     scene->actors.push_back(createActorFromPipeline(*actorDef, pipeline, scene));
-    // }
-    return scenes[name] = scene;
+        // the scene itself is cheap, it's made by whoever waits for it
+        return std::async(std::launch::deferred, [this, sceneDef, shadowMapViews, meshFutures, textureFutures]() {
+            for (auto& mesh : meshFutures) {
+                mesh.get();
+            }
+            for (auto& textures : textureFutures) {
+                textures.get();
+            }
+
+            shared_ptr<VulkScene> scene = make_shared<VulkScene>(vk, sceneDef);
+            scene->shadowMapViews       = shadowMapViews;
+            scene->camera               = sceneDef->camera;
+            VULK_ASSERT(sceneDef->pointLights.size() <= (int)vulk::cpp2::VulkLights::NumLights);
+            for (size_t i = 0; i < sceneDef->pointLights.size(); i++) {
+                scene->sceneUBOs.lightsUBO.mappedUBO->lights[i] = *sceneDef->pointLights[i];
+            }
+
+            // actors with the same model get consecutive instances so they can be batched, see VulkActorBatch
+            std::vector<uint32_t> order(sceneDef->actors.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&sceneDef](uint32_t a, uint32_t b) {
+                return sceneDef->actors[a]->model->name < sceneDef->actors[b]->model->name;
+            });
+            scene->instances = make_unique<VulkFrameSSBOs<VulkInstance>>(vk, (uint32_t)order.size());
+            for (uint32_t instance = 0; instance < order.size(); ++instance) {
+                ActorDef const& actorDef = *sceneDef->actors[order[instance]];
+                for (uint32_t frame = 0; frame < MAX_FRAMES_IN_FLIGHT; ++frame) {
+                    // pick ids are the actor's index in the scene, plus one as 0 is nothing
+                    scene->instances->ptrs[frame][instance] = {actorDef.xform, order[instance] + 1};
+                }
+                scene->actorInstances[&actorDef] = instance;
+            }
+            logger->info("Loaded scene {}", sceneDef->def.get_name());
+            return scene;
+        });
+    });
 }
 
-shared_ptr<const VulkUniformBuffer<VulkMaterialConstants>> VulkResources::getMaterial(string const& name) {
-    if (!materialUBOs.contains(name)) {
-        materialUBOs[name] =
-            make_shared<VulkUniformBuffer<VulkMaterialConstants>>(vk, metadata->materials.at(name)->toVulkMaterialConstants());
-    }
-    return materialUBOs[name];
+VulkFuture<const VulkUniformBuffer<VulkMaterialConstants>> VulkResources::getMaterialAsync(string const& name) {
+    return materialUBOs.getOrLoad(name, [&]() {
+        return std::async(std::launch::deferred, [this, name]() -> shared_ptr<const VulkUniformBuffer<VulkMaterialConstants>> {
+            return make_shared<VulkUniformBuffer<VulkMaterialConstants>>(vk,
+                                                                         metadata->materials.at(name)->toVulkMaterialConstants());
+        });
+    });
 }
 
-shared_ptr<const VulkMesh> VulkResources::getMesh(MeshDef& meshDef) {
-    string name = meshDef.name;
-    if (meshes.contains(name)) {
-        return meshes[name];
-    }
-    shared_ptr<const VulkMesh> m;
-    switch (meshDef.type) {
-        case vulk::cpp2::MeshDefType::Model:
-            m = make_shared<VulkMesh>(VulkMesh::loadFromPath(meshDef.getModelMeshDef()->path, name));
-            break;
-        case vulk::cpp2::MeshDefType::Mesh: {
-            m = meshDef.getMesh();
-        } break;
-        default:
-            VULK_THROW("Invalid mesh type");
+VulkFuture<const VulkMesh> VulkResources::getMeshAsync(MeshDef& meshDef) {
+    return meshes.getOrLoad(meshDef.name, [&]() -> std::future<shared_ptr<const VulkMesh>> {
+        switch (meshDef.type) {
+            case vulk::cpp2::MeshDefType::Model: {
+                auto modelMeshDef = meshDef.getModelMeshDef();
+                string path       = modelMeshDef->cookedPath.empty() ? modelMeshDef->path : modelMeshDef->cookedPath;
+                return workers.submit([this, path, name = meshDef.name]() -> shared_ptr<const VulkMesh> {
+                    return make_shared<VulkMesh>(VulkMesh::loadFromAssets(metadata->pack.get(), path, name));
+                });
+            }
+            case vulk::cpp2::MeshDefType::Mesh: {
+                std::promise<shared_ptr<const VulkMesh>> loaded;
+                loaded.set_value(meshDef.getMesh());
+                return loaded.get_future();
+            }
+            default:
+                VULK_THROW("Invalid mesh type");
+        }
+    });
+}
+
+VulkFuture<VulkImageView> VulkResources::getTextureAsync(string const& path, bool isUNORM) {
+    return textures.getOrLoad(path + (isUNORM ? "|unorm" : "|srgb"), [&]() {
+        return workers.submit([this, path, isUNORM]() {
+            // BuildTool cooks material textures next to the images they're cooked from. otherwise the
+            // mips are made on the GPU
+            VulkAssetPack const* pack = metadata->pack.get();
+            fs::path cookedPath       = VulkCookedTexture::cookedPathFor(path);
+            if (vk.bcTextureCompression && ((pack && pack->contains(cookedPath)) || fs::exists(cookedPath))) {
+                return make_shared<VulkImageView>(vk, VulkCookedTexture::loadFromAssets(pack, cookedPath));
+            }
+            return make_shared<VulkImageView>(vk, textureCache.load(pack, path), isUNORM, true);
+        });
+    });
+}
+
+VulkFuture<VulkImageView> VulkResources::getCubemapAsync(std::array<std::string, 6> const& cubemapImgs) {
+    string key = "cubemap";
+    for (string const& img : cubemapImgs) {
+        key += "|" + img;
     }
-    meshes[name] = m;
-    return m;
+    return textures.getOrLoad(key, [&]() {
+        // decode the faces in parallel, then put them together
+        std::array<std::future<VulkDecodedImage>, 6> faceFutures;
+        for (int i = 0; i < 6; ++i) {
+            faceFutures[i] =
+                workers.submit([this, img = cubemapImgs[i]]() { return textureCache.load(metadata->pack.get(), img); });
+        }
+        return workers.submit([this, faceFutures = std::move(faceFutures)]() mutable {
+            std::array<VulkDecodedImage, 6> faces;
+            for (int i = 0; i < 6; ++i) {
+                faces[i] = faceFutures[i].get();
+            }
+            return VulkImageView::createCubemapView(vk, faces);
+        });
+    });
 }
 
-shared_ptr<const VulkMaterialTextures> VulkResources::getMaterialTextures(string const& name) {
-    if (!materialTextures.contains(name)) {
-        MaterialDef const& def  = *metadata->materials.at(name);
-        auto p                  = make_shared<VulkMaterialTextures>();
-        p->diffuseView          = !def.mapKd.empty() ? make_unique<VulkImageView>(vk, def.mapKd, false) : nullptr;
-        p->normalView           = !def.mapNormal.empty() ? make_unique<VulkImageView>(vk, def.mapNormal, true) : nullptr;
-        p->ambientOcclusionView = !def.mapKa.empty() ? make_unique<VulkImageView>(vk, def.mapKa, true) : nullptr;
-        p->displacementView     = !def.disp.empty() ? make_unique<VulkImageView>(vk, def.disp, true) : nullptr;
-        p->metallicView         = !def.mapPm.empty() ? make_unique<VulkImageView>(vk, def.mapPm, true) : nullptr;
-        p->roughnessView        = !def.mapPr.empty() ? make_unique<VulkImageView>(vk, def.mapPr, true) : nullptr;
-        p->cubemapView          = !def.cubemapImgs[0].empty() ? VulkImageView::createCubemapView(vk, def.cubemapImgs) : nullptr;
-
-        materialTextures[name] = p;
+// each texture loads on a worker of its own, the material just gathers them up
+VulkFuture<const VulkMaterialTextures> VulkResources::getMaterialTexturesAsync(string const& name) {
+    return materialTextures.getOrLoad(name, [&]() {
+        MaterialDef const& def = *metadata->materials.at(name);
+        auto texture           = [this](string const& path, bool isUNORM) {
+            return !path.empty() ? getTextureAsync(path, isUNORM) : VulkFuture<VulkImageView>();
+        };
+        VulkFuture<VulkImageView> diffuse          = texture(def.mapKd, false);
+        VulkFuture<VulkImageView> normal           = texture(def.mapNormal, true);
+        VulkFuture<VulkImageView> ambientOcclusion = texture(def.mapKa, true);
+        VulkFuture<VulkImageView> displacement     = texture(def.disp, true);
+        VulkFuture<VulkImageView> metallic         = texture(def.mapPm, true);
+        VulkFuture<VulkImageView> roughness        = texture(def.mapPr, true);
+        VulkFuture<VulkImageView> cubemap =
+            !def.cubemapImgs[0].empty() ? getCubemapAsync(def.cubemapImgs) : VulkFuture<VulkImageView>();
         static_assert(TEnumTraits<::vulk::cpp2::VulkShaderTextureBinding>::max() ==
                       vulk::cpp2::VulkShaderTextureBinding::CubemapSampler);
-    }
 
-    return materialTextures[name];
+        return std::async(std::launch::deferred, [=]() -> shared_ptr<const VulkMaterialTextures> {
+            auto get                = [](VulkFuture<VulkImageView> const& f) { return f.valid() ? f.get() : nullptr; };
+            auto p                  = make_shared<VulkMaterialTextures>();
+            p->diffuseView          = get(diffuse);
+            p->normalView           = get(normal);
+            p->ambientOcclusionView = get(ambientOcclusion);
+            p->displacementView     = get(displacement);
+            p->metallicView         = get(metallic);
+            p->roughnessView        = get(roughness);
+            p->cubemapView          = get(cubemap);
+            return p;
+        });
+    });
 }
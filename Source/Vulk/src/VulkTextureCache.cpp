@@ -0,0 +1,132 @@
+#include "Vulk/VulkTextureCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#include "Vulk/VulkAssetPack.h"
+#include "Vulk/VulkHash.h"
+#include "Vulk/VulkLogger.h"
+#include "Vulk/VulkUtil.h"
+
+namespace fs = std::filesystem;
+
+DECLARE_FILE_LOGGER();
+
+VulkTextureCache::VulkTextureCache(fs::path cacheDir) : cacheDir(std::move(cacheDir)) {
+    // made up front, fs::create_directories isn't safe to race
+    std::error_code ec;
+    if (!this->cacheDir.empty() && !fs::create_directories(this->cacheDir, ec) && ec) {
+        logger->warn("Not caching decoded textures, couldn't make {}: {}", this->cacheDir.string(), ec.message());
+        writable = false;
+    }
+}
+
+fs::path VulkTextureCache::cacheDirFor(fs::path assetsDir) {
+    fs::path dir = assetsDir.lexically_normal();
+    if (!dir.has_filename()) {
+        dir = dir.parent_path();
+    }
+    dir += ".texcache";
+    return dir;
+}
+
+VulkDecodedImage VulkTextureCache::decodeUncached(std::span<char const> encoded, std::string const& name) {
+    int width, height, channels;
+    stbi_uc* pixels = stbi_load_from_memory(
+        (stbi_uc const*)encoded.data(), (int)encoded.size(), &width, &height, &channels, STBI_rgb_alpha);
+    VULK_ASSERT(pixels, "Failed to load {}: {}", name, stbi_failure_reason());
+    VulkDecodedImage image;
+    image.width  = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.pixels.assign(pixels, pixels + (size_t)width * height * 4);
+    stbi_image_free(pixels);
+    return image;
+}
+
+VulkDecodedImage VulkTextureCache::decode(std::span<char const> encoded, std::string const& name) {
+    if (cacheDir.empty()) {
+        return decodeUncached(encoded, name);
+    }
+    uint64_t hash = VulkHasher().addValue(VulkDecodedImageHeader::VERSION).add(encoded.data(), encoded.size()).get();
+    fs::path path = cacheDir / (VulkHasher::toString(hash) + ".rgba");
+
+    VulkDecodedImage image;
+    if (readEntry(path, image)) {
+        hits++;
+        return image;
+    }
+    misses++;
+    image = decodeUncached(encoded, name);
+    if (writable) {
+        writeEntry(path, image);
+    }
+    return image;
+}
+
+VulkDecodedImage VulkTextureCache::load(VulkAssetPack const* pack, fs::path const& path) {
+    if (pack && pack->contains(path)) {
+        return decode(pack->find(path), path.string());
+    }
+    std::vector<char> encoded = readFileIntoMem(path.string());
+    return decode(encoded, path.string());
+}
+
+bool VulkTextureCache::readEntry(fs::path const& path, VulkDecodedImage& image) const {
+    std::ifstream ifs(path, std::ios::binary);
+    if (!ifs.is_open()) {
+        return false;
+    }
+    VulkDecodedImageHeader header;
+    if (!ifs.read((char*)&header, sizeof(header)) ||
+        memcmp(header.magic, VulkDecodedImageHeader::MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != VulkDecodedImageHeader::VERSION) {
+        logger->info("Ignoring stale texture cache entry {}", path.string());
+        return false;
+    }
+    // check the header against the file before allocating, a corrupt one could ask for anything
+    uint64_t pixelBytes = (uint64_t)header.width * header.height * 4;
+    std::error_code ec;
+    uintmax_t fileSize = fs::file_size(path, ec);
+    if (ec || fileSize < sizeof(header) || fileSize - sizeof(header) != pixelBytes) {
+        logger->warn("Ignoring texture cache entry {}, its size doesn't match its {}x{} header", path.string(),
+                     header.width, header.height);
+        return false;
+    }
+    image.width  = header.width;
+    image.height = header.height;
+    image.pixels.resize((size_t)pixelBytes);
+    if (!ifs.read((char*)image.pixels.data(), (std::streamsize)image.pixels.size())) {
+        logger->warn("Ignoring truncated texture cache entry {}", path.string());
+        return false;
+    }
+    return true;
+}
+
+void VulkTextureCache::writeEntry(fs::path const& path, VulkDecodedImage const& image) {
+    VulkDecodedImageHeader header;
+    memcpy(header.magic, VulkDecodedImageHeader::MAGIC, sizeof(header.magic));
+    header.version = VulkDecodedImageHeader::VERSION;
+    header.width   = image.width;
+    header.height  = image.height;
+
+    // named per thread so threads writing the same entry don't trip over each other
+    fs::path tmpPath = path;
+    tmpPath += fmt::format(".{}.tmp", std::hash<std::thread::id>()(std::this_thread::get_id()));
+    try {
+        {
+            std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+            VULK_ASSERT(ofs.is_open(), "Could not open {} for writing", tmpPath.string());
+            ofs.write((char const*)&header, sizeof(header));
+            ofs.write((char const*)image.pixels.data(), image.pixels.size());
+            VULK_ASSERT(ofs.good(), "Failed writing {}", tmpPath.string());
+        }
+        fs::rename(tmpPath, path);
+    } catch (std::exception& e) {
+        logger->warn("Not caching decoded textures in {}: {}", cacheDir.string(), e.what());
+        writable = false;
+        std::error_code ec;
+        fs::remove(tmpPath, ec);
+    }
+}
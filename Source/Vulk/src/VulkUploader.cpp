@@ -0,0 +1,562 @@
+#include "Vulk/VulkUploader.h"
+
+#include <algorithm>
+
+#include "Vulk/Vulk.h"
+
+namespace {
+VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VkCommandPool createCommandPool(VkDevice device, uint32_t queueFamily) {
+    VkCommandPoolCreateInfo poolInfo{};
+    poolInfo.sType            = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    poolInfo.flags            = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    poolInfo.queueFamilyIndex = queueFamily;
+    VkCommandPool pool;
+    VK_CALL(vkCreateCommandPool(device, &poolInfo, nullptr, &pool));
+    return pool;
+}
+
+VkSemaphore createTimeline(VkDevice device) {
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType         = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue  = 0;
+
+    VkSemaphoreCreateInfo semaphoreInfo{};
+    semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphoreInfo.pNext = &typeInfo;
+    VkSemaphore semaphore;
+    VK_CALL(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &semaphore));
+    return semaphore;
+}
+
+void waitTimeline(VkDevice device, VkSemaphore timeline, uint64_t value) {
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType          = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores    = &timeline;
+    waitInfo.pValues        = &value;
+    VK_CALL(vkWaitSemaphores(device, &waitInfo, UINT64_MAX));
+}
+}  // namespace
+
+VulkUploader::VulkUploader(Vulk& vk,
+                           uint32_t transferFamily,
+                           VkQueue transferQueue,
+                           uint32_t graphicsFamily,
+                           VkQueue graphicsQueue,
+                           VkDeviceSize ringSize)
+    : vk(vk),
+      transferFamily(transferFamily),
+      transferQueue(transferQueue),
+      graphicsFamily(graphicsFamily),
+      graphicsQueue(graphicsQueue),
+      ringSize(ringSize) {
+    VULK_ASSERT(ringSize % ALIGNMENT == 0, "VulkUploader: ring size {} isn't a multiple of {}", ringSize, ALIGNMENT);
+    transferPool     = createCommandPool(vk.device, transferFamily);
+    graphicsPool     = usesTransferQueue() ? createCommandPool(vk.device, graphicsFamily) : VK_NULL_HANDLE;
+    transferTimeline = createTimeline(vk.device);
+    acquireTimeline  = createTimeline(vk.device);
+
+    vk.createBuffer(ringSize,
+                    VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                    VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                    ring,
+                    ringAlloc);
+}
+
+VulkUploader::~VulkUploader() {
+    flush();
+    vkDestroySemaphore(vk.device, transferTimeline, nullptr);
+    vkDestroySemaphore(vk.device, acquireTimeline, nullptr);
+    // destroying the pools frees their command buffers
+    vkDestroyCommandPool(vk.device, transferPool, nullptr);
+    if (graphicsPool != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(vk.device, graphicsPool, nullptr);
+    }
+    vk.destroyBuffer(ring, ringAlloc);
+}
+
+void VulkUploader::uploadToBuffer(VkBuffer dst, VkDeviceSize dstOffset, void const* data, VkDeviceSize size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [src, srcOffset] = stage(std::span<void const* const>(&data, 1), size);
+
+    VkBufferCopy copyRegion{};
+    copyRegion.srcOffset = srcOffset;
+    copyRegion.dstOffset = dstOffset;
+    copyRegion.size      = size;
+    vkCmdCopyBuffer(begin(), src, dst, 1, &copyRegion);
+
+    if (usesTransferQueue()) {
+        VkBufferMemoryBarrier acquire{};
+        acquire.sType               = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        acquire.srcAccessMask       = 0;
+        acquire.dstAccessMask       = VK_ACCESS_MEMORY_READ_BIT;
+        acquire.srcQueueFamilyIndex = transferFamily;
+        acquire.dstQueueFamilyIndex = graphicsFamily;
+        acquire.buffer              = dst;
+        acquire.offset              = dstOffset;
+        acquire.size                = size;
+        current.bufferAcquires.push_back(acquire);
+    }
+}
+
+void VulkUploader::uploadToImage(VkImage dst, VkExtent2D extent, VkDeviceSize layerSize, std::span<void const* const> layers) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [src, srcOffset] = stage(layers, layerSize);
+
+    // layers are consecutive in the staging memory, so one region covers them all. it's always
+    // the whole image, so the transfer queue's minImageTransferGranularity doesn't matter
+    VkBufferImageCopy region{};
+    region.bufferOffset                    = srcOffset;
+    region.bufferRowLength                 = 0;
+    region.bufferImageHeight               = 0;
+    region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel       = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount     = static_cast<uint32_t>(layers.size());
+    region.imageOffset                     = {0, 0, 0};
+    region.imageExtent                     = {extent.width, extent.height, 1};
+    copyToImage(src, dst, std::span(&region, 1), 1, region.imageSubresource.layerCount);
+}
+
+void VulkUploader::uploadMipsToImage(VkImage dst, VkExtent2D extent, std::span<VkDeviceSize const> mipSizes, void const* data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    VkDeviceSize size = 0;
+    for (VkDeviceSize mipSize : mipSizes) {
+        size += mipSize;
+    }
+    auto [src, srcOffset] = stage(std::span<void const* const>(&data, 1), size);
+
+    // a region per mip, each the whole level
+    std::vector<VkBufferImageCopy> regions(mipSizes.size());
+    VkDeviceSize offset = srcOffset;
+    for (uint32_t level = 0; level < regions.size(); ++level) {
+        VkBufferImageCopy& region              = regions[level];
+        region.bufferOffset                    = offset;
+        region.bufferRowLength                 = 0;
+        region.bufferImageHeight               = 0;
+        region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel       = level;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount     = 1;
+        region.imageOffset                     = {0, 0, 0};
+        region.imageExtent                     = {std::max(1u, extent.width >> level), std::max(1u, extent.height >> level), 1};
+        offset += mipSizes[level];
+    }
+    copyToImage(src, dst, regions, static_cast<uint32_t>(regions.size()), 1);
+}
+
+void VulkUploader::uploadAndGenerateMips(VkImage dst,
+                                         VkExtent2D extent,
+                                         uint32_t mipLevels,
+                                         void const* data,
+                                         VkDeviceSize size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [src, srcOffset] = stage(std::span<void const* const>(&data, 1), size);
+    VkCommandBuffer cmd   = begin();
+
+    vk.transitionImageLayout(cmd, dst, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, 1);
+    VkBufferImageCopy region{};
+    region.bufferOffset                    = srcOffset;
+    region.bufferRowLength                 = 0;
+    region.bufferImageHeight               = 0;
+    region.imageSubresource.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.mipLevel       = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount     = 1;
+    region.imageOffset                     = {0, 0, 0};
+    region.imageExtent                     = {extent.width, extent.height, 1};
+    vkCmdCopyBufferToImage(cmd, src, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+    MipGeneration gen = {dst, extent, mipLevels};
+    if (!usesTransferQueue()) {
+        recordMipBlits(cmd, gen);
+        return;
+    }
+    // transfer queues can't blit. hand mip 0 over as it is, the other levels haven't been written
+    // so they don't need an ownership transfer
+    VkImageMemoryBarrier acquire{};
+    acquire.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    acquire.srcAccessMask                   = 0;
+    acquire.dstAccessMask                   = VK_ACCESS_TRANSFER_READ_BIT;
+    acquire.oldLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    acquire.newLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    acquire.srcQueueFamilyIndex             = transferFamily;
+    acquire.dstQueueFamilyIndex             = graphicsFamily;
+    acquire.image                           = dst;
+    acquire.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    acquire.subresourceRange.baseMipLevel   = 0;
+    acquire.subresourceRange.levelCount     = 1;
+    acquire.subresourceRange.baseArrayLayer = 0;
+    acquire.subresourceRange.layerCount     = 1;
+    current.imageAcquires.push_back(acquire);
+    current.mipGenerations.push_back(gen);
+}
+
+void VulkUploader::recordMipBlits(VkCommandBuffer cmd, MipGeneration const& gen) {
+    auto barrier = [&](uint32_t baseLevel,
+                       uint32_t levelCount,
+                       VkImageLayout oldLayout,
+                       VkImageLayout newLayout,
+                       VkAccessFlags srcAccess,
+                       VkAccessFlags dstAccess,
+                       VkPipelineStageFlags dstStage) {
+        VkImageMemoryBarrier b{};
+        b.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        b.srcAccessMask                   = srcAccess;
+        b.dstAccessMask                   = dstAccess;
+        b.oldLayout                       = oldLayout;
+        b.newLayout                       = newLayout;
+        b.srcQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        b.dstQueueFamilyIndex             = VK_QUEUE_FAMILY_IGNORED;
+        b.image                           = gen.image;
+        b.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+        b.subresourceRange.baseMipLevel   = baseLevel;
+        b.subresourceRange.levelCount     = levelCount;
+        b.subresourceRange.baseArrayLayer = 0;
+        b.subresourceRange.layerCount     = 1;
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, dstStage, 0, 0, nullptr, 0, nullptr, 1, &b);
+    };
+    auto mipOffset = [&](uint32_t level) {
+        int32_t width  = (int32_t)std::max(1u, gen.extent.width >> level);
+        int32_t height = (int32_t)std::max(1u, gen.extent.height >> level);
+        return VkOffset3D{width, height, 1};
+    };
+
+    if (gen.mipLevels > 1) {
+        barrier(1,
+                gen.mipLevels - 1,
+                VK_IMAGE_LAYOUT_UNDEFINED,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                0,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT);
+    }
+    // each level is written, then becomes the source for the next one down
+    for (uint32_t level = 0; level < gen.mipLevels; ++level) {
+        barrier(level,
+                1,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_ACCESS_TRANSFER_READ_BIT,
+                VK_PIPELINE_STAGE_TRANSFER_BIT);
+        if (level + 1 == gen.mipLevels) {
+            break;
+        }
+        VkImageBlit blit{};
+        blit.srcSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level, 0, 1};
+        blit.srcOffsets[1]  = mipOffset(level);
+        blit.dstSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, level + 1, 0, 1};
+        blit.dstOffsets[1]  = mipOffset(level + 1);
+        vkCmdBlitImage(cmd,
+                       gen.image,
+                       VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+                       gen.image,
+                       VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                       1,
+                       &blit,
+                       VK_FILTER_LINEAR);
+    }
+    barrier(0,
+            gen.mipLevels,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_ACCESS_TRANSFER_READ_BIT,
+            VK_ACCESS_SHADER_READ_BIT,
+            VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
+
+void VulkUploader::copyToImage(VkBuffer src,
+                               VkImage dst,
+                               std::span<VkBufferImageCopy const> regions,
+                               uint32_t mipLevels,
+                               uint32_t layerCount) {
+    VkCommandBuffer cmd = begin();
+    vk.transitionImageLayout(cmd, dst, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, mipLevels, layerCount);
+    uint32_t regionCount = static_cast<uint32_t>(regions.size());
+    vkCmdCopyBufferToImage(cmd, src, dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, regionCount, regions.data());
+
+    if (!usesTransferQueue()) {
+        vk.transitionImageLayout(cmd,
+                                 dst,
+                                 VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                 VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                                 mipLevels,
+                                 layerCount);
+        return;
+    }
+    // the layout transition happens as part of the ownership transfer
+    VkImageMemoryBarrier acquire{};
+    acquire.sType                           = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    acquire.srcAccessMask                   = 0;
+    acquire.dstAccessMask                   = VK_ACCESS_SHADER_READ_BIT;
+    acquire.oldLayout                       = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    acquire.newLayout                       = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    acquire.srcQueueFamilyIndex             = transferFamily;
+    acquire.dstQueueFamilyIndex             = graphicsFamily;
+    acquire.image                           = dst;
+    acquire.subresourceRange.aspectMask     = VK_IMAGE_ASPECT_COLOR_BIT;
+    acquire.subresourceRange.baseMipLevel   = 0;
+    acquire.subresourceRange.levelCount     = mipLevels;
+    acquire.subresourceRange.baseArrayLayer = 0;
+    acquire.subresourceRange.layerCount     = layerCount;
+    current.imageAcquires.push_back(acquire);
+}
+
+void VulkUploader::submit() {
+    std::lock_guard<std::mutex> lock(mutex);
+    submitLocked();
+    submitAcquires();
+    retire(false);
+}
+
+void VulkUploader::flush() {
+    std::lock_guard<std::mutex> lock(mutex);
+    submitLocked();
+    submitAcquires();
+    retire(true);
+}
+
+VkCommandBuffer VulkUploader::begin() {
+    if (recording) {
+        return current.cmd;
+    }
+    current.cmd = allocateCommandBuffer(transferPool, freeCmds);
+
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CALL(vkBeginCommandBuffer(current.cmd, &beginInfo));
+    recording = true;
+    return current.cmd;
+}
+
+std::optional<VkDeviceSize> VulkUploader::reserve(VkDeviceSize size) {
+    for (;;) {
+        if (!recording && inFlight.empty()) {
+            tail = head;  // nothing is using the ring
+        }
+        VkDeviceSize start = alignUp(head, ALIGNMENT);
+        if (start % ringSize + size > ringSize) {
+            start += ringSize - start % ringSize;  // copies can't wrap, skip to the start of the ring
+        }
+        if (start + size - tail <= ringSize) {
+            head = start + size;
+            return start % ringSize;
+        }
+        // full: wait for the oldest batch. if it's the one we're recording submitting it would
+        // mean touching a queue from whatever thread this is, so give up instead
+        if (inFlight.empty()) {
+            return std::nullopt;
+        }
+        retireOldest(true);
+    }
+}
+
+std::pair<VkBuffer, VkDeviceSize> VulkUploader::stage(std::span<void const* const> pieces, VkDeviceSize pieceSize) {
+    VkDeviceSize size = pieceSize * pieces.size();
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    char* dst;
+    std::optional<VkDeviceSize> ringOffset = size <= ringSize / 2 ? reserve(size) : std::nullopt;
+    if (!ringOffset) {
+        VulkAllocation alloc;
+        vk.createBuffer(size,
+                        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                        buffer,
+                        alloc);
+        offset = 0;
+        dst    = static_cast<char*>(alloc.mapped);
+        begin();
+        current.ownStaging.emplace_back(buffer, alloc);
+    } else {
+        buffer = ring;
+        offset = *ringOffset;
+        dst    = static_cast<char*>(ringAlloc.mapped) + offset;
+    }
+    for (size_t i = 0; i < pieces.size(); ++i) {
+        memcpy(dst + i * pieceSize, pieces[i], pieceSize);
+    }
+    return {buffer, offset};
+}
+
+void VulkUploader::submitLocked() {
+    if (!recording) {
+        return;
+    }
+    if (usesTransferQueue()) {
+        // release what we wrote to the graphics family. the acquires have to match, apart from the access masks
+        std::vector<VkBufferMemoryBarrier> bufferReleases = current.bufferAcquires;
+        std::vector<VkImageMemoryBarrier> imageReleases   = current.imageAcquires;
+        for (auto& release : bufferReleases) {
+            release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            release.dstAccessMask = 0;
+        }
+        for (auto& release : imageReleases) {
+            release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            release.dstAccessMask = 0;
+        }
+        vkCmdPipelineBarrier(current.cmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                             0,
+                             0,
+                             nullptr,
+                             static_cast<uint32_t>(bufferReleases.size()),
+                             bufferReleases.data(),
+                             static_cast<uint32_t>(imageReleases.size()),
+                             imageReleases.data());
+    } else {
+        // make the copies visible to whatever is submitted to the queue after this
+        VkMemoryBarrier barrier{};
+        barrier.sType         = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+        vkCmdPipelineBarrier(current.cmd,
+                             VK_PIPELINE_STAGE_TRANSFER_BIT,
+                             VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                             0,
+                             1,
+                             &barrier,
+                             0,
+                             nullptr,
+                             0,
+                             nullptr);
+    }
+    VK_CALL(vkEndCommandBuffer(current.cmd));
+
+    current.value = ++transferValue;
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues    = &current.value;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext                = &timelineInfo;
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.pCommandBuffers      = &current.cmd;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &transferTimeline;
+    VK_CALL(vkQueueSubmit(transferQueue, 1, &submitInfo, VK_NULL_HANDLE));
+
+    pendingBufferAcquires.insert(pendingBufferAcquires.end(), current.bufferAcquires.begin(), current.bufferAcquires.end());
+    pendingImageAcquires.insert(pendingImageAcquires.end(), current.imageAcquires.begin(), current.imageAcquires.end());
+    pendingMipGenerations.insert(pendingMipGenerations.end(), current.mipGenerations.begin(), current.mipGenerations.end());
+    current.bufferAcquires.clear();
+    current.imageAcquires.clear();
+    current.mipGenerations.clear();
+    current.ringEnd = head;
+    inFlight.push_back(std::move(current));
+    current   = {};
+    recording = false;
+}
+
+void VulkUploader::submitAcquires() {
+    if (pendingBufferAcquires.empty() && pendingImageAcquires.empty()) {
+        return;
+    }
+    VkCommandBuffer cmd = allocateCommandBuffer(graphicsPool, freeAcquireCmds);
+    VkCommandBufferBeginInfo beginInfo{};
+    beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CALL(vkBeginCommandBuffer(cmd, &beginInfo));
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+                         0,
+                         0,
+                         nullptr,
+                         static_cast<uint32_t>(pendingBufferAcquires.size()),
+                         pendingBufferAcquires.data(),
+                         static_cast<uint32_t>(pendingImageAcquires.size()),
+                         pendingImageAcquires.data());
+    for (MipGeneration const& gen : pendingMipGenerations) {
+        recordMipBlits(cmd, gen);
+    }
+    VK_CALL(vkEndCommandBuffer(cmd));
+
+    // every batch with pending acquires has been submitted, so waiting for the last one covers them
+    uint64_t waitValue             = transferValue;
+    uint64_t signalValue           = ++acquireValue;
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType                     = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount   = 1;
+    timelineInfo.pWaitSemaphoreValues      = &waitValue;
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues    = &signalValue;
+
+    VkSubmitInfo submitInfo{};
+    submitInfo.sType                = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.pNext                = &timelineInfo;
+    submitInfo.waitSemaphoreCount   = 1;
+    submitInfo.pWaitSemaphores      = &transferTimeline;
+    submitInfo.pWaitDstStageMask    = &waitStage;
+    submitInfo.commandBufferCount   = 1;
+    submitInfo.pCommandBuffers      = &cmd;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores    = &acquireTimeline;
+    VK_CALL(vkQueueSubmit(graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE));
+
+    acquiresInFlight.push_back({cmd, signalValue});
+    pendingBufferAcquires.clear();
+    pendingImageAcquires.clear();
+    pendingMipGenerations.clear();
+}
+
+void VulkUploader::retire(bool wait) {
+    uint64_t transferDone = transferValue;
+    uint64_t acquireDone  = acquireValue;
+    if (wait) {
+        waitTimeline(vk.device, transferTimeline, transferValue);
+        waitTimeline(vk.device, acquireTimeline, acquireValue);
+    } else {
+        VK_CALL(vkGetSemaphoreCounterValue(vk.device, transferTimeline, &transferDone));
+        VK_CALL(vkGetSemaphoreCounterValue(vk.device, acquireTimeline, &acquireDone));
+    }
+    while (!inFlight.empty() && inFlight.front().value <= transferDone) {
+        retireOldest(false);
+    }
+    while (!acquiresInFlight.empty() && acquiresInFlight.front().value <= acquireDone) {
+        VK_CALL(vkResetCommandBuffer(acquiresInFlight.front().cmd, 0));
+        freeAcquireCmds.push_back(acquiresInFlight.front().cmd);
+        acquiresInFlight.pop_front();
+    }
+}
+
+void VulkUploader::retireOldest(bool wait) {
+    Batch& batch = inFlight.front();
+    if (wait) {
+        waitTimeline(vk.device, transferTimeline, batch.value);
+    }
+    tail = batch.ringEnd;
+    for (auto& [buffer, alloc] : batch.ownStaging) {
+        vk.destroyBuffer(buffer, alloc);
+    }
+    VK_CALL(vkResetCommandBuffer(batch.cmd, 0));
+    freeCmds.push_back(batch.cmd);
+    inFlight.pop_front();
+}
+
+VkCommandBuffer VulkUploader::allocateCommandBuffer(VkCommandPool pool, std::vector<VkCommandBuffer>& freeList) {
+    if (!freeList.empty()) {
+        VkCommandBuffer cmd = freeList.back();
+        freeList.pop_back();
+        return cmd;
+    }
+    VkCommandBufferAllocateInfo allocInfo{};
+    allocInfo.sType              = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    allocInfo.level              = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    allocInfo.commandPool        = pool;
+    allocInfo.commandBufferCount = 1;
+    VkCommandBuffer cmd;
+    VK_CALL(vkAllocateCommandBuffers(vk.device, &allocInfo, &cmd));
+    return cmd;
+}
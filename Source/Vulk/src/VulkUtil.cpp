@@ -3,6 +3,8 @@
 // i.e. the body of this functions will be defined in this file while other uses of the header
 // will just declare the functions
 
+#include <atomic>
+
 #include "Vulk/VulkUtil.h"
 #include "Vulk/VulkMesh.h"
 
@@ -70,6 +72,17 @@ QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surfa
         i++;
     }
 
+    // prefer a transfer only family, then one that can compute but not draw
+    VkQueueFlags const unwantedFlags[] = {VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT};
+    for (VkQueueFlags unwanted : unwantedFlags) {
+        for (uint32_t family = 0; family < queueFamilyCount && !indices.transferFamily; ++family) {
+            VkQueueFlags flags = queueFamilies[family].queueFlags;
+            if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & unwanted)) {
+                indices.transferFamily = family;
+            }
+        }
+    }
+
     return indices;
 }
 
@@ -89,4 +102,9 @@ std::vector<char> readFileIntoMem(const std::string& filename) {
     file.close();
 
     return buffer;
+}
+
+uint64_t vulkUniqueId() {
+    static std::atomic<uint64_t> nextId = 1;
+    return nextId++;
 }
\ No newline at end of file